@@ -0,0 +1,614 @@
+/**
+ * @file EncryptionBench.cpp
+ * @brief Micro- and macro-benchmarks for the ciphers and the file I/O paths.
+ *
+ * Usage: encryption_bench [--reps N] [--min-time MS] [--max-size MB] [--filter TEXT]
+ *                         [--json FILE] [--dir DIR]
+ *
+ * Every benchmark first runs its operation in doubling batches until one batch lasts
+ * --min-time milliseconds (default 20), which doubles as the warmup, then times
+ * --reps repetitions of that batch (default 10; 3 for files of 256 MB and up). Each row
+ * shows the mean time per operation with its relative standard deviation across the
+ * repetitions, ns per block, cycles per byte (time-stamp counter on x86) and MB/s.
+ *
+ * Groups:
+ * - des-reference: the std::bitset reference helpers (generateRoundKeys,
+ *   initialPermutation, sBoxSubstitution, ..., encryptBlock/decryptBlock)
+ * - des, 3des, aes: key setup, single blocks and 64 KB bulk calls of the block ciphers
+ * - batch: 4 KB messages under rotating keys through encryptBatch, with the key cache
+ *   hit on every message and missed on every message
+ * - modes: whole 1 MB buffers through ECB, CBC and CTR
+ * - checksum: CRC-32C of a 64 KB container chunk, dispatched (SSE4.2 where available)
+ *   and on the slicing-by-8 tables
+ * - compress: LZ compression and decompression of a 64 KB chunk of log-like text and
+ *   of random bytes (the --compress stage)
+ * - buffers: getting a chunk buffer of the stream (1 MB) and parallel (4 MB) paths,
+ *   writing a byte to each of its pages and giving it back, from BufferPool and with
+ *   new/delete; the difference is what each file or chunk saves
+ * - file: DES ECB and AES-128 CTR file encryption from 8 B up to --max-size (default
+ *   256 MB) through each I/O backend (stream, pipeline, mmap)
+ * --filter keeps the benchmarks whose "group/name" contains TEXT.
+ *
+ * --json writes the results to FILE, one benchmark per line, so the reports of two
+ * builds can be compared with any JSON tool or a plain diff.
+ */
+
+#include "../util/algorithm/modes/ModeFile.h"
+#include "../util/algorithm/symmetric/AES/AES.h"
+#include "../util/algorithm/symmetric/AES/AESBlockCipher.h"
+#include "../util/algorithm/symmetric/DES/DES.h"
+#include "../util/algorithm/symmetric/DES/DESBlockCipher.h"
+#include "../util/algorithm/symmetric/TripleDES/TripleDESBlockCipher.h"
+#include "../util/checksum/CRC32C.h"
+#include "../util/compress/LZBlock.h"
+#include "../util/cpu/CpuFeatures.h"
+#include "../util/io/BlockStream.h"
+#include "../util/io/MappedFile.h"
+#include "../util/io/ParallelFile.h"
+#include "../util/io/PipelinedFile.h"
+#include "../util/memory/BufferPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keep the compiler from dropping a result it can prove unused
+template <class T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Make the compiler forget what it knows about `value`, so work on it is not hoisted
+template <class T>
+inline void opaque(T& value) {
+    asm volatile("" : "+r,m"(value) : : "memory");
+}
+
+uint64_t cycleCounter() {
+#ifdef BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Options {
+    int reps = 10;
+    double minTimeMs = 20;
+    uint64_t maxSizeMB = 256;
+    std::string filter;
+    std::string jsonFile;
+    std::string dir = ".";
+};
+
+struct Result {
+    std::string group;
+    std::string name;
+    size_t bytes;   // processed per operation, 0 for setup work
+    size_t blocks;  // cipher blocks per operation
+    size_t iterations;
+    int reps;
+    double meanNs;  // per operation
+    double stddevNs;
+    double minNs;
+    double cyclesPerOp;
+
+    double nsPerBlock() const {
+        return blocks ? meanNs / blocks : 0;
+    }
+    double cyclesPerByte() const {
+        return bytes ? cyclesPerOp / bytes : 0;
+    }
+    double megabytesPerSecond() const {
+        return bytes ? bytes / (meanNs * 1e-9) / (1 << 20) : 0;
+    }
+};
+
+class Bench {
+public:
+    explicit Bench(const Options& options) : options(options) {
+        std::printf("%-14s %-34s %13s %6s %11s %9s %10s\n", "group", "benchmark", "ns/op", "+/-%", "ns/block",
+                    "cyc/byte", "MB/s");
+    }
+
+    // Time `op`, which performs one operation on `bytes` bytes (`blocks` cipher blocks)
+    template <class Op>
+    void run(const std::string& group, const std::string& name, size_t bytes, size_t blocks, Op op, int reps = 0) {
+        if (!options.filter.empty() && (group + "/" + name).find(options.filter) == std::string::npos) {
+            return;
+        }
+        reps = reps > 0 ? std::min(reps, options.reps) : options.reps;
+
+        // Warm up while finding a batch size that lasts at least the minimum time
+        size_t iterations = 1;
+        while (timeBatch(op, iterations).first * 1e3 < options.minTimeMs && iterations < (size_t(1) << 40)) {
+            iterations *= 2;
+        }
+
+        std::vector<double> samples;
+        double cycles = 0;
+        for (int rep = 0; rep < reps; ++rep) {
+            std::pair<double, uint64_t> batch = timeBatch(op, iterations);
+            samples.push_back(batch.first * 1e9 / iterations);
+            cycles += static_cast<double>(batch.second) / iterations;
+        }
+
+        double mean = 0, variance = 0;
+        for (double sample : samples) {
+            mean += sample / reps;
+        }
+        for (double sample : samples) {
+            variance += (sample - mean) * (sample - mean) / reps;
+        }
+        Result result{group, name, bytes, blocks, iterations, reps, mean, std::sqrt(variance),
+                      *std::min_element(samples.begin(), samples.end()), cycles / reps};
+        print(result);
+        results.push_back(result);
+    }
+
+    bool writeJson(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) {
+            std::cerr << "Error: Could not open output file " << path << std::endl;
+            return false;
+        }
+        const CpuFeatures& cpu = cpuFeatures();
+        char line[512];
+        std::snprintf(line, sizeof(line),
+                      "{\n  \"benchmark\": \"encryption_bench\",\n  \"reps\": %d,\n  \"min_time_ms\": %.1f,\n"
+                      "  \"cpu\": {\"sse2\": %s, \"sse42\": %s, \"avx2\": %s, \"avx512f\": %s, \"aesni\": %s},\n"
+                      "  \"results\": [\n",
+                      options.reps, options.minTimeMs, cpu.sse2 ? "true" : "false", cpu.sse42 ? "true" : "false",
+                      cpu.avx2 ? "true" : "false",
+                      cpu.avx512f ? "true" : "false", cpu.aesni ? "true" : "false");
+        out << line;
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::snprintf(line, sizeof(line),
+                          "    {\"group\": \"%s\", \"name\": \"%s\", \"bytes_per_op\": %zu, \"iterations\": %zu, "
+                          "\"reps\": %d, \"ns_per_op\": %.3f, \"stddev_ns\": %.3f, \"min_ns\": %.3f, "
+                          "\"ns_per_block\": %.3f, \"cycles_per_byte\": %.3f, \"mb_per_s\": %.2f}%s\n",
+                          r.group.c_str(), r.name.c_str(), r.bytes, r.iterations, r.reps, r.meanNs, r.stddevNs,
+                          r.minNs, r.nsPerBlock(), r.cyclesPerByte(), r.megabytesPerSecond(),
+                          i + 1 < results.size() ? "," : "");
+            out << line;
+        }
+        out << "  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+private:
+    template <class Op>
+    static std::pair<double, uint64_t> timeBatch(Op& op, size_t iterations) {
+        Clock::time_point start = Clock::now();
+        uint64_t startCycles = cycleCounter();
+        for (size_t i = 0; i < iterations; ++i) {
+            op();
+        }
+        uint64_t cycles = cycleCounter() - startCycles;
+        return {std::chrono::duration<double>(Clock::now() - start).count(), cycles};
+    }
+
+    static void print(const Result& r) {
+        char perBlock[32] = "-", perByte[32] = "-", rate[32] = "-";
+        if (r.blocks) {
+            std::snprintf(perBlock, sizeof(perBlock), "%.2f", r.nsPerBlock());
+        }
+        if (r.bytes) {
+#ifdef BENCH_HAS_TSC
+            std::snprintf(perByte, sizeof(perByte), "%.2f", r.cyclesPerByte());
+#endif
+            std::snprintf(rate, sizeof(rate), "%.1f", r.megabytesPerSecond());
+        }
+        std::printf("%-14s %-34s %13.1f %6.1f %11s %9s %10s\n", r.group.c_str(), r.name.c_str(), r.meanNs,
+                    r.meanNs > 0 ? 100.0 * r.stddevNs / r.meanNs : 0.0, perBlock, perByte, rate);
+        std::fflush(stdout);
+    }
+
+    const Options& options;
+    std::vector<Result> results;
+};
+
+constexpr size_t BULK_BYTES = 64 << 10;
+constexpr size_t MODE_BYTES = 1 << 20;
+
+void fillPattern(std::vector<uint8_t>& data) {
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+}
+
+void benchDESReference(Bench& bench) {
+    std::bitset<64> key(0x133457799BBCDFF1ull);
+    std::vector<std::bitset<48>> roundKeys = generateRoundKeys(key);
+    std::bitset<64> block(0x0123456789ABCDEFull);
+    std::bitset<32> half(0x89ABCDEFu);
+    std::bitset<48> wide(0x0123456789ABull);
+    std::bitset<28> keyHalf(0x0ABCDEFu);
+
+    bench.run("des-reference", "generateRoundKeys", 0, 0, [&] {
+        opaque(key);
+        keep(generateRoundKeys(key));
+    });
+    bench.run("des-reference", "initialPermutation", 0, 0, [&] {
+        block = initialPermutation(block);
+        keep(block);
+    });
+    bench.run("des-reference", "finalPermutation", 0, 0, [&] {
+        block = finalPermutation(block);
+        keep(block);
+    });
+    bench.run("des-reference", "expansion", 0, 0, [&] {
+        opaque(half);
+        keep(expansion(half));
+    });
+    bench.run("des-reference", "xorWithKey", 0, 0, [&] {
+        wide = xorWithKey(wide, roundKeys[3]);
+        keep(wide);
+    });
+    bench.run("des-reference", "sBoxSubstitution", 0, 0, [&] {
+        opaque(wide);
+        keep(sBoxSubstitution(wide));
+    });
+    bench.run("des-reference", "pBoxPermutation", 0, 0, [&] {
+        half = pBoxPermutation(half);
+        keep(half);
+    });
+    bench.run("des-reference", "leftCircularShift", 0, 0, [&] {
+        keyHalf = leftCircularShift(keyHalf, 1);
+        keep(keyHalf);
+    });
+    std::bitset<32> left(0x01234567u), right(0x89ABCDEFu);
+    bench.run("des-reference", "desRound", 0, 0, [&] {
+        desRound(left, right, roundKeys[0]);
+        keep(right);
+    });
+    bench.run("des-reference", "encryptBlock", 8, 1, [&] {
+        block = encryptBlock(block, roundKeys);
+        keep(block);
+    });
+    bench.run("des-reference", "decryptBlock", 8, 1, [&] {
+        block = decryptBlock(block, roundKeys);
+        keep(block);
+    });
+}
+
+void benchDES(Bench& bench, std::vector<uint8_t>& data) {
+    std::vector<std::bitset<48>> roundKeys = generateRoundKeys(std::bitset<64>(0x133457799BBCDFF1ull));
+    DESBlockCipher cipher;
+    bench.run("des", "packRoundKeys", 0, 0, [&] {
+        packRoundKeys(roundKeys, cipher.schedule);
+        keep(cipher.schedule);
+    });
+    uint64_t key = 0x133457799BBCDFF1ull;
+    bench.run("des", "expandDESKey", 0, 0, [&] {
+        opaque(key);
+        expandDESKey(key, cipher.schedule);
+        keep(cipher.schedule);
+    });
+
+    uint64_t block = 0x0123456789ABCDEFull;
+    bench.run("des", "encryptBlock", 8, 1, [&] {
+        block = encryptBlock(block, cipher.schedule);
+        keep(block);
+    });
+    bench.run("des", "decryptBlock", 8, 1, [&] {
+        block = decryptBlock(block, cipher.schedule);
+        keep(block);
+    });
+    bench.run("des", "encryptBlocks 64K", BULK_BYTES, BULK_BYTES / 8,
+              [&] { cipher.encryptBlocks(data.data(), data.data(), BULK_BYTES / 8); });
+    bench.run("des", "decryptBlocks 64K", BULK_BYTES, BULK_BYTES / 8,
+              [&] { cipher.decryptBlocks(data.data(), data.data(), BULK_BYTES / 8); });
+}
+
+void benchChecksum(Bench& bench, const std::vector<uint8_t>& data) {
+    uint32_t crc = 0;
+    bench.run("checksum", std::string("crc32c 64K ") + (crc32cHardwareAccelerated() ? "sse4.2" : "tables"), BULK_BYTES, 0,
+              [&] { keep(crc = crc32c(data.data(), BULK_BYTES, crc)); });
+    bench.run("checksum", "crc32cSoftware 64K", BULK_BYTES, 0,
+              [&] { keep(crc = crc32cSoftware(data.data(), BULK_BYTES, crc)); });
+}
+
+void benchCompress(Bench& bench) {
+    std::vector<uint8_t> text;
+    uint32_t state = 1;
+    while (text.size() < BULK_BYTES) {
+        state = state * 1103515245 + 12345;
+        std::string line = "2024-10-17T12:00:" + std::to_string(state % 60) + ",host" + std::to_string(state % 17) +
+                           ",INFO,request served in " + std::to_string(state % 1000) + " ms\n";
+        text.insert(text.end(), line.begin(), line.end());
+    }
+    text.resize(BULK_BYTES);
+    std::vector<uint8_t> random(BULK_BYTES);
+    for (uint8_t& byte : random) {
+        state = state * 1103515245 + 12345;
+        byte = static_cast<uint8_t>(state >> 24);
+    }
+
+    std::vector<uint8_t> packed(lzCompressBound(BULK_BYTES));
+    std::vector<uint8_t> unpacked(BULK_BYTES);
+    for (const auto& [name, input] : {std::pair{"text", &text}, std::pair{"random", &random}}) {
+        size_t packedLength = 0;
+        bench.run("compress", std::string("lzCompress 64K ") + name, BULK_BYTES, 0,
+                  [&] { keep(packedLength = lzCompress(input->data(), BULK_BYTES, packed.data())); });
+        bench.run("compress", std::string("lzDecompress 64K ") + name, BULK_BYTES, 0,
+                  [&] { keep(lzDecompress(packed.data(), packedLength, unpacked.data(), BULK_BYTES)); });
+    }
+}
+
+void benchBuffers(Bench& bench) {
+    for (size_t size : {STREAM_CHUNK_SIZE + 16, PARALLEL_CHUNK_SIZE + 16}) {
+        std::string label = std::to_string(size >> 20) + "M";
+        bench.run("buffers", "BufferPool::acquire " + label, 0, 0, [&] {
+            PooledBuffer buffer = BufferPool::acquire(size);
+            for (size_t i = 0; i < size; i += 4096) {
+                buffer[i] = static_cast<uint8_t>(i);
+            }
+            keep(buffer[size - 1] = 1);
+        });
+        bench.run("buffers", "new/delete " + label, 0, 0, [&] {
+            std::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+            for (size_t i = 0; i < size; i += 4096) {
+                buffer[i] = static_cast<uint8_t>(i);
+            }
+            keep(buffer[size - 1] = 1);
+        });
+    }
+}
+
+void makeTripleDES(TripleDESBlockCipher& cipher) {
+    const uint64_t keys[3] = {0x0123456789ABCDEFull, 0x23456789ABCDEF01ull, 0x456789ABCDEF0123ull};
+    DESKeySchedule schedules[3];
+    for (int i = 0; i < 3; ++i) {
+        expandDESKey(keys[i], schedules[i], true);
+    }
+    buildTripleDESSchedules(schedules, cipher.encryptSchedule, cipher.decryptSchedule);
+}
+
+void benchTripleDES(Bench& bench, std::vector<uint8_t>& data) {
+    TripleDESBlockCipher cipher;
+    bench.run("3des", "key setup", 0, 0, [&] {
+        makeTripleDES(cipher);
+        keep(cipher.encryptSchedule);
+    });
+    bench.run("3des", "encryptBlock", 8, 1, [&] { cipher.encryptBlock(data.data(), data.data()); });
+    bench.run("3des", "decryptBlock", 8, 1, [&] { cipher.decryptBlock(data.data(), data.data()); });
+    bench.run("3des", "encryptBlocks 64K", BULK_BYTES, BULK_BYTES / 8,
+              [&] { cipher.encryptBlocks(data.data(), data.data(), BULK_BYTES / 8); });
+    bench.run("3des", "decryptBlocks 64K", BULK_BYTES, BULK_BYTES / 8,
+              [&] { cipher.decryptBlocks(data.data(), data.data(), BULK_BYTES / 8); });
+}
+
+void benchAES(Bench& bench, std::vector<uint8_t>& data) {
+    uint8_t key[32];
+    for (int i = 0; i < 32; ++i) {
+        key[i] = static_cast<uint8_t>(i);
+    }
+    for (size_t keyLength : {16, 32}) {
+        std::string bits = std::to_string(keyLength * 8);
+        AESBlockCipher cipher;
+        bench.run("aes", "expandAESKey " + bits, 0, 0, [&] {
+            opaque(key[0]);
+            expandAESKey(key, keyLength, cipher.schedule);
+            keep(cipher.schedule);
+        });
+        bench.run("aes", "encryptBlock " + bits, 16, 1, [&] { cipher.encryptBlock(data.data(), data.data()); });
+        bench.run("aes", "decryptBlock " + bits, 16, 1, [&] { cipher.decryptBlock(data.data(), data.data()); });
+        bench.run("aes", "encryptBlocks 64K " + bits, BULK_BYTES, BULK_BYTES / 16,
+                  [&] { cipher.encryptBlocks(data.data(), data.data(), BULK_BYTES / 16); });
+        bench.run("aes", "decryptBlocks 64K " + bits, BULK_BYTES, BULK_BYTES / 16,
+                  [&] { cipher.decryptBlocks(data.data(), data.data(), BULK_BYTES / 16); });
+    }
+}
+
+template <class Cipher>
+void benchModes(Bench& bench, const std::string& label, const Cipher& cipher, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> ciphertext, plaintext;
+    for (CipherMode mode : {CipherMode::ECB, CipherMode::CBC, CipherMode::CTR}) {
+        std::string name = label + " " + cipherModeName(mode) + " 1M";
+        size_t blocks = MODE_BYTES / Cipher::BLOCK_SIZE;
+        encryptBufferWithMode(cipher, mode, data.data(), MODE_BYTES, ciphertext);
+        bench.run("modes", name + " encrypt", MODE_BYTES, blocks,
+                  [&] { encryptBufferWithMode(cipher, mode, data.data(), MODE_BYTES, ciphertext); });
+        bench.run("modes", name + " decrypt", MODE_BYTES, blocks, [&] {
+            decryptBufferWithMode(cipher, mode, ciphertext.data(), ciphertext.size(), plaintext);
+        });
+    }
+}
+
+// Hex keys of `digits` digits, all different
+std::vector<std::string> makeKeys(size_t count, size_t digits) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; ++i) {
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(i * 0x9E3779B97F4A7C15ull));
+        std::string key;
+        while (key.size() < digits) {
+            key += hex;
+        }
+        keys.push_back(key.substr(0, digits));
+    }
+    return keys;
+}
+
+// Batches of small messages, each under the next key of a rotation. With 64 keys every
+// lookup hits the key cache; with twice the cache capacity every lookup misses.
+void benchBatch(Bench& bench, const std::string& label, CryptoAlgorithm& algorithm, size_t keyDigits,
+                size_t blockSize) {
+    constexpr size_t MESSAGES = 256;
+    constexpr size_t MESSAGE_BYTES = 4 << 10;
+    std::vector<uint8_t> plaintext(MESSAGE_BYTES, 0x42);
+    std::vector<uint8_t> ciphertext(MESSAGES * algorithm.encryptedSize(MESSAGE_BYTES));
+    std::vector<KeyedBuffer> jobs(MESSAGES);
+    for (size_t i = 0; i < MESSAGES; ++i) {
+        size_t size = algorithm.encryptedSize(MESSAGE_BYTES);
+        jobs[i].input = plaintext;
+        jobs[i].output = std::span<uint8_t>(ciphertext.data() + i * size, size);
+    }
+
+    for (size_t keyCount : {size_t(64), 2 * KEY_CACHE_CAPACITY}) {
+        std::vector<std::string> keys = makeKeys(keyCount, keyDigits);
+        size_t next = 0;
+        bench.run("batch", label + (keyCount <= KEY_CACHE_CAPACITY ? " 4K x256 cached keys" : " 4K x256 new keys"),
+                  MESSAGES * MESSAGE_BYTES, MESSAGES * MESSAGE_BYTES / blockSize, [&] {
+            for (KeyedBuffer& job : jobs) {
+                job.key = keys[next++ % keys.size()];
+            }
+            algorithm.encryptBatch(jobs);
+        });
+    }
+}
+
+// Whole-file encryption through each I/O backend, single-threaded
+template <class Cipher>
+void benchFiles(Bench& bench, const Options& options, const std::string& label, const Cipher& cipher,
+                CipherMode mode) {
+    const std::string inputFile = options.dir + "/encryption_bench.in";
+    const std::string outputFile = options.dir + "/encryption_bench.out";
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    std::vector<uint8_t> iv(B, 0x5A);
+    bool padded = ModeFile::isPadded(mode);
+
+    std::vector<uint64_t> sizes{8, 4 << 10, 1 << 20, 16 << 20};
+    for (uint64_t size = 256ull << 20; size <= options.maxSizeMB << 20; size *= 16) {
+        sizes.push_back(size);
+    }
+
+    std::vector<uint8_t> pattern(1 << 20);
+    fillPattern(pattern);
+    for (uint64_t size : sizes) {
+        if (size > std::max<uint64_t>(options.maxSizeMB << 20, 8)) {
+            continue;
+        }
+        {
+            std::ofstream input(inputFile, std::ios::binary);
+            for (uint64_t written = 0; written < size; written += pattern.size()) {
+                input.write(reinterpret_cast<const char*>(pattern.data()),
+                            static_cast<std::streamsize>(std::min<uint64_t>(pattern.size(), size - written)));
+            }
+            if (!input) {
+                std::cerr << "Error: Could not write benchmark input " << inputFile << std::endl;
+                return;
+            }
+        }
+
+        BlockModes::CBCState<Cipher> cbc;
+        ChunkTransform transform = [&](const FileChunk& chunk) {
+            ModeFile::encryptChunk(cipher, mode, iv.data(), cbc, chunk);
+        };
+        std::string sizeName = size >= (1 << 20) ? std::to_string(size >> 20) + "M"
+                               : size >= (1 << 10) ? std::to_string(size >> 10) + "K"
+                                                   : std::to_string(size) + "B";
+        std::string name = label + " " + cipherModeName(mode) + " " + sizeName;
+        size_t blocks = static_cast<size_t>((size + B - 1) / B);
+        int reps = size >= (256u << 20) ? 3 : 0;
+
+        bench.run("file", name + " stream", size, blocks,
+                  [&] { encryptFileStream(inputFile, outputFile, B, transform, iv, padded); }, reps);
+        bench.run("file", name + " pipeline", size, blocks,
+                  [&] { encryptFilePipelined(inputFile, outputFile, B, transform, iv, padded); }, reps);
+        bench.run("file", name + " mmap", size, blocks, [&] {
+            if (encryptFileMapped(inputFile, outputFile, B, nullptr, transform, iv, padded, 1) == MappedIO::NotMapped) {
+                encryptFileStream(inputFile, outputFile, B, transform, iv, padded);
+            }
+        }, reps);
+    }
+    std::remove(inputFile.c_str());
+    std::remove(outputFile.c_str());
+}
+
+bool parseArguments(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        try {
+            if (option == "--reps" && hasValue) {
+                options.reps = std::max(1, std::stoi(argv[++i]));
+            } else if (option == "--min-time" && hasValue) {
+                options.minTimeMs = std::stod(argv[++i]);
+            } else if (option == "--max-size" && hasValue) {
+                options.maxSizeMB = std::stoull(argv[++i]);
+            } else if (option == "--filter" && hasValue) {
+                options.filter = argv[++i];
+            } else if (option == "--json" && hasValue) {
+                options.jsonFile = argv[++i];
+            } else if (option == "--dir" && hasValue) {
+                options.dir = argv[++i];
+            } else {
+                std::cerr << "Error: Unknown option '" << option << "'." << std::endl;
+                std::cerr << "Usage: encryption_bench [--reps N] [--min-time MS] [--max-size MB] [--filter TEXT] "
+                             "[--json FILE] [--dir DIR]" << std::endl;
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Error: Invalid value '" << argv[i] << "' for " << option << "." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        return 1;
+    }
+
+    Bench bench(options);
+    std::vector<uint8_t> data(MODE_BYTES);
+    fillPattern(data);
+
+    benchDESReference(bench);
+    benchDES(bench, data);
+    benchTripleDES(bench, data);
+    benchAES(bench, data);
+
+    DESBlockCipher des;
+    packRoundKeys(generateRoundKeys(std::bitset<64>(0x133457799BBCDFF1ull)), des.schedule);
+    TripleDESBlockCipher tripleDES;
+    makeTripleDES(tripleDES);
+    AESBlockCipher aes;
+    uint8_t aesKey[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    expandAESKey(aesKey, sizeof(aesKey), aes.schedule);
+
+    fillPattern(data);
+    benchModes(bench, "DES", des, data);
+    benchModes(bench, "3DES", tripleDES, data);
+    benchModes(bench, "AES-128", aes, data);
+    benchChecksum(bench, data);
+    benchCompress(bench);
+    benchBuffers(bench);
+
+    DES desAlgorithm;
+    benchBatch(bench, "DES", desAlgorithm, 16, DESBlockCipher::BLOCK_SIZE);
+    AES aesAlgorithm;
+    benchBatch(bench, "AES-128", aesAlgorithm, 32, AESBlockCipher::BLOCK_SIZE);
+
+    benchFiles(bench, options, "DES", des, CipherMode::ECB);
+    benchFiles(bench, options, "AES-128", aes, CipherMode::CTR);
+
+    if (!options.jsonFile.empty()) {
+        if (!bench.writeJson(options.jsonFile)) {
+            return 1;
+        }
+        std::cout << "JSON report written to " << options.jsonFile << std::endl;
+    }
+    return 0;
+}
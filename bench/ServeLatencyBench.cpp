@@ -0,0 +1,279 @@
+/**
+ * @file ServeLatencyBench.cpp
+ * @brief Per-job latency of the --serve daemon against starting encryption_tool per job.
+ *
+ * Usage: serve_latency_bench [--requests N] [--clients C] [--keys K] [--sizes LIST]
+ *                            [--spawn N] [--tool PATH]
+ *
+ * Starts a JobServer in this process on a temporary socket and sends it AES-128 CTR jobs
+ * through JobClient, C connections at a time (default 1), each on its own thread. Each
+ * job uses one of K keys (default 16) in turn, so the key cache is exercised the way a
+ * service with a handful of tenants would. Rows:
+ * - memory: in-memory jobs of every size in LIST (bytes, default 64,1024,16384,262144)
+ * - paths:  a 4 KB file job, opened by the server by name
+ * - fds:    the same file job with the open files passed as SCM_RIGHTS
+ * - spawn:  the same file job, starting encryption_tool (--tool, default ./encryption_tool)
+ *           for every job as a script would; N runs (default 200, 0 to skip)
+ * Each row prints the p50, p90, p99 and p99.9 latency and the maximum in microseconds,
+ * and jobs per second over all connections. N (default 20000) is the total per row; a
+ * tenth as many jobs are sent first to warm up and are not counted.
+ */
+
+#include "../util/server/JobClient.h"
+#include "../util/server/JobServer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+struct Options {
+    size_t requests = 20000;
+    size_t clients = 1;
+    size_t keys = 16;
+    std::vector<size_t> sizes = {64, 1024, 16384, 262144};
+    size_t spawnRuns = 200;
+    std::string tool = "./encryption_tool";
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Job number `index` on `client`, the connection numbered `connection`; false if it failed
+using Job = std::function<bool(JobClient& client, size_t connection, size_t index)>;
+
+void report(const char* name, size_t size, std::vector<double>& micros, double seconds) {
+    if (micros.empty()) {
+        return;
+    }
+    std::sort(micros.begin(), micros.end());
+    auto at = [&](double fraction) { return micros[std::min(micros.size() - 1, static_cast<size_t>(fraction * micros.size()))]; };
+    std::printf("%-8s %9zu %10.1f %10.1f %10.1f %10.1f %10.1f %12.0f\n", name, size, at(0.50), at(0.90), at(0.99),
+                at(0.999), micros.back(), micros.size() / seconds);
+}
+
+// Run `requests` jobs spread over `clients` connections and report their latencies
+bool measure(const char* name, size_t size, const std::string& socketPath, const Options& options, const Job& job) {
+    std::vector<std::vector<double>> perClient(options.clients);
+    std::vector<int> failed(options.clients, 0);
+    size_t perConnection = std::max<size_t>(1, options.requests / options.clients);
+    size_t warmup = std::max<size_t>(1, perConnection / 10);
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < options.clients; ++c) {
+        threads.emplace_back([&, c] {
+            JobClient client;
+            if (!client.connect(socketPath)) {
+                std::fprintf(stderr, "%s\n", client.error().c_str());
+                failed[c] = 1;
+                return;
+            }
+            perClient[c].reserve(perConnection);
+            for (size_t i = 0; i < warmup + perConnection; ++i) {
+                auto begin = Clock::now();
+                if (!job(client, c, i)) {
+                    std::fprintf(stderr, "%s\n", client.error().c_str());
+                    failed[c] = 1;
+                    return;
+                }
+                if (i >= warmup) {
+                    perClient[c].push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::vector<double> micros;
+    for (size_t c = 0; c < options.clients; ++c) {
+        if (failed[c]) {
+            return false;
+        }
+        micros.insert(micros.end(), perClient[c].begin(), perClient[c].end());
+    }
+    report(name, size, micros, elapsed.count());
+    return true;
+}
+
+// Start encryption_tool for every job, as a shell script calling it would
+void measureSpawn(const Options& options, const std::vector<std::string>& keys, const std::string& inputFile,
+                  const std::string& outputFile) {
+    if (options.spawnRuns == 0 || access(options.tool.c_str(), X_OK) != 0) {
+        std::printf("%-8s %9s (skipped: %s is not an executable)\n", "spawn", "", options.tool.c_str());
+        return;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+
+    std::vector<double> micros;
+    auto start = Clock::now();
+    for (size_t i = 0; i < options.spawnRuns; ++i) {
+        std::vector<std::string> arguments = {options.tool, "--encrypt", "AES", keys[i % keys.size()], inputFile,
+                                              outputFile, "--mode", "CTR"};
+        std::vector<char*> argv;
+        for (std::string& argument : arguments) {
+            argv.push_back(argument.data());
+        }
+        argv.push_back(nullptr);
+
+        auto begin = Clock::now();
+        pid_t child;
+        int status = 0;
+        if (posix_spawn(&child, options.tool.c_str(), &actions, nullptr, argv.data(), environ) != 0 ||
+            waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::fprintf(stderr, "Error: Running %s failed.\n", options.tool.c_str());
+            break;
+        }
+        micros.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    posix_spawn_file_actions_destroy(&actions);
+    report("spawn", 4096, micros, elapsed.count());
+}
+
+bool parseArguments(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        try {
+            if (option == "--requests" && hasValue) {
+                options.requests = std::max<size_t>(1, std::stoull(argv[++i]));
+            } else if (option == "--clients" && hasValue) {
+                options.clients = std::max<size_t>(1, std::stoull(argv[++i]));
+            } else if (option == "--keys" && hasValue) {
+                options.keys = std::max<size_t>(1, std::stoull(argv[++i]));
+            } else if (option == "--spawn" && hasValue) {
+                options.spawnRuns = std::stoull(argv[++i]);
+            } else if (option == "--tool" && hasValue) {
+                options.tool = argv[++i];
+            } else if (option == "--sizes" && hasValue) {
+                options.sizes.clear();
+                std::string list = argv[++i];
+                for (size_t begin = 0; begin <= list.size();) {
+                    size_t end = std::min(list.find(',', begin), list.size());
+                    options.sizes.push_back(std::stoull(list.substr(begin, end - begin)));
+                    begin = end + 1;
+                }
+            } else {
+                std::cerr << "Usage: serve_latency_bench [--requests N] [--clients C] [--keys K] [--sizes LIST] "
+                             "[--spawn N] [--tool PATH]" << std::endl;
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Error: Invalid value '" << argv[i] << "' for " << option << "." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        return 1;
+    }
+    std::string socketPath = "/tmp/serve_latency_bench." + std::to_string(getpid()) + ".sock";
+    const std::string inputFile = "serve_latency_bench.in";
+    const std::string outputFile = "serve_latency_bench.out";
+
+    std::vector<std::string> keys;
+    for (size_t k = 0; k < options.keys; ++k) {
+        char key[33];
+        std::snprintf(key, sizeof(key), "%016zx%016zx", static_cast<size_t>(k * 0x9E3779B97F4A7C15ull), k + 1);
+        keys.push_back(key);
+    }
+    {
+        std::vector<char> data(4096);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<char>(i * 131 + 7);
+        }
+        std::ofstream input(inputFile, std::ios::binary);
+        input.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    JobServer server(options.clients);
+    if (!server.listen(socketPath)) {
+        return 1;
+    }
+    std::thread serving([&] { server.run(); });
+
+    std::printf("AES-128 CTR jobs over %s, %zu connection(s), %zu key(s), %zu jobs per row\n", socketPath.c_str(),
+                options.clients, options.keys, options.requests);
+    std::printf("%-8s %9s %10s %10s %10s %10s %10s %12s\n", "row", "bytes", "p50 us", "p90 us", "p99 us", "p99.9 us",
+                "max us", "jobs/s");
+
+    bool ok = true;
+    for (size_t size : options.sizes) {
+        std::vector<uint8_t> payload(size);
+        for (size_t i = 0; i < size; ++i) {
+            payload[i] = static_cast<uint8_t>(i * 131 + 7);
+        }
+        ok = ok && measure("memory", size, socketPath, options, [&](JobClient& client, size_t, size_t index) {
+            thread_local std::vector<uint8_t> output;
+            JobSpec spec{JobOperation::Encrypt, ContainerCipher::AES, CipherMode::CTR, keys[index % keys.size()]};
+            return client.run(spec, payload, output);
+        });
+    }
+
+    // One output file per connection, so concurrent jobs do not write the same file
+    auto outputFor = [&](size_t connection) { return outputFile + "." + std::to_string(connection); };
+    ok = ok && measure("paths", 4096, socketPath, options, [&](JobClient& client, size_t connection, size_t index) {
+        JobSpec spec{JobOperation::Encrypt, ContainerCipher::AES, CipherMode::CTR, keys[index % keys.size()]};
+        return client.runFiles(spec, inputFile, outputFor(connection));
+    });
+    ok = ok && measure("fds", 4096, socketPath, options, [&](JobClient& client, size_t connection, size_t index) {
+        JobSpec spec{JobOperation::Encrypt, ContainerCipher::AES, CipherMode::CTR, keys[index % keys.size()]};
+        int input = open(inputFile.c_str(), O_RDONLY | O_CLOEXEC);
+        int output = open(outputFor(connection).c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        bool done = input >= 0 && output >= 0 && client.runDescriptors(spec, input, output);
+        for (int fd : {input, output}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        return done;
+    });
+
+    server.stop();
+    serving.join();
+    if (ok) {
+        measureSpawn(options, keys, inputFile, outputFile + ".spawn");
+    }
+
+    std::remove(inputFile.c_str());
+    std::remove((outputFile + ".spawn").c_str());
+    for (size_t c = 0; c < options.clients; ++c) {
+        std::remove((outputFile + "." + std::to_string(c)).c_str());
+    }
+    return ok ? 0 : 1;
+}
+
+#else
+
+int main() {
+    std::cerr << "Error: serve_latency_bench needs Unix domain sockets, which this platform lacks." << std::endl;
+    return 1;
+}
+
+#endif
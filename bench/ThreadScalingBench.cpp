@@ -0,0 +1,109 @@
+/**
+ * @file ThreadScalingBench.cpp
+ * @brief Measures how chunk-parallel DES (ECB) encryption scales with the thread count.
+ *
+ * Usage: thread_scaling_bench [size_in_MB] [max_threads]
+ *
+ * For 1, 2, 4, ... up to max_threads (default: all hardware threads) it reports
+ * - memory: encrypting an in-memory buffer chunk by chunk on the ThreadPool (CPU bound)
+ * - file:   encryptFileParallel on a temporary file (adds pread/pwrite)
+ * as MB/s, speedup over one thread and parallel efficiency. Best of three runs.
+ */
+
+#include "../util/algorithm/symmetric/DES/DESBitslice.h"
+#include "../util/algorithm/symmetric/DES/DESCore.h"
+#include "../util/io/ParallelFile.h"
+#include "../util/thread/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void encryptChunk(uint8_t* data, size_t length, const DESKeySchedule& schedule) {
+    size_t blockCount = length / 8;
+    size_t done = bitsliceEncryptBlocks(data, data, blockCount, schedule);
+    encryptBlocks(data + done * 8, data + done * 8, blockCount - done, schedule);
+}
+
+template <class Body>
+double bestSeconds(Body body) {
+    double best = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t sizeMB = argc > 1 ? std::stoul(argv[1]) : 256;
+    size_t maxThreads = argc > 2 ? std::stoul(argv[2]) : ThreadPool::hardwareThreads();
+    size_t size = sizeMB << 20;
+
+    DESKeySchedule schedule;
+    packRoundKeys(std::vector<std::bitset<48>>(16, std::bitset<48>(0x0F1E2D3C4B5Aull)), schedule);
+
+    std::vector<uint8_t> buffer(size);
+    for (size_t i = 0; i < size; ++i) {
+        buffer[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+
+    const std::string inputFile = "thread_scaling_bench.in";
+    const std::string outputFile = "thread_scaling_bench.out";
+    {
+        std::ofstream input(inputFile, std::ios::binary);
+        input.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(size));
+    }
+
+    std::printf("DES ECB thread scaling, %zu MB\n", sizeMB);
+    std::printf("%8s %14s %9s %7s %14s %9s %7s\n", "threads", "memory MB/s", "speedup", "eff", "file MB/s",
+                "speedup", "eff");
+
+    // 1, 2, 4, ... and finally maxThreads itself
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    double baseMemory = 0, baseFile = 0;
+    for (size_t threads : threadCounts) {
+        ThreadPool pool(threads - 1);
+        size_t chunks = (size + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+
+        double memorySeconds = bestSeconds([&] {
+            pool.parallelFor(chunks, [&](size_t i) {
+                size_t offset = i * PARALLEL_CHUNK_SIZE;
+                encryptChunk(buffer.data() + offset, std::min(PARALLEL_CHUNK_SIZE, size - offset), schedule);
+            });
+        });
+        double fileSeconds = bestSeconds([&] {
+            encryptFileParallel(inputFile, outputFile, 8, pool, [&schedule](const FileChunk& chunk) {
+                encryptChunk(chunk.data, chunk.length, schedule);
+            });
+        });
+
+        double memoryRate = sizeMB / memorySeconds;
+        double fileRate = sizeMB / fileSeconds;
+        if (threads == 1) {
+            baseMemory = memoryRate;
+            baseFile = fileRate;
+        }
+        std::printf("%8zu %14.1f %8.2fx %6.0f%% %14.1f %8.2fx %6.0f%%\n", threads, memoryRate, memoryRate / baseMemory,
+                    100.0 * memoryRate / baseMemory / threads, fileRate, fileRate / baseFile,
+                    100.0 * fileRate / baseFile / threads);
+    }
+
+    std::remove(inputFile.c_str());
+    std::remove(outputFile.c_str());
+    return 0;
+}
@@ -7,30 +7,95 @@ set "SCRIPT_DIR=%~dp0"
 rem Change to the script directory
 cd /d "%SCRIPT_DIR%"
 
-rem Set the output executable name
+rem Set the output executable names
 set OUTPUT=encryption_tool.exe
+set BENCH_OUTPUT=thread_scaling_bench.exe
+set TRIPLE_DES_BENCH_OUTPUT=triple_des_bench.exe
+set ENCRYPTION_BENCH_OUTPUT=encryption_bench.exe
+set SERVE_BENCH_OUTPUT=serve_latency_bench.exe
 
-rem Delete the previous build if it exists
+rem Delete the previous builds if they exist
 if exist %OUTPUT% (
     del %OUTPUT%
 )
+if exist %BENCH_OUTPUT% (
+    del %BENCH_OUTPUT%
+)
+if exist %TRIPLE_DES_BENCH_OUTPUT% (
+    del %TRIPLE_DES_BENCH_OUTPUT%
+)
+if exist %ENCRYPTION_BENCH_OUTPUT% (
+    del %ENCRYPTION_BENCH_OUTPUT%
+)
+if exist %SERVE_BENCH_OUTPUT% (
+    del %SERVE_BENCH_OUTPUT%
+)
 
-rem Initialize an empty variable to hold all source files
+rem Initialize empty variables to hold the source files
 set "SRC_FILES="
+set "LIB_FILES="
 
-rem Recursively find all .cpp files in the current directory and all subdirectories
+rem Recursively find all .cpp files in the current directory and all subdirectories,
+rem except the benchmarks; the benchmarks link against everything but main.cpp
 for /R %%f in (*.cpp) do (
-    set "SRC_FILES=!SRC_FILES! %%f"
+    set "FILE=%%f"
+    if "!FILE:\bench\=!"=="!FILE!" (
+        set "SRC_FILES=!SRC_FILES! %%f"
+        if /I not "%%~nxf"=="main.cpp" (
+            set "LIB_FILES=!LIB_FILES! %%f"
+        )
+    )
 )
 
 rem Compile all found .cpp files
-g++ -std=c++20 %SRC_FILES% -o %OUTPUT%
+g++ -std=c++20 -O2 -pthread %SRC_FILES% -o %OUTPUT%
 
 rem Check if the compilation was successful
 if %errorlevel% neq 0 (
     echo Build failed.
+    exit /b 1
 ) else (
     echo Build successful! Run with %OUTPUT% [encrypt/decrypt] [input_file] [output_file]
 )
 
-endlocal
\ No newline at end of file
+rem Compile the thread scaling benchmark
+g++ -std=c++20 -O2 -pthread bench\ThreadScalingBench.cpp %LIB_FILES% -o %BENCH_OUTPUT%
+
+if %errorlevel% neq 0 (
+    echo Benchmark build failed.
+    exit /b 1
+) else (
+    echo Benchmark built! Run with %BENCH_OUTPUT% [size_in_MB] [max_threads]
+)
+
+rem Compile the 3DES benchmark
+g++ -std=c++20 -O2 -pthread bench\TripleDESBench.cpp %LIB_FILES% -o %TRIPLE_DES_BENCH_OUTPUT%
+
+if %errorlevel% neq 0 (
+    echo 3DES benchmark build failed.
+    exit /b 1
+) else (
+    echo 3DES benchmark built! Run with %TRIPLE_DES_BENCH_OUTPUT% [size_in_MB]
+)
+
+rem Compile the cipher and file I/O benchmark
+g++ -std=c++20 -O2 -pthread bench\EncryptionBench.cpp %LIB_FILES% -o %ENCRYPTION_BENCH_OUTPUT%
+
+if %errorlevel% neq 0 (
+    echo Encryption benchmark build failed.
+    exit /b 1
+) else (
+    echo Encryption benchmark built! Run with %ENCRYPTION_BENCH_OUTPUT% [--reps N] [--min-time MS] [--max-size MB] [--filter TEXT] [--json FILE] [--dir DIR]
+)
+
+rem Compile the --serve latency benchmark
+g++ -std=c++20 -O2 -pthread bench\ServeLatencyBench.cpp %LIB_FILES% -o %SERVE_BENCH_OUTPUT%
+
+if %errorlevel% neq 0 (
+    echo Serve latency benchmark build failed.
+    exit /b 1
+) else (
+    echo Serve latency benchmark built! Run with %SERVE_BENCH_OUTPUT% [--requests N] [--clients C] [--keys K] [--sizes LIST] [--spawn N] [--tool PATH]
+)
+
+endlocal
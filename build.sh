@@ -6,23 +6,73 @@ SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
 # Change to the script directory
 cd "$SCRIPT_DIR"
 
-# Set the output executable name
+# Set the output executable names
 OUTPUT="encryption_tool"
+BENCH_OUTPUT="thread_scaling_bench"
+TRIPLE_DES_BENCH_OUTPUT="triple_des_bench"
+ENCRYPTION_BENCH_OUTPUT="encryption_bench"
+SERVE_BENCH_OUTPUT="serve_latency_bench"
 
-# Delete the previous build if it exists
-if [ -f "$OUTPUT" ]; then
-    rm "$OUTPUT"
-fi
+# Delete the previous builds if they exist
+for EXE in "$OUTPUT" "$BENCH_OUTPUT" "$TRIPLE_DES_BENCH_OUTPUT" "$ENCRYPTION_BENCH_OUTPUT" "$SERVE_BENCH_OUTPUT"; do
+    if [ -f "$EXE" ]; then
+        rm "$EXE"
+    fi
+done
+
+# Find all .cpp files in the current directory and all subdirectories, except the benchmarks
+SRC_FILES=$(find . -name "*.cpp" -not -path "./bench/*")
 
-# Find all .cpp files in the current directory and all subdirectories
-SRC_FILES=$(find . -name "*.cpp")
+# The benchmarks link against everything but main.cpp
+LIB_FILES=$(find . -name "*.cpp" -not -path "./bench/*" -not -path "./main.cpp")
 
 # Compile all found .cpp files
-g++ -std=c++20 $SRC_FILES -o $OUTPUT
+g++ -std=c++20 -O2 -pthread $SRC_FILES -o $OUTPUT
 
 # Check if the compilation was successful
 if [ $? -ne 0 ]; then
     echo "Build failed."
+    exit 1
 else
     echo "Build successful! Run with ./$OUTPUT --[encrypt/decrypt] [encryption_type] [encryption_key] [input_file] [output_file]"
 fi
+
+# Compile the thread scaling benchmark
+g++ -std=c++20 -O2 -pthread bench/ThreadScalingBench.cpp $LIB_FILES -o $BENCH_OUTPUT
+
+if [ $? -ne 0 ]; then
+    echo "Benchmark build failed."
+    exit 1
+else
+    echo "Benchmark built! Run with ./$BENCH_OUTPUT [size_in_MB] [max_threads]"
+fi
+
+# Compile the 3DES benchmark
+g++ -std=c++20 -O2 -pthread bench/TripleDESBench.cpp $LIB_FILES -o $TRIPLE_DES_BENCH_OUTPUT
+
+if [ $? -ne 0 ]; then
+    echo "3DES benchmark build failed."
+    exit 1
+else
+    echo "3DES benchmark built! Run with ./$TRIPLE_DES_BENCH_OUTPUT [size_in_MB]"
+fi
+
+# Compile the cipher and file I/O benchmark
+g++ -std=c++20 -O2 -pthread bench/EncryptionBench.cpp $LIB_FILES -o $ENCRYPTION_BENCH_OUTPUT
+
+if [ $? -ne 0 ]; then
+    echo "Encryption benchmark build failed."
+    exit 1
+else
+    echo "Encryption benchmark built! Run with ./$ENCRYPTION_BENCH_OUTPUT [--reps N] [--min-time MS] [--max-size MB] [--filter TEXT] [--json FILE] [--dir DIR]"
+fi
+
+# Compile the --serve latency benchmark
+g++ -std=c++20 -O2 -pthread bench/ServeLatencyBench.cpp $LIB_FILES -o $SERVE_BENCH_OUTPUT
+
+if [ $? -ne 0 ]; then
+    echo "Serve latency benchmark build failed."
+    exit 1
+else
+    echo "Serve latency benchmark built! Run with ./$SERVE_BENCH_OUTPUT [--requests N] [--clients C] [--keys K] [--sizes LIST] [--spawn N] [--tool PATH]"
+fi
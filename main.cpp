@@ -3,45 +3,312 @@
 #include <unordered_map>
 #include <memory>
 #include <functional>
+#include <filesystem>
+#include <system_error>
 #include "util/help/Help.h"
 #include "util/algorithm/CryptoAlgorithm.h"
+#include "util/algorithm/modes/CipherMode.h"
+#include "util/io/BlockStream.h"
+#include "util/io/ContainerFormat.h"
+#include "util/io/ContainerVerify.h"
+#include "util/io/IOBackend.h"
+#include "util/io/StandardStream.h"
+#include "util/algorithm/symmetric/AES/AES.h"
 #include "util/algorithm/symmetric/DES/DES.h"
+#include "util/algorithm/symmetric/TripleDES/TripleDES.h"
+#include "util/stats/PerfCounters.h"
+#include "util/server/JobServer.h"
+#include "util/stats/Stats.h"
+#include "util/thread/ThreadPool.h"
 
-// Function to process encryption or decryption
-void processFile(const std::string& action, const std::string& algorithm, const std::string& key, const std::string& inputFile, const std::string& outputFile) {
+// Optional settings that may follow the positional arguments
+struct ProcessOptions {
+    size_t threads = 1;  // --threads N, 0 means one per hardware thread
+    size_t processes = 1;  // --processes N, 0 means one per hardware thread
+    CipherMode mode = CipherMode::ECB;  // --mode ECB|CBC|CTR
+    IOBackend io = IOBackend::Auto;  // --io auto|mmap|pipeline|stream
+    bool recursive = false;  // --recursive: input and output are directories
+    bool container = false;  // --container, or implied by --range and --compress
+    bool compress = false;  // --compress
+    ByteRange range;  // --range OFFSET:LENGTH
+    bool stats = false;  // --stats, or implied by --perf
+    bool perf = false;  // --perf: hardware counters in the --stats report
+    bool inPlace = false;  // --in-place, or implied by --rollback
+    bool rollback = false;  // --rollback: undo an interrupted --in-place job
+};
 
-    // Map of available encryption algorithms
-    std::unordered_map<std::string, std::unique_ptr<CryptoAlgorithm>> algorithms;
-    algorithms.emplace("DES", std::make_unique<DES>());  // Use emplace to move unique_ptr
+// Bytes in a file, or in all the files under a directory; 0 if it cannot be read
+uint64_t pathBytes(const std::string& path) {
+    std::error_code error;
+    if (!std::filesystem::is_directory(path, error)) {
+        uint64_t size = std::filesystem::file_size(path, error);
+        return error ? 0 : size;
+    }
+    uint64_t total = 0;
+    for (std::filesystem::recursive_directory_iterator it(path, error), end; !error && it != end; it.increment(error)) {
+        if (it->is_regular_file(error)) {
+            total += it->file_size(error);
+        }
+    }
+    return total;
+}
+
+// While the job's output goes to standard output, std::cout (progress messages and the
+// --stats report) is sent to standard error so it cannot end up in the data
+struct StandardOutputGuard {
+    std::streambuf* saved = nullptr;
+
+    explicit StandardOutputGuard(bool active) {
+        if (active) {
+            saved = std::cout.rdbuf(std::cerr.rdbuf());
+        }
+    }
+
+    ~StandardOutputGuard() {
+        if (saved) {
+            std::cout.rdbuf(saved);
+        }
+    }
+};
+
+// Function to process encryption or decryption. Returns false (after printing the error)
+// if the options are invalid or the job failed.
+bool processFile(const std::string& action, const std::string& algorithm, const std::string& key, const std::string& inputFile, const std::string& outputFile, const ProcessOptions& options) {
+
+    // Factories for the available encryption algorithms; only the chosen one is created
+    static const std::unordered_map<std::string, std::function<std::unique_ptr<CryptoAlgorithm>()>> factories = {
+        {"DES", [] { return std::make_unique<DES>(); }},
+        {"3DES", [] { return std::make_unique<TripleDES>(); }},
+        {"AES", [] { return std::make_unique<AES>(); }},
+    };
 
     // Check if the algorithm exists
-    auto it = algorithms.find(algorithm);
-    if (it == algorithms.end()) {
+    auto factory = factories.find(algorithm);
+    if (factory == factories.end()) {
         std::cerr << "Error: Unknown encryption algorithm '" << algorithm << "'." << std::endl;
-        return;
+        return false;
+    }
+    if (options.container && options.recursive) {
+        std::cerr << "Error: --container, --range and --compress apply to single files, not --recursive." << std::endl;
+        return false;
+    }
+    if ((isStandardStream(inputFile) || isStandardStream(outputFile)) && (options.recursive || options.container)) {
+        std::cerr << "Error: '-' (standard input or output) cannot be used with --recursive or containers." << std::endl;
+        return false;
+    }
+    if (options.inPlace && (options.recursive || options.container || isStandardStream(inputFile))) {
+        std::cerr << "Error: --in-place rewrites a single regular file; it cannot be combined with --recursive, containers or '-'." << std::endl;
+        return false;
+    }
+    std::error_code sameFileError;
+    if (options.inPlace && inputFile != outputFile && !std::filesystem::equivalent(inputFile, outputFile, sameFileError)) {
+        std::cerr << "Error: --in-place rewrites <input_file>; give the same file as <output_file>." << std::endl;
+        return false;
+    }
+    // Every other backend opens (and truncates) the output before it has read the input
+    if (!options.inPlace && !options.recursive && !isStandardStream(inputFile) && !isStandardStream(outputFile) &&
+        !checkDistinctFiles(inputFile, outputFile)) {
+        return false;
+    }
+    if (options.processes != 1 && (options.threads != 1 || options.io != IOBackend::Auto || options.recursive ||
+                                   options.container || options.inPlace || isStandardStream(inputFile) ||
+                                   isStandardStream(outputFile))) {
+        std::cerr << "Error: --processes shards a single regular file with its own I/O; it cannot be combined with --threads, --io, --recursive, containers, --in-place or '-'." << std::endl;
+        return false;
+    }
+    if (action == "--encrypt" && (options.range.offset != 0 || options.range.length != UINT64_MAX)) {
+        std::cerr << "Error: --range only applies to --decrypt." << std::endl;
+        return false;
+    }
+    if (action == "--decrypt" && options.compress) {
+        std::cerr << "Error: --compress only applies to --encrypt; decryption finds compressed chunks on its own." << std::endl;
+        return false;
     }
+    StandardOutputGuard guard(isStandardStream(outputFile));
 
-    // Set the encryption key for the chosen algorithm
-    it->second->setKey(key);
+    // Stats are switched on before any work so the key schedule is timed as well
+    PerfCounters perf;
+    if (options.stats) {
+        Stats::enable();
+    }
+    if (options.perf) {
+        perf.start();
+    }
+    // Taken before the job, which may rewrite the input (--in-place)
+    uint64_t bytesIn = options.stats && !isStandardStream(inputFile) ? pathBytes(inputFile) : 0;
+    uint64_t start = Stats::now();
+
+    std::unique_ptr<CryptoAlgorithm> crypto = factory->second();
+
+    // Set the encryption key, thread count, mode and I/O backend for the chosen algorithm
+    crypto->setKey(key);
+    crypto->setThreads(options.threads == 0 ? ThreadPool::hardwareThreads() : options.threads);
+    crypto->setProcesses(options.processes == 0 ? ThreadPool::hardwareThreads() : options.processes);
+    crypto->setMode(options.mode);
+    crypto->setIOBackend(options.io);
+    crypto->setContainer(options.container);
+    crypto->setRange(options.range);
+    crypto->setCompress(options.compress);
+    crypto->setInPlace(options.inPlace);
 
     // Call the appropriate method based on the action
-    if (action == "--encrypt") {
-        it->second->encrypt(inputFile, outputFile);  // Encrypt the input file
-        std::cout << "Encrypted file saved to: " << outputFile << std::endl;
+    bool ok = false;
+    if (options.rollback) {
+        ok = crypto->rollbackInPlace(inputFile);  // Either action: the journal says what to undo
+    } else if (options.recursive && action == "--encrypt") {
+        ok = crypto->encryptDirectory(inputFile, outputFile);  // Encrypt the whole input tree
+    } else if (options.recursive && action == "--decrypt") {
+        ok = crypto->decryptDirectory(inputFile, outputFile);  // Decrypt the whole input tree
+    } else if (action == "--encrypt") {
+        ok = crypto->encrypt(inputFile, outputFile);  // Encrypt the input file
+        if (ok) {
+            std::cout << "Encrypted file saved to: " << outputFile << std::endl;
+        }
     } else if (action == "--decrypt") {
-        it->second->decrypt(inputFile, outputFile);  // Decrypt the input file
-        std::cout << "Decrypted file saved to: " << outputFile << std::endl;
+        ok = crypto->decrypt(inputFile, outputFile);  // Decrypt the input file
+        if (ok) {
+            std::cout << "Decrypted file saved to: " << outputFile << std::endl;
+        }
     } else {
         std::cerr << "Error: Unknown action '" << action << "'." << std::endl;
+        return false;
+    }
+    if (!ok) {
+        return false;
+    }
+
+    // The job's thread pools and worker processes are gone by now, so their counts have
+    // reached the totals
+    if (options.stats) {
+        JobSummary job;
+        job.wallNanoseconds = Stats::now() - start;
+        job.operation = action.substr(2);
+        job.algorithm = algorithm;
+        job.mode = cipherModeName(options.mode);
+        job.io = ioBackendName(options.io);
+        job.threads = options.threads == 0 ? ThreadPool::hardwareThreads() : options.threads;
+        job.processes = options.processes == 0 ? ThreadPool::hardwareThreads() : options.processes;
+        job.bytesIn = isStandardStream(inputFile) ? Stats::stageBytes(Stage::Read) : bytesIn;
+        job.bytesOut = isStandardStream(outputFile) ? Stats::stageBytes(Stage::Write) : pathBytes(outputFile);
+        job.perfRequested = options.perf;
+        job.perf = perf.stop();
+        writeStatsJson(std::cout, job);
+    }
+    return true;
+}
+
+// Check a container's checksums without the key; true if every chunk is intact
+bool verifyFile(const std::string& inputFile, const ProcessOptions& options) {
+    if (options.mode != CipherMode::ECB || options.io != IOBackend::Auto || options.recursive || options.container ||
+        options.compress || options.stats || options.inPlace || options.processes != 1) {
+        std::cerr << "Error: --verify only takes --threads." << std::endl;
+        return false;
+    }
+    size_t threads = options.threads == 0 ? ThreadPool::hardwareThreads() : options.threads;
+    VerifyResult result;
+    if (!verifyContainer(inputFile, threads, result)) {
+        if (result.damaged != 0) {
+            std::cerr << "Error: " << result.damaged << " of " << result.chunks << " chunks are corrupted." << std::endl;
+        }
+        return false;
+    }
+    double megabytes = result.bytes / 1e6;
+    std::cout << "Verified " << result.chunks << " chunks (" << result.bytes << " bytes) in " << result.seconds << " s ("
+              << (result.seconds > 0 ? megabytes / result.seconds : 0) << " MB/s): all checksums match." << std::endl;
+    return true;
+}
+
+// Function to parse the options following the positional arguments
+bool parseOptions(int argc, char* argv[], int first, ProcessOptions& options) {
+    for (int i = first; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc) {
+            try {
+                options.threads = std::stoul(argv[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid thread count '" << argv[i] << "'." << std::endl;
+                return false;
+            }
+        } else if (option == "--processes" && i + 1 < argc) {
+            try {
+                options.processes = std::stoul(argv[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid process count '" << argv[i] << "'." << std::endl;
+                return false;
+            }
+        } else if (option == "--mode" && i + 1 < argc) {
+            if (!parseCipherMode(argv[++i], options.mode)) {
+                std::cerr << "Error: Unknown mode '" << argv[i] << "' (expected ECB, CBC or CTR)." << std::endl;
+                return false;
+            }
+        } else if (option == "--recursive") {
+            options.recursive = true;
+        } else if (option == "--container") {
+            options.container = true;
+        } else if (option == "--stats") {
+            options.stats = true;
+        } else if (option == "--perf") {
+            options.stats = true;
+            options.perf = true;
+        } else if (option == "--in-place") {
+            options.inPlace = true;
+        } else if (option == "--rollback") {
+            options.inPlace = true;
+            options.rollback = true;
+        } else if (option == "--compress") {
+            options.compress = true;
+            options.container = true;
+        } else if (option == "--range" && i + 1 < argc) {
+            if (!parseByteRange(argv[++i], options.range)) {
+                std::cerr << "Error: Invalid range '" << argv[i] << "' (expected OFFSET:LENGTH in bytes)." << std::endl;
+                return false;
+            }
+            options.container = true;
+        } else if (option == "--io" && i + 1 < argc) {
+            if (!parseIOBackend(argv[++i], options.io)) {
+                std::cerr << "Error: Unknown I/O backend '" << argv[i] << "' (expected auto, mmap, pipeline or stream)." << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Error: Unknown option '" << option << "'." << std::endl;
+            std::cerr << "Use --help for usage information." << std::endl;
+            return false;
+        }
     }
+    return true;
 }
 
-// Function to validate and process the command-line arguments
-void processCommandLineArguments(int argc, char* argv[]) {
+// Function to validate and process the command-line arguments. Returns the exit status:
+// non-zero for invalid arguments, a failed job, or damage found by --verify, so scripts
+// and scheduled scans can act on it.
+int processCommandLineArguments(int argc, char* argv[]) {
+    if (argc >= 3 && std::string(argv[1]) == "--verify") {
+        ProcessOptions options;
+        options.threads = 0;  // Verification is read-only, so every core by default
+        if (!parseOptions(argc, argv, 3, options)) {
+            return 1;
+        }
+        return verifyFile(argv[2], options) ? 0 : 1;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--serve") {
+        ProcessOptions options;
+        options.threads = 0;  // One warm handler per hardware thread by default
+        if (!parseOptions(argc, argv, 3, options)) {
+            return 1;
+        }
+        if (options.mode != CipherMode::ECB || options.io != IOBackend::Auto || options.recursive || options.container ||
+            options.stats || options.inPlace || options.processes != 1) {
+            std::cerr << "Error: --serve only takes --threads; each job brings its own algorithm, key and mode." << std::endl;
+            return 1;
+        }
+        return serveJobs(argv[2], options.threads == 0 ? ThreadPool::hardwareThreads() : options.threads);
+    }
     if (argc < 6) {
         std::cerr << "Error: Invalid number of arguments." << std::endl;
-        std::cerr << "Usage: encryption_tool.exe --[encrypt/decrypt] [encryption_type] [encryption_key] [input_file] [output_file]" << std::endl;
-        return;
+        std::cerr << "Usage: encryption_tool.exe --[encrypt/decrypt] [encryption_type] [encryption_key] [input_file] [output_file] [--threads N] [--processes N] [--mode ECB|CBC|CTR] [--io auto|mmap|pipeline|stream] [--recursive] [--container] [--compress] [--range OFFSET:LENGTH] [--in-place] [--rollback] [--stats] [--perf]" << std::endl;
+        std::cerr << "       encryption_tool.exe --verify [input_file] [--threads N]" << std::endl;
+        std::cerr << "       encryption_tool.exe --serve [socket_path] [--threads N]" << std::endl;
+        return 1;
     }
 
     std::string action = argv[1];
@@ -53,14 +320,19 @@ void processCommandLineArguments(int argc, char* argv[]) {
     if (action == "--help") {
         displayHelp();
     } else if (action == "--encrypt" || action == "--decrypt") {
-        processFile(action, algorithm, key, inputFile, outputFile);
+        ProcessOptions options;
+        if (!parseOptions(argc, argv, 6, options)) {
+            return 1;
+        }
+        return processFile(action, algorithm, key, inputFile, outputFile, options) ? 0 : 1;
     } else {
         std::cerr << "Error: Unknown action '" << action << "'." << std::endl;
         std::cerr << "Use --help for usage information." << std::endl;
+        return 1;
     }
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
-    processCommandLineArguments(argc, argv);
-    return 0;
+    return processCommandLineArguments(argc, argv);
 }
@@ -0,0 +1,169 @@
+#ifndef BLOCK_CIPHER_ALGORITHM_H
+#define BLOCK_CIPHER_ALGORITHM_H
+
+/**
+ * @file BlockCipherAlgorithm.h
+ * @brief The CryptoAlgorithm operations shared by every block cipher, over its context type.
+ *
+ * DES, 3DES and AES differ only in how a hex key becomes a prepared context (the
+ * *BlockCipher struct) and in the name they print; everything else goes through the
+ * modes layer in util/algorithm/modes the same way. Each algorithm derives from
+ * BlockCipherAlgorithm<Cipher, Id> and provides makeCipher and algorithmName.
+ * `Id` is the cipher recorded in container headers and in-place journals.
+ */
+
+#include "CryptoAlgorithm.h"
+#include "KeyCache.h"
+#include "modes/ModeBatch.h"
+#include "modes/ModeContainer.h"
+#include "modes/ModeFile.h"
+#include "modes/ModeTree.h"
+#include "../stats/Stats.h"
+#include <iostream>
+#include <string>
+
+template <class Cipher, ContainerCipher Id>
+class BlockCipherAlgorithm : public CryptoAlgorithm {
+public:
+    bool encrypt(const std::string& inputFile, const std::string& outputFile) override {
+        std::cout << "Encrypting " << inputFile << " using " << description() << " with key: " << key << std::endl;
+
+        if (!prepareKey()) {
+            return false;
+        }
+        bool ok = container ? encryptContainerWithMode(cipher, Id, mode, inputFile, outputFile, threads, compress)
+                  : inPlace ? processFileInPlaceWithMode(cipher, Id, mode, inputFile, InPlaceOperation::Encrypt)
+                            : encryptFileWithMode(cipher, mode, inputFile, outputFile, threads, io, processes);
+        if (!ok) {
+            return false;
+        }
+
+        std::cout << "Encryption complete. Ciphertext written to " << outputFile << std::endl;
+        return true;
+    }
+
+    bool decrypt(const std::string& inputFile, const std::string& outputFile) override {
+        // A container is decrypted in the mode its header records
+        std::cout << "Decrypting " << inputFile << " using "
+                  << description(container ? containerFileMode(inputFile, mode) : mode) << " with key: " << key
+                  << std::endl;
+
+        if (!prepareKey()) {
+            return false;
+        }
+        bool ok = container ? decryptContainerWithMode(cipher, Id, inputFile, outputFile, threads, range)
+                  : inPlace ? processFileInPlaceWithMode(cipher, Id, mode, inputFile, InPlaceOperation::Decrypt)
+                            : decryptFileWithMode(cipher, mode, inputFile, outputFile, threads, io, processes);
+        if (!ok) {
+            return false;
+        }
+
+        std::cout << "Decryption complete. Plaintext written to " << outputFile << std::endl;
+        return true;
+    }
+
+    // Undo an interrupted --in-place job from its journal
+    bool rollbackInPlace(const std::string& file) override {
+        std::cout << "Rolling back " << file << " using " << description() << " with key: " << key << std::endl;
+
+        if (!prepareKey() || !processFileInPlaceWithMode(cipher, Id, mode, file, InPlaceOperation::Rollback)) {
+            return false;
+        }
+
+        std::cout << "Rollback complete. " << file << " is back as it was before the interrupted job." << std::endl;
+        return true;
+    }
+
+    // The round keys are generated once for the whole tree
+    bool encryptDirectory(const std::string& inputDir, const std::string& outputDir) override {
+        std::cout << "Encrypting directory " << inputDir << " using " << description() << " with key: " << key << std::endl;
+
+        if (!prepareKey() || !encryptTreeWithMode(cipher, mode, inputDir, outputDir, threads, io)) {
+            return false;
+        }
+
+        std::cout << "Encryption complete. Ciphertext written to " << outputDir << std::endl;
+        return true;
+    }
+
+    bool decryptDirectory(const std::string& inputDir, const std::string& outputDir) override {
+        std::cout << "Decrypting directory " << inputDir << " using " << description() << " with key: " << key << std::endl;
+
+        if (!prepareKey() || !decryptTreeWithMode(cipher, mode, inputDir, outputDir, threads, io)) {
+            return false;
+        }
+
+        std::cout << "Decryption complete. Plaintext written to " << outputDir << std::endl;
+        return true;
+    }
+
+    bool encryptBuffer(std::span<const uint8_t> input, std::span<uint8_t> output, size_t& written) override {
+        return prepareKey() && encryptBufferWithMode(cipher, mode, input, output, written);
+    }
+
+    bool decryptBuffer(std::span<const uint8_t> input, std::span<uint8_t> output, size_t& written) override {
+        return prepareKey() && decryptBufferWithMode(cipher, mode, input, output, written);
+    }
+
+    size_t encryptedSize(size_t length) const override {
+        return ModeFile::encryptedSize(mode, Cipher::BLOCK_SIZE, length);
+    }
+
+    bool encryptBatch(std::span<KeyedBuffer> jobs) override {
+        return encryptBatchWithMode(keyCache, contextMaker(), mode, jobs, threads);
+    }
+
+    bool decryptBatch(std::span<KeyedBuffer> jobs) override {
+        return decryptBatchWithMode(keyCache, contextMaker(), mode, jobs, threads);
+    }
+
+protected:
+    // Parse the hex `key` and build its context; false (after printing the error) if the
+    // key is malformed. May run on several threads at once for a batch.
+    virtual bool makeCipher(const std::string& key, Cipher& cipher) const = 0;
+
+    // The name printed for jobs, e.g. "AES"
+    virtual const char* algorithmName() const = 0;
+
+    // Which block implementation runs, if there is a choice (e.g. "AES-NI")
+    virtual const char* implementationName() const {
+        return nullptr;
+    }
+
+private:
+    // e.g. "AES (CTR, AES-NI)"
+    std::string description() const {
+        return description(mode);
+    }
+
+    std::string description(CipherMode shownMode) const {
+        std::string text = std::string(algorithmName()) + " (" + cipherModeName(shownMode);
+        if (const char* implementation = implementationName()) {
+            text += std::string(", ") + implementation;
+        }
+        return text + ")";
+    }
+
+    auto contextMaker() const {
+        return [this](const std::string& text, Cipher& context) { return makeCipher(text, context); };
+    }
+
+    // Build the round keys for `key` unless they are already prepared
+    bool prepareKey() {
+        if (!keyPrepared) {
+            StageTimer timer(Stage::KeySetup);
+            const Cipher* prepared = keyCache.get(key, contextMaker());
+            if (!prepared) {
+                return false;
+            }
+            cipher = *prepared;
+            keyPrepared = true;
+        }
+        return true;
+    }
+
+    Cipher cipher;  // Context for `key`, valid while keyPrepared
+    KeyCache<Cipher> keyCache;  // Recently used keys, shared with the batch API
+};
+
+#endif // BLOCK_CIPHER_ALGORITHM_H
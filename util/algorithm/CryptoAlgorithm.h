@@ -1,19 +1,115 @@
 #ifndef CRYPTO_ALGORITHM_H
 #define CRYPTO_ALGORITHM_H
 
+#include "modes/CipherMode.h"
+#include "../io/ContainerFormat.h"
+#include "../io/IOBackend.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
+
+// One buffer of a batch job (encryptBatch / decryptBatch) with its own key. `output`
+// is sized as for encryptBuffer / decryptBuffer; `written` and `ok` are filled in.
+struct KeyedBuffer {
+    std::string_view key;
+    std::span<const uint8_t> input;
+    std::span<uint8_t> output;
+    size_t written = 0;
+    bool ok = false;
+};
 
 class CryptoAlgorithm {
 protected:
     std::string key;  // Encryption key
+    size_t threads = 1;  // Worker threads for chunk-parallel file processing
+    size_t processes = 1;  // Worker processes a single file is sharded across
+    CipherMode mode = CipherMode::ECB;  // Block cipher mode of operation
+    IOBackend io = IOBackend::Auto;  // How file data is read and written
+    bool container = false;  // Read and write the seekable container format
+    ByteRange range;  // Plaintext bytes to decrypt from a container
+    bool compress = false;  // Compress container chunks before encrypting them
+    bool inPlace = false;  // Rewrite the input file itself instead of writing an output file
+    bool keyPrepared = false;  // Whether the derived class's round keys match `key`
 
 public:
-    virtual void encrypt(const std::string& inputFile, const std::string& outputFile) = 0;
-    virtual void decrypt(const std::string& inputFile, const std::string& outputFile) = 0;
+    // Encrypt or decrypt a file. Returns false (after printing the error) if the job failed.
+    virtual bool encrypt(const std::string& inputFile, const std::string& outputFile) = 0;
+    virtual bool decrypt(const std::string& inputFile, const std::string& outputFile) = 0;
+
+    // Undo the interrupted --in-place job on `file` recorded in its journal, with the key
+    // and mode it was started with. Returns false (after printing the error) if it failed.
+    virtual bool rollbackInPlace(const std::string& file) = 0;
+
+    // Encrypt or decrypt every file under inputDir into the same tree under outputDir.
+    // Returns false if the key is bad, the tree cannot be read or any file failed.
+    virtual bool encryptDirectory(const std::string& inputDir, const std::string& outputDir) = 0;
+    virtual bool decryptDirectory(const std::string& inputDir, const std::string& outputDir) = 0;
+
+    // Encrypt or decrypt a buffer in memory with the current key and mode. The result is
+    // byte for byte what encrypt()/decrypt() would write to a file. `output` may be the
+    // input buffer itself; for encryption it must hold encryptedSize(input.size()) bytes,
+    // for decryption input.size() bytes. `written` receives the result length. Nothing is
+    // allocated: the round keys are prepared on first use and kept until setKey. Returns
+    // false (after printing the error) on a bad key, short output or malformed ciphertext.
+    virtual bool encryptBuffer(std::span<const uint8_t> input, std::span<uint8_t> output, size_t& written) = 0;
+    virtual bool decryptBuffer(std::span<const uint8_t> input, std::span<uint8_t> output, size_t& written) = 0;
+
+    // Ciphertext size for `length` bytes of plaintext in the current mode
+    virtual size_t encryptedSize(size_t length) const = 0;
+
+    // Encrypt or decrypt many buffers, each under its own key, in the current mode. Key
+    // contexts come from an LRU cache of the last KEY_CACHE_CAPACITY keys; the keys of
+    // a batch are scheduled together before its buffers are processed, on `threads`
+    // threads. Returns true if every job succeeded; see KeyedBuffer::ok for which failed.
+    virtual bool encryptBatch(std::span<KeyedBuffer> jobs) = 0;
+    virtual bool decryptBatch(std::span<KeyedBuffer> jobs) = 0;
     
     // Set the encryption key
     virtual void setKey(const std::string& encryptionKey) {
         key = encryptionKey;
+        keyPrepared = false;
+    }
+
+    // Set the number of threads used for encryption/decryption
+    virtual void setThreads(size_t threadCount) {
+        threads = threadCount == 0 ? 1 : threadCount;
+    }
+
+    // Set the number of worker processes a file is split across (1: none)
+    virtual void setProcesses(size_t processCount) {
+        processes = processCount == 0 ? 1 : processCount;
+    }
+
+    // Set the block cipher mode of operation
+    virtual void setMode(CipherMode cipherMode) {
+        mode = cipherMode;
+    }
+
+    // Set the file I/O backend
+    virtual void setIOBackend(IOBackend backend) {
+        io = backend;
+    }
+
+    // Encrypt into / decrypt from the seekable container format
+    virtual void setContainer(bool enabled) {
+        container = enabled;
+    }
+
+    // Compress each container chunk before encrypting it, where that makes it shorter
+    virtual void setCompress(bool enabled) {
+        compress = enabled;
+    }
+
+    // Encrypt or decrypt the input file in place; the output file must be the same
+    virtual void setInPlace(bool enabled) {
+        inPlace = enabled;
+    }
+
+    // Decrypt only these plaintext bytes of a container
+    virtual void setRange(const ByteRange& byteRange) {
+        range = byteRange;
     }
 
     virtual ~CryptoAlgorithm() = default;
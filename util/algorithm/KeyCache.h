@@ -0,0 +1,76 @@
+#ifndef KEY_CACHE_H
+#define KEY_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Prepared key contexts kept by a CryptoAlgorithm for its most recently used keys
+constexpr size_t KEY_CACHE_CAPACITY = 1024;
+
+// Least-recently-used cache from key strings to prepared key contexts (the block
+// cipher structs, e.g. AESBlockCipher). A hit moves the entry to the front; inserting
+// into a full cache drops the entry used longest ago. Pointers returned by get stay
+// valid until at least `capacity` further keys have been looked up.
+template <class Context>
+class KeyCache {
+public:
+    explicit KeyCache(size_t capacity = KEY_CACHE_CAPACITY) : maxEntries(capacity == 0 ? 1 : capacity) {}
+
+    // The context for `key`, built with make(key, context) on a miss. Returns nullptr if
+    // make fails (it prints the error); failed keys are not cached.
+    template <class MakeContext>
+    const Context* get(std::string_view key, MakeContext&& make) {
+        auto found = index.find(key);
+        if (found != index.end()) {
+            ++hitCount;
+            entries.splice(entries.begin(), entries, found->second);
+            return &found->second->context;
+        }
+
+        ++missCount;
+        Entry entry{std::string(key), Context{}};
+        if (!make(entry.key, entry.context)) {
+            return nullptr;
+        }
+        if (entries.size() == maxEntries) {
+            index.erase(entries.back().key);
+            entries.pop_back();
+        }
+        entries.push_front(std::move(entry));
+        index.emplace(entries.front().key, entries.begin());
+        return &entries.front().context;
+    }
+
+    size_t capacity() const {
+        return maxEntries;
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    size_t hits() const {
+        return hitCount;
+    }
+
+    size_t misses() const {
+        return missCount;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        Context context;
+    };
+
+    size_t maxEntries;
+    size_t hitCount = 0;
+    size_t missCount = 0;
+    std::list<Entry> entries;  // Most recently used first
+    std::unordered_map<std::string_view, typename std::list<Entry>::iterator> index;  // Views of Entry::key
+};
+
+#endif // KEY_CACHE_H
@@ -0,0 +1,145 @@
+#ifndef BLOCK_MODES_H
+#define BLOCK_MODES_H
+
+/**
+ * @file BlockModes.h
+ * @brief Modes of operation (ECB, CBC, CTR) as chunk transforms over any block cipher.
+ *
+ * The modes are templates over a `Cipher` type that provides:
+ *
+ *     static constexpr size_t BLOCK_SIZE;
+ *     void encryptBlock(const uint8_t* in, uint8_t* out) const;
+ *     void decryptBlock(const uint8_t* in, uint8_t* out) const;
+ *     void encryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const;  // in may equal out
+ *     void decryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const;
+ *
+ * (see DESBlockCipher.h). Being templates, the block function is inlined straight into
+ * the mode loop instead of being called through a pointer for every block.
+ *
+ * Each function transforms one FileChunk (see util/io/BlockStream.h), either in place or
+ * from an input buffer into a separate output buffer such as a memory-mapped file:
+ * - ECB, CTR and CBC decryption only depend on the chunk itself, its offset and the
+ *   input block in front of it, so chunks can be processed in any order and on any
+ *   thread.
+ * - CBC encryption chains every block to the ciphertext before it and must see the
+ *   chunks in order; the chain lives in a CBCState.
+ */
+
+#include "../../io/BlockStream.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace BlockModes {
+
+// Blocks per bulk call in CBC decryption and CTR, enough to fill the widest kernel
+constexpr size_t BATCH_BLOCKS = 512;
+
+template <class Cipher>
+void xorBlock(uint8_t* data, const uint8_t* mask) {
+    for (size_t i = 0; i < Cipher::BLOCK_SIZE; ++i) {
+        data[i] ^= mask[i];
+    }
+}
+
+template <class Cipher>
+void ecbEncrypt(const Cipher& cipher, const FileChunk& chunk) {
+    cipher.encryptBlocks(chunk.input, chunk.data, chunk.length / Cipher::BLOCK_SIZE);
+}
+
+template <class Cipher>
+void ecbDecrypt(const Cipher& cipher, const FileChunk& chunk) {
+    cipher.decryptBlocks(chunk.input, chunk.data, chunk.length / Cipher::BLOCK_SIZE);
+}
+
+// Last ciphertext block produced so far, starting out as the IV
+template <class Cipher>
+struct CBCState {
+    uint8_t chain[Cipher::BLOCK_SIZE];
+};
+
+template <class Cipher>
+void cbcEncrypt(const Cipher& cipher, CBCState<Cipher>& state, const FileChunk& chunk) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    const uint8_t* chain = state.chain;
+    for (size_t pos = 0; pos + B <= chunk.length; pos += B) {
+        uint8_t* block = chunk.data + pos;
+        for (size_t i = 0; i < B; ++i) {
+            block[i] = chunk.input[pos + i] ^ chain[i];
+        }
+        cipher.encryptBlock(block, block);
+        chain = block;
+    }
+    std::memcpy(state.chain, chain, B);
+}
+
+template <class Cipher>
+void cbcDecrypt(const Cipher& cipher, const uint8_t* iv, const FileChunk& chunk) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    uint8_t ciphertext[BATCH_BLOCKS * B];
+    uint8_t previous[B];
+    std::memcpy(previous, chunk.previous ? chunk.previous : iv, B);
+
+    size_t blocks = chunk.length / B;
+    for (size_t first = 0; first < blocks; first += BATCH_BLOCKS) {
+        size_t count = blocks - first < BATCH_BLOCKS ? blocks - first : BATCH_BLOCKS;
+        uint8_t* data = chunk.data + first * B;
+        const uint8_t* source = chunk.input + first * B;
+
+        // In place, keep a copy of the batch's ciphertext since decryption overwrites it
+        if (chunk.input == chunk.data) {
+            std::memcpy(ciphertext, source, count * B);
+            source = ciphertext;
+        }
+        cipher.decryptBlocks(source, data, count);
+
+        xorBlock<Cipher>(data, previous);
+        for (size_t i = 1; i < count; ++i) {
+            xorBlock<Cipher>(data + i * B, source + (i - 1) * B);
+        }
+        std::memcpy(previous, source + (count - 1) * B, B);
+    }
+}
+
+// Add `value` to a big-endian counter block
+template <class Cipher>
+void addToCounter(uint8_t* counter, uint64_t value) {
+    for (size_t i = Cipher::BLOCK_SIZE; i-- > 0 && value != 0;) {
+        uint64_t sum = counter[i] + (value & 0xFF);
+        counter[i] = static_cast<uint8_t>(sum);
+        value = (value >> 8) + (sum >> 8);
+    }
+}
+
+// Counter mode: block n of the stream is XORed with E(IV + n). Encryption and
+// decryption are the same operation, and the last block may be partial.
+template <class Cipher>
+void ctrTransform(const Cipher& cipher, const uint8_t* iv, const FileChunk& chunk) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    uint8_t keystream[BATCH_BLOCKS * B];
+    uint8_t counter[B];
+    std::memcpy(counter, iv, B);
+    addToCounter<Cipher>(counter, chunk.offset / B);
+
+    for (size_t pos = 0; pos < chunk.length; pos += BATCH_BLOCKS * B) {
+        size_t length = chunk.length - pos < BATCH_BLOCKS * B ? chunk.length - pos : BATCH_BLOCKS * B;
+        size_t count = (length + B - 1) / B;
+
+        // Lay out the whole batch of counter blocks and encrypt them in one call
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(keystream + i * B, counter, B);
+            addToCounter<Cipher>(counter, 1);
+        }
+        cipher.encryptBlocks(keystream, keystream, count);
+
+        uint8_t* data = chunk.data + pos;
+        const uint8_t* source = chunk.input + pos;
+        for (size_t i = 0; i < length; ++i) {
+            data[i] = source[i] ^ keystream[i];
+        }
+    }
+}
+
+} // namespace BlockModes
+
+#endif // BLOCK_MODES_H
@@ -0,0 +1,26 @@
+#include "CipherMode.h"
+#include <algorithm>
+#include <cctype>
+
+bool parseCipherMode(const std::string& name, CipherMode& mode) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+
+    for (CipherMode candidate : {CipherMode::ECB, CipherMode::CBC, CipherMode::CTR}) {
+        if (upper == cipherModeName(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* cipherModeName(CipherMode mode) {
+    switch (mode) {
+        case CipherMode::ECB: return "ECB";
+        case CipherMode::CBC: return "CBC";
+        case CipherMode::CTR: return "CTR";
+    }
+    return "?";
+}
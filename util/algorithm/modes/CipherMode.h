@@ -0,0 +1,19 @@
+#ifndef CIPHER_MODE_H
+#define CIPHER_MODE_H
+
+#include <string>
+
+// Block cipher modes of operation selectable with --mode
+enum class CipherMode {
+    ECB,  // each block on its own (the original file format)
+    CBC,  // random IV header, each block chained to the previous ciphertext block
+    CTR   // random IV header, keystream from an incrementing counter, no padding
+};
+
+// Parse a mode name such as "CBC" (case-insensitive); returns false if unknown
+bool parseCipherMode(const std::string& name, CipherMode& mode);
+
+// Upper-case name of the mode, e.g. "CTR"
+const char* cipherModeName(CipherMode mode);
+
+#endif // CIPHER_MODE_H
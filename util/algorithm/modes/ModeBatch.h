@@ -0,0 +1,89 @@
+#ifndef MODE_BATCH_H
+#define MODE_BATCH_H
+
+/**
+ * @file ModeBatch.h
+ * @brief Batches of in-memory buffers, each with its own key, through a block cipher mode.
+ *
+ * Meant for many small messages under many keys, where preparing keys costs as much as
+ * encrypting. Jobs are handled in windows of BATCH_KEY_WINDOW: first every key of the
+ * window is looked up in the algorithm's KeyCache and the missing ones are scheduled
+ * one after another, then the window's buffers are encrypted with the prepared
+ * contexts, spread over the thread pool when there is one. Each buffer goes through
+ * encryptBufferWithMode / decryptBufferWithMode, so the output matches encryptBuffer.
+ */
+
+#include "ModeFile.h"
+#include "../CryptoAlgorithm.h"
+#include "../KeyCache.h"
+#include "../../thread/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Jobs whose keys are resolved before any of their buffers are processed
+constexpr size_t BATCH_KEY_WINDOW = 256;
+
+namespace ModeBatch {
+
+template <bool Encrypt, class Cipher, class MakeCipher>
+bool processBatch(KeyCache<Cipher>& cache, MakeCipher& make, CipherMode mode, std::span<KeyedBuffer> jobs,
+                  size_t threads) {
+    // A window never looks up more keys than the cache holds, so its contexts stay put
+    size_t window = std::min(BATCH_KEY_WINDOW, cache.capacity());
+    std::vector<const Cipher*> contexts(std::min(window, jobs.size()));
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1 && jobs.size() > 1) {
+        pool = std::make_unique<ThreadPool>(threads - 1);
+    }
+
+    std::atomic<size_t> failed{0};
+    for (size_t first = 0; first < jobs.size(); first += window) {
+        size_t count = std::min(window, jobs.size() - first);
+        for (size_t i = 0; i < count; ++i) {
+            contexts[i] = cache.get(jobs[first + i].key, make);
+        }
+
+        auto run = [&](size_t i) {
+            KeyedBuffer& job = jobs[first + i];
+            job.written = 0;
+            if (!contexts[i]) {
+                job.ok = false;
+            } else if (Encrypt) {
+                job.ok = encryptBufferWithMode(*contexts[i], mode, job.input, job.output, job.written);
+            } else {
+                job.ok = decryptBufferWithMode(*contexts[i], mode, job.input, job.output, job.written);
+            }
+            if (!job.ok) {
+                ++failed;
+            }
+        };
+        if (pool) {
+            pool->parallelFor(count, run);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                run(i);
+            }
+        }
+    }
+    return failed == 0;
+}
+
+} // namespace ModeBatch
+
+template <class Cipher, class MakeCipher>
+bool encryptBatchWithMode(KeyCache<Cipher>& cache, MakeCipher make, CipherMode mode, std::span<KeyedBuffer> jobs,
+                          size_t threads) {
+    return ModeBatch::processBatch<true>(cache, make, mode, jobs, threads);
+}
+
+template <class Cipher, class MakeCipher>
+bool decryptBatchWithMode(KeyCache<Cipher>& cache, MakeCipher make, CipherMode mode, std::span<KeyedBuffer> jobs,
+                          size_t threads) {
+    return ModeBatch::processBatch<false>(cache, make, mode, jobs, threads);
+}
+
+#endif // MODE_BATCH_H
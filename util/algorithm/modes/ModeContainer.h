@@ -0,0 +1,354 @@
+#ifndef MODE_CONTAINER_H
+#define MODE_CONTAINER_H
+
+/**
+ * @file ModeContainer.h
+ * @brief Encryption into and decryption out of the seekable container format (--container).
+ *
+ * The layout is described in util/io/ContainerFormat.h. Every chunk is encrypted on
+ * its own in the chosen mode with a fresh random IV (CBC chains restart at each chunk,
+ * CTR counters start from each chunk's IV), so a chunk can be decrypted from its index
+ * entry alone. Decrypting a --range reads the index entries and the chunks that
+ * overlap the range and nothing else.
+ *
+ * Chunks are read and written in order, in groups of CONTAINER_GROUP_CHUNKS per
+ * thread; the chunks of a group are encrypted or decrypted on the thread pool. The
+ * thread that encrypts a chunk also takes its CRC-32C while the ciphertext is still in
+ * cache, and decryption checks it before decrypting, so a damaged chunk is reported by
+ * number instead of surfacing as garbage or a padding error at the end.
+ *
+ * With --compress each chunk is first compressed (util/compress/LZBlock.h) on the same
+ * thread, and the compressed bytes are encrypted instead whenever that makes the chunk
+ * shorter; chunks that do not shrink, such as already compressed data, are stored as
+ * they are. The index records which chunks are compressed, so decryption needs no flag.
+ */
+
+#include "ModeFile.h"
+#include "../../checksum/CRC32C.h"
+#include "../../compress/LZBlock.h"
+#include "../../io/ContainerFormat.h"
+#include "../../memory/BufferPool.h"
+#include "../../stats/Stats.h"
+#include "../../thread/ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Chunks per thread handled between reading and writing
+constexpr size_t CONTAINER_GROUP_CHUNKS = 4;
+
+namespace ModeContainer {
+
+inline bool writeFailed() {
+    std::cerr << "Error: Failed to write output data." << std::endl;
+    return false;
+}
+
+// What became of one chunk on the decryption side
+enum class ChunkResult : uint8_t {
+    Ok,
+    Damaged,       // Checksum mismatch
+    BadPadding,    // Wrong key or a forged chunk
+    BadCompression
+};
+
+// Report a chunk that did not decrypt; always false
+inline bool chunkFailed(ChunkResult result, uint64_t number) {
+    std::cerr << "Error: Chunk " << number;
+    switch (result) {
+        case ChunkResult::Damaged:
+            std::cerr << " of the container failed its checksum (the file is corrupted)." << std::endl;
+            break;
+        case ChunkResult::BadCompression:
+            std::cerr << " could not be decompressed (wrong key or corrupted data)." << std::endl;
+            break;
+        default:
+            std::cerr << " has invalid padding (wrong key or corrupted data)." << std::endl;
+            break;
+    }
+    return false;
+}
+
+// Run `transform` on chunks [0, count), on the pool when there is one
+template <class Transform>
+void forEachChunk(ThreadPool* pool, size_t count, const Transform& transform) {
+    if (pool && count > 1) {
+        pool->parallelFor(count, transform);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            transform(i);
+        }
+    }
+}
+
+} // namespace ModeContainer
+
+template <class Cipher>
+bool encryptContainerWithMode(const Cipher& cipher, ContainerCipher id, CipherMode mode, const std::string& inputFile,
+                              const std::string& outputFile, size_t threads, bool compress = false) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    std::ifstream input(inputFile, std::ios::binary);
+    if (!input) {
+        std::cerr << "Error: Could not open input file " << inputFile << std::endl;
+        return false;
+    }
+    if (!checkDistinctFiles(inputFile, outputFile)) {
+        return false;
+    }
+    std::ofstream output(outputFile, std::ios::binary);
+    if (!output) {
+        std::cerr << "Error: Could not open output file " << outputFile << std::endl;
+        return false;
+    }
+
+    // The header is written again at the end, once the totals are known
+    ContainerHeader header;
+    header.cipher = id;
+    header.mode = static_cast<uint8_t>(mode);
+    header.blockSize = B;
+    if (!writeContainerHeader(output, header)) {
+        return ModeContainer::writeFailed();
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1) {
+        pool = std::make_unique<ThreadPool>(threads - 1);
+    }
+    bool padded = ModeFile::isPadded(mode);
+    size_t group = CONTAINER_GROUP_CHUNKS * std::max<size_t>(threads, 1);
+    size_t slot = alignedBufferSize(header.chunkSize + B);
+    size_t packedSlot = compress ? alignedBufferSize(lzCompressBound(header.chunkSize) + B) : 0;
+    PooledBuffer buffer = BufferPool::acquire(group * slot);
+    PooledBuffer packed = compress ? BufferPool::acquire(group * packedSlot) : PooledBuffer();
+    std::vector<ContainerChunk> index;
+    uint64_t offset = CONTAINER_HEADER_SIZE;
+    uint64_t compressedChunks = 0;
+
+    bool last = false;
+    while (!last) {
+        size_t first = index.size();
+        size_t count = 0;
+        for (; count < group && !last; ++count) {
+            uint8_t* data = buffer.data() + count * slot;
+            StageTimer reading(Stage::Read);
+            input.read(reinterpret_cast<char*>(data), header.chunkSize);
+            size_t length = static_cast<size_t>(input.gcount());
+            reading.setBytes(length);
+            reading.stop();
+            if (input.bad()) {
+                std::cerr << "Error: Failed to read input data." << std::endl;
+                return false;
+            }
+            last = length < header.chunkSize || input.peek() == std::ifstream::traits_type::eof();
+            header.plaintextSize += length;
+
+            ContainerChunk chunk;
+            if (ModeFile::hasIV(mode)) {
+                ModeFile::randomIV(chunk.iv, B);
+            }
+            chunk.length = static_cast<uint32_t>(length);  // Plaintext until the chunk is encrypted
+            index.push_back(chunk);
+        }
+
+        ModeContainer::forEachChunk(pool.get(), count, [&](size_t i) {
+            uint8_t* data = buffer.data() + i * slot;
+            ContainerChunk& chunk = index[first + i];
+            bool lastInFile = last && i + 1 == count;
+            uint8_t* source = data;
+            size_t length = chunk.length;
+            size_t padLen = padded && lastInFile ? B - length % B : 0;
+
+            if (compress && length != 0) {
+                uint8_t* compressed = packed.data() + i * packedSlot;
+                StageTimer compressing(Stage::Compress, length);
+                size_t compressedLength = lzCompress(data, length, compressed);
+                compressing.stop();
+                size_t compressedPad = padded ? B - compressedLength % B : 0;
+                if (compressedLength + compressedPad < length + padLen &&
+                    compressedLength + compressedPad <= header.chunkSize) {
+                    source = compressed;
+                    length = compressedLength;
+                    padLen = compressedPad;
+                    chunk.flags |= CONTAINER_CHUNK_COMPRESSED;
+                }
+            }
+            std::memset(source + length, static_cast<int>(padLen), padLen);
+            chunk.length = static_cast<uint32_t>(length + padLen);
+
+            BlockModes::CBCState<Cipher> cbc;
+            if (mode == CipherMode::CBC) {
+                std::memcpy(cbc.chain, chunk.iv, B);
+            }
+            ModeFile::encryptChunk(cipher, mode, chunk.iv, cbc, FileChunk{data, source, chunk.length, 0, nullptr});
+            StageTimer checksumming(Stage::Checksum, chunk.length);
+            chunk.checksum = crc32c(data, chunk.length);
+        });
+
+        for (size_t i = 0; i < count; ++i) {
+            ContainerChunk& chunk = index[first + i];
+            chunk.offset = offset;
+            offset += chunk.length;
+            compressedChunks += (chunk.flags & CONTAINER_CHUNK_COMPRESSED) ? 1 : 0;
+            StageTimer writing(Stage::Write, chunk.length);
+            output.write(reinterpret_cast<const char*>(buffer.data() + i * slot), chunk.length);
+        }
+        if (!output) {
+            return ModeContainer::writeFailed();
+        }
+    }
+
+    header.chunkCount = index.size();
+    header.indexOffset = offset;
+    if (!writeContainerIndex(output, index) || !output.seekp(0) || !writeContainerHeader(output, header)) {
+        return ModeContainer::writeFailed();
+    }
+    if (compress) {
+        uint64_t stored = offset - CONTAINER_HEADER_SIZE;
+        std::cout << "Compressed " << compressedChunks << " of " << index.size() << " chunks: " << header.plaintextSize
+                  << " bytes stored as " << stored << " (" << (stored ? double(header.plaintextSize) / stored : 0.0)
+                  << "x)" << std::endl;
+    }
+    return true;
+}
+
+// Decrypt the plaintext bytes in `range` (by default all of them) into `outputFile`.
+// The mode is taken from the container header.
+template <class Cipher>
+bool decryptContainerWithMode(const Cipher& cipher, ContainerCipher id, const std::string& inputFile,
+                              const std::string& outputFile, size_t threads, ByteRange range = {}) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    std::ifstream input(inputFile, std::ios::binary);
+    if (!input) {
+        std::cerr << "Error: Could not open input file " << inputFile << std::endl;
+        return false;
+    }
+    ContainerHeader header;
+    if (!readContainerHeader(input, id, header)) {
+        return false;
+    }
+    if (header.blockSize != B) {
+        std::cerr << "Error: Container header is corrupted." << std::endl;
+        return false;
+    }
+    CipherMode mode = static_cast<CipherMode>(header.mode);
+    bool padded = ModeFile::isPadded(mode);
+
+    if (range.offset > header.plaintextSize) {
+        std::cerr << "Error: Range starts past the end of the plaintext (" << header.plaintextSize << " bytes)."
+                  << std::endl;
+        return false;
+    }
+    uint64_t end = range.offset + std::min(range.length, header.plaintextSize - range.offset);
+
+    if (!checkDistinctFiles(inputFile, outputFile)) {
+        return false;
+    }
+    std::ofstream output(outputFile, std::ios::binary);
+    if (!output) {
+        std::cerr << "Error: Could not open output file " << outputFile << std::endl;
+        return false;
+    }
+    if (end == range.offset) {
+        return true;
+    }
+
+    // Only the chunks overlapping the range are read
+    uint64_t firstChunk = range.offset / header.chunkSize;
+    uint64_t lastChunk = (end - 1) / header.chunkSize;
+    std::vector<ContainerChunk> index;
+    if (!readContainerIndex(input, header, firstChunk, lastChunk - firstChunk + 1, index)) {
+        return false;
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1 && index.size() > 1) {
+        pool = std::make_unique<ThreadPool>(threads - 1);
+    }
+    size_t group = std::min<uint64_t>(CONTAINER_GROUP_CHUNKS * std::max<size_t>(threads, 1), index.size());
+    size_t slot = alignedBufferSize(header.chunkSize + B);
+    bool anyCompressed = std::any_of(index.begin(), index.end(), [](const ContainerChunk& chunk) {
+        return (chunk.flags & CONTAINER_CHUNK_COMPRESSED) != 0;
+    });
+    PooledBuffer buffer = BufferPool::acquire(group * slot);
+    PooledBuffer unpacked = anyCompressed ? BufferPool::acquire(group * header.chunkSize) : PooledBuffer();
+    std::vector<const uint8_t*> plaintext(group);
+    std::vector<ModeContainer::ChunkResult> results(group);
+
+    for (size_t first = 0; first < index.size(); first += group) {
+        size_t count = std::min(group, index.size() - first);
+        for (size_t i = 0; i < count; ++i) {
+            const ContainerChunk& chunk = index[first + i];
+            StageTimer reading(Stage::Read, chunk.length);
+            input.seekg(static_cast<std::streamoff>(chunk.offset));
+            if (!input.read(reinterpret_cast<char*>(buffer.data() + i * slot), chunk.length)) {
+                std::cerr << "Error: Container is truncated." << std::endl;
+                return false;
+            }
+        }
+
+        ModeContainer::forEachChunk(pool.get(), count, [&](size_t i) {
+            using ModeContainer::ChunkResult;
+            uint8_t* data = buffer.data() + i * slot;
+            const ContainerChunk& chunk = index[first + i];
+            uint64_t number = firstChunk + first + i;
+            StageTimer checksumming(Stage::Checksum, chunk.length);
+            bool damaged = crc32c(data, chunk.length) != chunk.checksum;
+            checksumming.stop();
+            if (damaged) {
+                results[i] = ChunkResult::Damaged;
+                return;
+            }
+            ModeFile::decryptChunk(cipher, mode, chunk.iv, FileChunk{data, data, chunk.length, 0, nullptr});
+            plaintext[i] = data;
+            results[i] = ChunkResult::Ok;
+
+            uint64_t plain = containerChunkPlaintext(header, number);
+            if (!(chunk.flags & CONTAINER_CHUNK_COMPRESSED)) {
+                if (padded && number + 1 == header.chunkCount && data[chunk.length - 1] != B - plain % B) {
+                    results[i] = ChunkResult::BadPadding;
+                }
+                return;
+            }
+            size_t length = chunk.length;
+            if (padded) {
+                size_t padLen = data[length - 1];
+                if (padLen == 0 || padLen > B) {
+                    results[i] = ChunkResult::BadPadding;
+                    return;
+                }
+                length -= padLen;
+            }
+            uint8_t* target = unpacked.data() + i * header.chunkSize;
+            StageTimer decompressing(Stage::Compress, plain);
+            if (!lzDecompress(data, length, target, plain)) {
+                results[i] = ChunkResult::BadCompression;
+            }
+            plaintext[i] = target;
+        });
+
+        for (size_t i = 0; i < count; ++i) {
+            if (results[i] != ModeContainer::ChunkResult::Ok) {
+                return ModeContainer::chunkFailed(results[i], firstChunk + first + i);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t number = firstChunk + first + i;
+            uint64_t chunkStart = number * header.chunkSize;
+            uint64_t plain = containerChunkPlaintext(header, number);
+            uint64_t from = std::max(range.offset, chunkStart) - chunkStart;
+            uint64_t to = std::min(end, chunkStart + plain) - chunkStart;
+            StageTimer writing(Stage::Write, to - from);
+            output.write(reinterpret_cast<const char*>(plaintext[i] + from), static_cast<std::streamsize>(to - from));
+        }
+        if (!output) {
+            return ModeContainer::writeFailed();
+        }
+    }
+    return true;
+}
+
+#endif // MODE_CONTAINER_H
@@ -0,0 +1,361 @@
+#ifndef MODE_FILE_H
+#define MODE_FILE_H
+
+/**
+ * @file ModeFile.h
+ * @brief File encryption and decryption with a block cipher in a chosen mode.
+ *
+ * File layout: ECB files hold only the padded ciphertext (the original format). CBC and
+ * CTR files start with a random IV of one block; CBC is padded like ECB, CTR output is
+ * exactly as long as the input.
+ *
+ * The I/O backend (--io) decides how data reaches the cipher. By default large regular
+ * files are processed through memory mappings (util/io/MappedFile.h); otherwise, with
+ * more than one thread the work goes through encryptFileParallel and
+ * decryptFileParallel, and with one thread through the asynchronous read/transform/write
+ * pipeline (util/io/PipelinedFile.h). With --processes the body is split across forked
+ * worker processes instead (util/io/ShardedFile.h). CBC encryption cannot be split and
+ * always runs on a single thread. A "-" for either file (standard input or output) always takes the
+ * single-pass stream of util/io/StandardStream.h, whatever the backend. --in-place
+ * rewrites the file itself through the journaled loop of util/io/InPlaceFile.h.
+ */
+
+#include "BlockModes.h"
+#include "CipherMode.h"
+#include "../../checksum/CRC32C.h"
+#include "../../io/BlockStream.h"
+#include "../../io/ContainerFormat.h"
+#include "../../io/InPlaceFile.h"
+#include "../../io/IOBackend.h"
+#include "../../io/MappedFile.h"
+#include "../../io/ParallelFile.h"
+#include "../../io/PipelinedFile.h"
+#include "../../io/ShardedFile.h"
+#include "../../io/StandardStream.h"
+#include "../../stats/Stats.h"
+#include "../../thread/ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ModeFile {
+
+inline bool hasIV(CipherMode mode) {
+    return mode != CipherMode::ECB;
+}
+
+inline bool isPadded(CipherMode mode) {
+    return mode != CipherMode::CTR;
+}
+
+// Each random() is a read from the OS generator, so a device is kept per thread and all
+// 32 bits of every draw are used: an IV costs four draws instead of sixteen plus an open
+inline void randomIV(uint8_t* iv, size_t size) {
+    thread_local std::random_device random;
+    for (size_t i = 0; i < size; i += 4) {
+        uint32_t value = random();
+        for (size_t j = i; j < size && j < i + 4; ++j) {
+            iv[j] = static_cast<uint8_t>(value >> (8 * (j - i)));
+        }
+    }
+}
+
+inline std::vector<uint8_t> randomIV(size_t size) {
+    std::vector<uint8_t> iv(size);
+    randomIV(iv.data(), size);
+    return iv;
+}
+
+// Bytes of ciphertext, IV header and padding included, for `length` bytes of plaintext
+inline size_t encryptedSize(CipherMode mode, size_t blockSize, size_t length) {
+    return (hasIV(mode) ? blockSize : 0) + length + (isPadded(mode) ? blockSize - length % blockSize : 0);
+}
+
+// --io mmap maps files of any size, the default only large ones
+inline uint64_t mappingThreshold(IOBackend io) {
+    return io == IOBackend::Mapped ? 1 : MAPPED_IO_MIN_SIZE;
+}
+
+inline bool usePipeline(IOBackend io, const ThreadPool* pool) {
+    return io == IOBackend::Pipeline || (io == IOBackend::Auto && !pool);
+}
+
+template <class Cipher>
+void encryptChunk(const Cipher& cipher, CipherMode mode, const uint8_t* iv, BlockModes::CBCState<Cipher>& cbc,
+                  const FileChunk& chunk) {
+    StageTimer timer(Stage::Cipher, chunk.length);
+    switch (mode) {
+        case CipherMode::ECB: BlockModes::ecbEncrypt(cipher, chunk); break;
+        case CipherMode::CBC: BlockModes::cbcEncrypt(cipher, cbc, chunk); break;
+        case CipherMode::CTR: BlockModes::ctrTransform(cipher, iv, chunk); break;
+    }
+    Stats::addBlocks((chunk.length + Cipher::BLOCK_SIZE - 1) / Cipher::BLOCK_SIZE);
+}
+
+template <class Cipher>
+void decryptChunk(const Cipher& cipher, CipherMode mode, const uint8_t* iv, const FileChunk& chunk) {
+    StageTimer timer(Stage::Cipher, chunk.length);
+    switch (mode) {
+        case CipherMode::ECB: BlockModes::ecbDecrypt(cipher, chunk); break;
+        case CipherMode::CBC: BlockModes::cbcDecrypt(cipher, iv, chunk); break;
+        case CipherMode::CTR: BlockModes::ctrTransform(cipher, iv, chunk); break;
+    }
+    Stats::addBlocks((chunk.length + Cipher::BLOCK_SIZE - 1) / Cipher::BLOCK_SIZE);
+}
+
+} // namespace ModeFile
+
+// Encrypt `input` into `output`, laid out exactly like a file written by
+// encryptFileWithMode (IV header, padding). `output` must hold at least
+// ModeFile::encryptedSize bytes and may overlap `input`, so a buffer can be encrypted in
+// place if it has room for the header and padding. Nothing is allocated. Returns false
+// (after printing the error) if `output` is too small.
+template <class Cipher>
+bool encryptBufferWithMode(const Cipher& cipher, CipherMode mode, std::span<const uint8_t> input,
+                           std::span<uint8_t> output, size_t& written) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    size_t length = input.size();
+    size_t headerSize = ModeFile::hasIV(mode) ? B : 0;
+    size_t padLen = ModeFile::isPadded(mode) ? B - length % B : 0;
+    if (output.size() < headerSize + length + padLen) {
+        std::cerr << "Error: Output buffer is too small for the ciphertext." << std::endl;
+        return false;
+    }
+
+    // Move the plaintext behind the IV first, since in place the IV would overwrite it
+    uint8_t* body = output.data() + headerSize;
+    std::memmove(body, input.data(), length);
+    std::memset(body + length, static_cast<int>(padLen), padLen);
+    ModeFile::randomIV(output.data(), headerSize);
+
+    BlockModes::CBCState<Cipher> cbc;
+    if (mode == CipherMode::CBC) {
+        std::memcpy(cbc.chain, output.data(), B);
+    }
+    ModeFile::encryptChunk(cipher, mode, output.data(), cbc, FileChunk{body, body, length + padLen, 0, nullptr});
+    written = headerSize + length + padLen;
+    return true;
+}
+
+// In-memory counterpart of decryptFileWithMode. `output` must hold input.size() bytes
+// and may overlap `input`. Returns false (after printing the error) if the ciphertext is
+// malformed or `output` is too small.
+template <class Cipher>
+bool decryptBufferWithMode(const Cipher& cipher, CipherMode mode, std::span<const uint8_t> input,
+                           std::span<uint8_t> output, size_t& written) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    size_t headerSize = ModeFile::hasIV(mode) ? B : 0;
+    bool padded = ModeFile::isPadded(mode);
+    if (input.size() < headerSize) {
+        std::cerr << "Error: Ciphertext is too short to contain an IV." << std::endl;
+        return false;
+    }
+    size_t bodyLength = input.size() - headerSize;
+    if (padded && bodyLength == 0) {
+        std::cerr << "Error: Ciphertext is empty." << std::endl;
+        return false;
+    }
+    if (padded && bodyLength % B != 0) {
+        std::cerr << "Error: Ciphertext length is not a multiple of the block size." << std::endl;
+        return false;
+    }
+    if (output.size() < bodyLength) {
+        std::cerr << "Error: Output buffer is too small for the plaintext." << std::endl;
+        return false;
+    }
+
+    // The modes decrypt in place or between disjoint buffers; anything else is first
+    // moved to where the plaintext goes, with the IV kept aside
+    uint8_t iv[B] = {};
+    std::memcpy(iv, input.data(), headerSize);
+    const uint8_t* body = input.data() + headerSize;
+    const uint8_t* outputEnd = output.data() + bodyLength;
+    if (body != output.data() && body < outputEnd && output.data() < body + bodyLength) {
+        std::memmove(output.data(), body, bodyLength);
+        body = output.data();
+    }
+    ModeFile::decryptChunk(cipher, mode, iv, FileChunk{output.data(), body, bodyLength, 0, nullptr});
+
+    written = bodyLength;
+    if (padded) {
+        size_t padLen = output[bodyLength - 1];
+        if (padLen == 0 || padLen > B) {
+            std::cerr << "Error: Invalid padding (wrong key or corrupted data)." << std::endl;
+            return false;
+        }
+        written -= padLen;
+    }
+    return true;
+}
+
+// Vector forms of the above for callers that own their buffers, e.g. ModeTree
+template <class Cipher>
+void encryptBufferWithMode(const Cipher& cipher, CipherMode mode, const uint8_t* data, size_t length,
+                           std::vector<uint8_t>& output) {
+    size_t written = 0;
+    output.resize(ModeFile::encryptedSize(mode, Cipher::BLOCK_SIZE, length));
+    encryptBufferWithMode(cipher, mode, std::span<const uint8_t>(data, length), std::span<uint8_t>(output), written);
+}
+
+template <class Cipher>
+bool decryptBufferWithMode(const Cipher& cipher, CipherMode mode, const uint8_t* data, size_t length,
+                           std::vector<uint8_t>& output) {
+    size_t written = 0;
+    output.resize(length);
+    if (!decryptBufferWithMode(cipher, mode, std::span<const uint8_t>(data, length), std::span<uint8_t>(output),
+                               written)) {
+        return false;
+    }
+    output.resize(written);
+    return true;
+}
+
+template <class Cipher>
+bool encryptFileWithMode(const Cipher& cipher, CipherMode mode, const std::string& inputFile,
+                         const std::string& outputFile, size_t threads, IOBackend io = IOBackend::Auto,
+                         size_t processes = 1) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    std::vector<uint8_t> iv = ModeFile::hasIV(mode) ? ModeFile::randomIV(B) : std::vector<uint8_t>();
+    bool padded = ModeFile::isPadded(mode);
+
+    BlockModes::CBCState<Cipher> cbc;
+    if (mode == CipherMode::CBC) {
+        std::memcpy(cbc.chain, iv.data(), B);
+    }
+    ChunkTransform transform = [&](const FileChunk& chunk) {
+        ModeFile::encryptChunk(cipher, mode, iv.data(), cbc, chunk);
+    };
+
+    if (isStandardStream(inputFile) || isStandardStream(outputFile)) {
+        return encryptStandardStream(inputFile, outputFile, B, transform, iv, padded);
+    }
+    if (processes > 1 && mode != CipherMode::CBC) {
+        return encryptFileSharded(inputFile, outputFile, B, processes, transform, iv, padded);
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1 && mode != CipherMode::CBC && io != IOBackend::Pipeline) {
+        pool = std::make_unique<ThreadPool>(threads - 1);
+    }
+
+    if (io == IOBackend::Auto || io == IOBackend::Mapped) {
+        MappedIO mapped = encryptFileMapped(inputFile, outputFile, B, pool.get(), transform, iv, padded,
+                                            ModeFile::mappingThreshold(io));
+        if (mapped != MappedIO::NotMapped) {
+            return mapped == MappedIO::Done;
+        }
+    }
+    if (ModeFile::usePipeline(io, pool.get())) {
+        PipelineStats stats;
+        bool ok = encryptFilePipelined(inputFile, outputFile, B, transform, iv, padded, &stats);
+        if (ok && stats.backend && Stats::enabled()) {
+            printPipelineStats(stats);
+        }
+        return ok;
+    }
+    if (pool) {
+        return encryptFileParallel(inputFile, outputFile, B, *pool, transform, iv, padded);
+    }
+    return encryptFileStream(inputFile, outputFile, B, transform, iv, padded);
+}
+
+template <class Cipher>
+bool decryptFileWithMode(const Cipher& cipher, CipherMode mode, const std::string& inputFile,
+                         const std::string& outputFile, size_t threads, IOBackend io = IOBackend::Auto,
+                         size_t processes = 1) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    bool padded = ModeFile::isPadded(mode);
+    size_t headerSize = ModeFile::hasIV(mode) ? B : 0;
+
+    uint8_t iv[B] = {};
+    ChunkTransform transform = [&](const FileChunk& chunk) {
+        ModeFile::decryptChunk(cipher, mode, iv, chunk);
+    };
+
+    // A pipe cannot be read twice, so the stream reads the IV itself
+    if (isStandardStream(inputFile) || isStandardStream(outputFile)) {
+        return decryptStandardStream(inputFile, outputFile, B, transform, iv, headerSize, padded);
+    }
+
+    std::ifstream input(inputFile, std::ios::binary);
+    if (!input) {
+        std::cerr << "Error: Could not open input file " << inputFile << std::endl;
+        return false;
+    }
+    if (!input.read(reinterpret_cast<char*>(iv), static_cast<std::streamsize>(headerSize))) {
+        std::cerr << "Error: Ciphertext is too short to contain an IV." << std::endl;
+        return false;
+    }
+
+    if (processes > 1) {
+        return decryptFileSharded(inputFile, outputFile, B, processes, transform, headerSize, padded);
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1 && io != IOBackend::Pipeline) {
+        pool = std::make_unique<ThreadPool>(threads - 1);
+    }
+
+    if (io == IOBackend::Auto || io == IOBackend::Mapped) {
+        MappedIO mapped = decryptFileMapped(inputFile, outputFile, B, pool.get(), transform, headerSize, padded,
+                                            ModeFile::mappingThreshold(io));
+        if (mapped != MappedIO::NotMapped) {
+            return mapped == MappedIO::Done;
+        }
+    }
+    if (ModeFile::usePipeline(io, pool.get())) {
+        PipelineStats stats;
+        bool ok = decryptFilePipelined(inputFile, outputFile, B, transform, headerSize, padded, &stats);
+        if (ok && stats.backend && Stats::enabled()) {
+            printPipelineStats(stats);
+        }
+        return ok;
+    }
+    if (pool) {
+        return decryptFileParallel(inputFile, outputFile, B, *pool, transform, headerSize, padded);
+    }
+    return decryptFileStream(inputFile, outputFile, B, transform, headerSize, padded);
+}
+
+// Encrypt or decrypt `file` in place, or roll back its interrupted job (`operation`).
+// Runs on one thread: every chunk is synced to the disk twice, which outweighs the cipher.
+template <class Cipher>
+bool processFileInPlaceWithMode(const Cipher& cipher, ContainerCipher id, CipherMode mode, const std::string& file,
+                                InPlaceOperation operation) {
+    constexpr size_t B = Cipher::BLOCK_SIZE;
+    uint8_t iv[B] = {};
+    if (ModeFile::hasIV(mode)) {
+        ModeFile::randomIV(iv, B);
+    }
+
+    // A checksum of the encrypted zero block tells keys apart in the journal
+    uint8_t zero[B] = {};
+    BlockModes::ecbEncrypt(cipher, FileChunk{zero, zero, B, 0, nullptr});
+
+    InPlaceCipher job;
+    job.cipher = static_cast<uint8_t>(id);
+    job.mode = static_cast<uint8_t>(mode);
+    job.blockSize = B;
+    job.hasIV = ModeFile::hasIV(mode);
+    job.padded = ModeFile::isPadded(mode);
+    job.keyCheck = crc32c(zero, B);
+    job.iv = iv;
+    job.encrypt = [&](const FileChunk& chunk) {
+        BlockModes::CBCState<Cipher> cbc;
+        std::memcpy(cbc.chain, chunk.previous ? chunk.previous : iv, B);
+        ModeFile::encryptChunk(cipher, mode, iv, cbc, chunk);
+    };
+    job.decrypt = [&](const FileChunk& chunk) {
+        ModeFile::decryptChunk(cipher, mode, iv, chunk);
+    };
+    return processFileInPlace(file, operation, job);
+}
+
+#endif // MODE_FILE_H
@@ -0,0 +1,98 @@
+#ifndef MODE_TREE_H
+#define MODE_TREE_H
+
+/**
+ * @file ModeTree.h
+ * @brief Directory encryption and decryption (--recursive) with a block cipher.
+ *
+ * The caller builds the cipher, and with it the round keys, once; every file in the
+ * tree then reuses it. Files are spread over `threads` threads by processTree
+ * (util/io/DirectoryTree.h), each file on a single thread: files below
+ * MAPPED_IO_MIN_SIZE are read, transformed and written in one piece, larger ones go
+ * through encryptFileWithMode / decryptFileWithMode with the chosen I/O backend. Each
+ * output file has the same format as a single-file job.
+ */
+
+#include "ModeFile.h"
+#include "../../io/DirectoryTree.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace ModeTree {
+
+// Read a small file whole into a buffer reused by the calling thread
+inline bool readWhole(const TreeFile& file, std::vector<uint8_t>& data) {
+    StageTimer timer(Stage::Read, file.size);
+    std::ifstream input(file.input, std::ios::binary);
+    if (!input) {
+        std::cerr << "Error: Could not open input file " << file.input << std::endl;
+        return false;
+    }
+    data.resize(static_cast<size_t>(file.size));
+    input.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    data.resize(static_cast<size_t>(input.gcount()));
+    return !input.bad();
+}
+
+inline bool writeWhole(const std::string& outputFile, const std::vector<uint8_t>& data) {
+    StageTimer timer(Stage::Write, data.size());
+    std::ofstream output(outputFile, std::ios::binary);
+    if (!output) {
+        std::cerr << "Error: Could not open output file " << outputFile << std::endl;
+        return false;
+    }
+    output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!output) {
+        std::cerr << "Error: Failed to write output data." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace ModeTree
+
+template <class Cipher>
+bool encryptTreeWithMode(const Cipher& cipher, CipherMode mode, const std::string& inputDir,
+                         const std::string& outputDir, size_t threads, IOBackend io) {
+    std::vector<TreeFile> files;
+    if (!collectTree(inputDir, outputDir, files)) {
+        return false;
+    }
+    TreeResult result = processTree(files, threads, [&](const TreeFile& file) {
+        if (file.size >= MAPPED_IO_MIN_SIZE) {
+            return encryptFileWithMode(cipher, mode, file.input, file.output, 1, io);
+        }
+        thread_local std::vector<uint8_t> data, output;
+        if (!ModeTree::readWhole(file, data)) {
+            return false;
+        }
+        encryptBufferWithMode(cipher, mode, data.data(), data.size(), output);
+        return ModeTree::writeWhole(file.output, output);
+    });
+    printTreeResult("Encrypted", result);
+    return result.failed == 0;
+}
+
+template <class Cipher>
+bool decryptTreeWithMode(const Cipher& cipher, CipherMode mode, const std::string& inputDir,
+                         const std::string& outputDir, size_t threads, IOBackend io) {
+    std::vector<TreeFile> files;
+    if (!collectTree(inputDir, outputDir, files)) {
+        return false;
+    }
+    TreeResult result = processTree(files, threads, [&](const TreeFile& file) {
+        if (file.size >= MAPPED_IO_MIN_SIZE) {
+            return decryptFileWithMode(cipher, mode, file.input, file.output, 1, io);
+        }
+        thread_local std::vector<uint8_t> data, output;
+        return ModeTree::readWhole(file, data) &&
+               decryptBufferWithMode(cipher, mode, data.data(), data.size(), output) &&
+               ModeTree::writeWhole(file.output, output);
+    });
+    printTreeResult("Decrypted", result);
+    return result.failed == 0;
+}
+
+#endif // MODE_TREE_H
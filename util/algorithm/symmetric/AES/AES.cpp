@@ -0,0 +1,57 @@
+/**
+ * @file AES.cpp
+ * @brief AES (FIPS 197) file encryption and decryption.
+ *
+ * The key is given as hex: 32, 48 or 64 digits for AES-128, AES-192 or AES-256. It is
+ * expanded once and reused until the key changes; the blocks run on AES-NI (AESNI.cpp)
+ * when the CPU supports it and on the portable lookup tables (AESCore.cpp) otherwise,
+ * chosen at runtime. Files and buffers go through the modes layer in
+ * util/algorithm/modes with 16-byte blocks, so --mode and --threads work as for DES.
+ */
+
+#include "AES.h"
+#include "AESBlockCipher.h"
+#include <cctype>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Decode the hex key into bytes; false if it is not 32, 48 or 64 hex digits
+bool parseAESKey(const std::string& key, std::vector<uint8_t>& bytes) {
+    if (key.size() != 32 && key.size() != 48 && key.size() != 64) {
+        return false;
+    }
+    for (char c : key) {
+        if (!std::isxdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+    }
+    auto nibble = [](char c) {
+        return std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : std::tolower(static_cast<unsigned char>(c)) - 'a' + 10;
+    };
+    bytes.clear();
+    for (size_t i = 0; i < key.size(); i += 2) {
+        bytes.push_back(static_cast<uint8_t>(nibble(key[i]) << 4 | nibble(key[i + 1])));
+    }
+    return true;
+}
+
+} // namespace
+
+bool AES::makeCipher(const std::string& key, AESBlockCipher& cipher) const {
+    std::vector<uint8_t> bytes;
+    if (!parseAESKey(key, bytes) || !expandAESKey(bytes.data(), bytes.size(), cipher.schedule)) {
+        std::cerr << "Error: AES key must be 32, 48 or 64 hex digits (AES-128, AES-192 or AES-256)." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const char* AES::algorithmName() const {
+    return "AES";
+}
+
+const char* AES::implementationName() const {
+    return aesHardwareAccelerated() ? "AES-NI" : "software";
+}
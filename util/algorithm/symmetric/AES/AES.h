@@ -0,0 +1,16 @@
+#ifndef AES_H
+#define AES_H
+
+#include "../../BlockCipherAlgorithm.h"
+#include "AESBlockCipher.h"
+#include <string>
+
+// Advanced Encryption Standard with 128, 192 or 256-bit keys
+class AES : public BlockCipherAlgorithm<AESBlockCipher, ContainerCipher::AES> {
+protected:
+    bool makeCipher(const std::string& key, AESBlockCipher& cipher) const override;
+    const char* algorithmName() const override;
+    const char* implementationName() const override;
+};
+
+#endif // AES_H
@@ -0,0 +1,34 @@
+#ifndef AES_BLOCK_CIPHER_H
+#define AES_BLOCK_CIPHER_H
+
+#include "AESCore.h"
+#include <cstddef>
+#include <cstdint>
+
+// AES bound to an expanded key, in the shape the modes of operation expect
+// (see util/algorithm/modes/BlockModes.h)
+// It is also the prepared key context kept in KeyCache, aligned to a cache line so
+// the round keys span as few lines as possible.
+struct alignas(64) AESBlockCipher {
+    static constexpr size_t BLOCK_SIZE = 16;
+
+    AESKeySchedule schedule;
+
+    void encryptBlock(const uint8_t* in, uint8_t* out) const {
+        aesEncryptBlocks(in, out, 1, schedule);
+    }
+
+    void decryptBlock(const uint8_t* in, uint8_t* out) const {
+        aesDecryptBlocks(in, out, 1, schedule);
+    }
+
+    void encryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const {
+        aesEncryptBlocks(in, out, blocks, schedule);
+    }
+
+    void decryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const {
+        aesDecryptBlocks(in, out, blocks, schedule);
+    }
+};
+
+#endif // AES_BLOCK_CIPHER_H
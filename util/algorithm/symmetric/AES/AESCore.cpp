@@ -0,0 +1,235 @@
+/**
+ * @file AESCore.cpp
+ * @brief AES key expansion, the portable table-driven cipher and runtime dispatch.
+ *
+ * The software path is the classic "T-table" implementation: SubBytes, ShiftRows and
+ * MixColumns of one column are folded into four 256-entry word tables (and four more for
+ * the inverse cipher), so a round costs sixteen lookups and XORs. The tables are built
+ * from the S-boxes in AESTables.h when the program starts.
+ *
+ * On CPUs with AES-NI, aesEncryptBlocks and aesDecryptBlocks run the kernels in AESNI.cpp
+ * instead; both paths share the same AESKeySchedule.
+ */
+
+#include "AESCore.h"
+#include "AESTables.h"
+#include "../../../cpu/CpuFeatures.h"
+#include <bit>
+#include <cstring>
+
+namespace {
+
+uint8_t xtime(uint8_t a) {
+    return static_cast<uint8_t>((a << 1) ^ ((a & 0x80) ? 0x1B : 0x00));
+}
+
+// Multiplication in GF(2^8)
+uint8_t gmul(uint8_t a, uint8_t b) {
+    uint8_t product = 0;
+    while (b) {
+        if (b & 1) {
+            product ^= a;
+        }
+        a = xtime(a);
+        b >>= 1;
+    }
+    return product;
+}
+
+uint32_t loadWord(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+void storeWord(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+uint32_t subWord(uint32_t word) {
+    return (static_cast<uint32_t>(AESTables::SBOX[word >> 24]) << 24) |
+           (static_cast<uint32_t>(AESTables::SBOX[(word >> 16) & 0xFF]) << 16) |
+           (static_cast<uint32_t>(AESTables::SBOX[(word >> 8) & 0xFF]) << 8) |
+           AESTables::SBOX[word & 0xFF];
+}
+
+// te[0][x] is the MixColumns column of S(x) in row 0; te[k] is the same rotated for row k
+struct AESRoundTables {
+    uint32_t te[4][256];
+    uint32_t td[4][256];
+};
+
+AESRoundTables buildRoundTables() {
+    AESRoundTables tables{};
+    for (int x = 0; x < 256; ++x) {
+        uint8_t s = AESTables::SBOX[x];
+        uint8_t i = AESTables::INV_SBOX[x];
+        uint32_t te = (static_cast<uint32_t>(gmul(s, 2)) << 24) | (static_cast<uint32_t>(s) << 16) |
+                      (static_cast<uint32_t>(s) << 8) | gmul(s, 3);
+        uint32_t td = (static_cast<uint32_t>(gmul(i, 14)) << 24) | (static_cast<uint32_t>(gmul(i, 9)) << 16) |
+                      (static_cast<uint32_t>(gmul(i, 13)) << 8) | gmul(i, 11);
+        for (int k = 0; k < 4; ++k) {
+            tables.te[k][x] = std::rotr(te, 8 * k);
+            tables.td[k][x] = std::rotr(td, 8 * k);
+        }
+    }
+    return tables;
+}
+
+const AESRoundTables ROUND_TABLES = buildRoundTables();
+
+// InvMixColumns of one column: td[k][x] is InvMixColumns of InvSubBytes(x) in row k, so
+// feeding it S(b) leaves the plain InvMixColumns of b
+uint32_t invMixColumn(uint32_t word) {
+    const uint8_t* sbox = AESTables::SBOX;
+    return ROUND_TABLES.td[0][sbox[word >> 24]] ^ ROUND_TABLES.td[1][sbox[(word >> 16) & 0xFF]] ^
+           ROUND_TABLES.td[2][sbox[(word >> 8) & 0xFF]] ^ ROUND_TABLES.td[3][sbox[word & 0xFF]];
+}
+
+void encryptBlock(const uint8_t* in, uint8_t* out, const AESKeySchedule& schedule) {
+    const uint32_t (*te)[256] = ROUND_TABLES.te;
+    const uint8_t (*rk)[16] = schedule.encrypt;
+    uint32_t s0 = loadWord(in) ^ loadWord(rk[0]);
+    uint32_t s1 = loadWord(in + 4) ^ loadWord(rk[0] + 4);
+    uint32_t s2 = loadWord(in + 8) ^ loadWord(rk[0] + 8);
+    uint32_t s3 = loadWord(in + 12) ^ loadWord(rk[0] + 12);
+
+    for (int round = 1; round < schedule.rounds; ++round) {
+        uint32_t t0 = te[0][s0 >> 24] ^ te[1][(s1 >> 16) & 0xFF] ^ te[2][(s2 >> 8) & 0xFF] ^ te[3][s3 & 0xFF];
+        uint32_t t1 = te[0][s1 >> 24] ^ te[1][(s2 >> 16) & 0xFF] ^ te[2][(s3 >> 8) & 0xFF] ^ te[3][s0 & 0xFF];
+        uint32_t t2 = te[0][s2 >> 24] ^ te[1][(s3 >> 16) & 0xFF] ^ te[2][(s0 >> 8) & 0xFF] ^ te[3][s1 & 0xFF];
+        uint32_t t3 = te[0][s3 >> 24] ^ te[1][(s0 >> 16) & 0xFF] ^ te[2][(s1 >> 8) & 0xFF] ^ te[3][s2 & 0xFF];
+        s0 = t0 ^ loadWord(rk[round]);
+        s1 = t1 ^ loadWord(rk[round] + 4);
+        s2 = t2 ^ loadWord(rk[round] + 8);
+        s3 = t3 ^ loadWord(rk[round] + 12);
+    }
+
+    // Last round: no MixColumns
+    const uint8_t* sbox = AESTables::SBOX;
+    const uint8_t* last = rk[schedule.rounds];
+    uint32_t columns[4] = {s0, s1, s2, s3};
+    for (int c = 0; c < 4; ++c) {
+        uint32_t word = (static_cast<uint32_t>(sbox[columns[c] >> 24]) << 24) |
+                        (static_cast<uint32_t>(sbox[(columns[(c + 1) & 3] >> 16) & 0xFF]) << 16) |
+                        (static_cast<uint32_t>(sbox[(columns[(c + 2) & 3] >> 8) & 0xFF]) << 8) |
+                        sbox[columns[(c + 3) & 3] & 0xFF];
+        storeWord(out + 4 * c, word ^ loadWord(last + 4 * c));
+    }
+}
+
+void decryptBlock(const uint8_t* in, uint8_t* out, const AESKeySchedule& schedule) {
+    const uint32_t (*td)[256] = ROUND_TABLES.td;
+    const uint8_t (*rk)[16] = schedule.decrypt;
+    uint32_t s0 = loadWord(in) ^ loadWord(rk[0]);
+    uint32_t s1 = loadWord(in + 4) ^ loadWord(rk[0] + 4);
+    uint32_t s2 = loadWord(in + 8) ^ loadWord(rk[0] + 8);
+    uint32_t s3 = loadWord(in + 12) ^ loadWord(rk[0] + 12);
+
+    for (int round = 1; round < schedule.rounds; ++round) {
+        uint32_t t0 = td[0][s0 >> 24] ^ td[1][(s3 >> 16) & 0xFF] ^ td[2][(s2 >> 8) & 0xFF] ^ td[3][s1 & 0xFF];
+        uint32_t t1 = td[0][s1 >> 24] ^ td[1][(s0 >> 16) & 0xFF] ^ td[2][(s3 >> 8) & 0xFF] ^ td[3][s2 & 0xFF];
+        uint32_t t2 = td[0][s2 >> 24] ^ td[1][(s1 >> 16) & 0xFF] ^ td[2][(s0 >> 8) & 0xFF] ^ td[3][s3 & 0xFF];
+        uint32_t t3 = td[0][s3 >> 24] ^ td[1][(s2 >> 16) & 0xFF] ^ td[2][(s1 >> 8) & 0xFF] ^ td[3][s0 & 0xFF];
+        s0 = t0 ^ loadWord(rk[round]);
+        s1 = t1 ^ loadWord(rk[round] + 4);
+        s2 = t2 ^ loadWord(rk[round] + 8);
+        s3 = t3 ^ loadWord(rk[round] + 12);
+    }
+
+    // Last round: no InvMixColumns
+    const uint8_t* sbox = AESTables::INV_SBOX;
+    const uint8_t* last = rk[schedule.rounds];
+    uint32_t columns[4] = {s0, s1, s2, s3};
+    for (int c = 0; c < 4; ++c) {
+        uint32_t word = (static_cast<uint32_t>(sbox[columns[c] >> 24]) << 24) |
+                        (static_cast<uint32_t>(sbox[(columns[(c + 3) & 3] >> 16) & 0xFF]) << 16) |
+                        (static_cast<uint32_t>(sbox[(columns[(c + 2) & 3] >> 8) & 0xFF]) << 8) |
+                        sbox[columns[(c + 1) & 3] & 0xFF];
+        storeWord(out + 4 * c, word ^ loadWord(last + 4 * c));
+    }
+}
+
+using BlockKernel = void (*)(const uint8_t*, uint8_t*, size_t, const AESKeySchedule&);
+
+struct KernelChoice {
+    BlockKernel encrypt;
+    BlockKernel decrypt;
+    bool hardware;
+};
+
+KernelChoice selectKernels() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    if (cpuFeatures().aesni) {
+        return {aesniEncryptBlocks, aesniDecryptBlocks, true};
+    }
+#endif
+    return {aesTableEncryptBlocks, aesTableDecryptBlocks, false};
+}
+
+const KernelChoice& kernels() {
+    static const KernelChoice choice = selectKernels();
+    return choice;
+}
+
+} // namespace
+
+bool expandAESKey(const uint8_t* key, size_t keyLength, AESKeySchedule& schedule) {
+    if (keyLength != 16 && keyLength != 24 && keyLength != 32) {
+        return false;
+    }
+    int nk = static_cast<int>(keyLength / 4);
+    schedule.rounds = nk + 6;
+    int total = 4 * (schedule.rounds + 1);
+
+    uint32_t words[60];
+    for (int i = 0; i < nk; ++i) {
+        words[i] = loadWord(key + 4 * i);
+    }
+    for (int i = nk; i < total; ++i) {
+        uint32_t temp = words[i - 1];
+        if (i % nk == 0) {
+            temp = subWord(std::rotl(temp, 8)) ^ (static_cast<uint32_t>(AESTables::RCON[i / nk - 1]) << 24);
+        } else if (nk > 6 && i % nk == 4) {
+            temp = subWord(temp);
+        }
+        words[i] = words[i - nk] ^ temp;
+    }
+
+    for (int round = 0; round <= schedule.rounds; ++round) {
+        int from = schedule.rounds - round;
+        bool inner = round > 0 && round < schedule.rounds;
+        for (int c = 0; c < 4; ++c) {
+            storeWord(schedule.encrypt[round] + 4 * c, words[4 * round + c]);
+            uint32_t word = words[4 * from + c];
+            storeWord(schedule.decrypt[round] + 4 * c, inner ? invMixColumn(word) : word);
+        }
+    }
+    return true;
+}
+
+void aesTableEncryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule) {
+    for (size_t i = 0; i < blocks; ++i) {
+        encryptBlock(in + i * 16, out + i * 16, schedule);
+    }
+}
+
+void aesTableDecryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule) {
+    for (size_t i = 0; i < blocks; ++i) {
+        decryptBlock(in + i * 16, out + i * 16, schedule);
+    }
+}
+
+void aesEncryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule) {
+    kernels().encrypt(in, out, blocks, schedule);
+}
+
+void aesDecryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule) {
+    kernels().decrypt(in, out, blocks, schedule);
+}
+
+bool aesHardwareAccelerated() {
+    return kernels().hardware;
+}
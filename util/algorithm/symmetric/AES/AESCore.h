@@ -0,0 +1,36 @@
+#ifndef AES_CORE_H
+#define AES_CORE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Expanded AES key. Round keys are stored as 16 bytes in block order, so the AES-NI
+// kernels load them directly and the table path reads them as big-endian columns.
+// `decrypt` holds the keys of the equivalent inverse cipher (FIPS 197, 5.3.5): the
+// encryption keys in reverse order with InvMixColumns applied to the inner ones.
+struct AESKeySchedule {
+    alignas(16) uint8_t encrypt[15][16];
+    alignas(16) uint8_t decrypt[15][16];
+    int rounds;  // 10, 12 or 14 for 128, 192 or 256-bit keys
+};
+
+// Expand a 16, 24 or 32-byte key; returns false for any other length
+bool expandAESKey(const uint8_t* key, size_t keyLength, AESKeySchedule& schedule);
+
+// Encrypt/decrypt `blocks` consecutive 16-byte blocks with AES-NI when the CPU has it
+// and with the lookup tables otherwise; `in` and `out` may alias
+void aesEncryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule);
+void aesDecryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule);
+
+// True when aesEncryptBlocks/aesDecryptBlocks run on AES-NI
+bool aesHardwareAccelerated();
+
+// Portable table-driven implementation (AESCore.cpp)
+void aesTableEncryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule);
+void aesTableDecryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule);
+
+// AES-NI implementation, 8 blocks in flight (AESNI.cpp, x86 only)
+void aesniEncryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule);
+void aesniDecryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule);
+
+#endif // AES_CORE_H
@@ -0,0 +1,91 @@
+/**
+ * @file AESNI.cpp
+ * @brief AES kernels on the AES-NI instructions.
+ *
+ * AESENC/AESDEC have a latency of several cycles but can start a new round every cycle,
+ * so eight independent blocks are kept in flight: each round key is applied to all
+ * eight before moving on to the next round. Blocks left over at the end go one by one.
+ * Only called after CPU detection (see AESCore.cpp).
+ */
+
+#include "AESCore.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("aes,sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("aes,sse2")
+#endif
+
+namespace {
+
+constexpr size_t PIPELINE_BLOCKS = 8;
+
+template <bool Decrypt>
+inline __m128i middleRound(__m128i block, __m128i key) {
+    return Decrypt ? _mm_aesdec_si128(block, key) : _mm_aesenc_si128(block, key);
+}
+
+template <bool Decrypt>
+inline __m128i lastRound(__m128i block, __m128i key) {
+    return Decrypt ? _mm_aesdeclast_si128(block, key) : _mm_aesenclast_si128(block, key);
+}
+
+template <bool Decrypt>
+void processBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule) {
+    const uint8_t (*roundKeys)[16] = Decrypt ? schedule.decrypt : schedule.encrypt;
+    const int rounds = schedule.rounds;
+    __m128i keys[15];
+    for (int round = 0; round <= rounds; ++round) {
+        keys[round] = _mm_load_si128(reinterpret_cast<const __m128i*>(roundKeys[round]));
+    }
+
+    size_t i = 0;
+    for (; i + PIPELINE_BLOCKS <= blocks; i += PIPELINE_BLOCKS) {
+        __m128i state[PIPELINE_BLOCKS];
+        for (size_t j = 0; j < PIPELINE_BLOCKS; ++j) {
+            state[j] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + (i + j) * 16)), keys[0]);
+        }
+        for (int round = 1; round < rounds; ++round) {
+            for (size_t j = 0; j < PIPELINE_BLOCKS; ++j) {
+                state[j] = middleRound<Decrypt>(state[j], keys[round]);
+            }
+        }
+        for (size_t j = 0; j < PIPELINE_BLOCKS; ++j) {
+            state[j] = lastRound<Decrypt>(state[j], keys[rounds]);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (i + j) * 16), state[j]);
+        }
+    }
+
+    for (; i < blocks; ++i) {
+        __m128i state = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 16)), keys[0]);
+        for (int round = 1; round < rounds; ++round) {
+            state = middleRound<Decrypt>(state, keys[round]);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 16), lastRound<Decrypt>(state, keys[rounds]));
+    }
+}
+
+} // namespace
+
+void aesniEncryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule) {
+    processBlocks<false>(in, out, blocks, schedule);
+}
+
+void aesniDecryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const AESKeySchedule& schedule) {
+    processBlocks<true>(in, out, blocks, schedule);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -19,6 +19,9 @@
  *    - A 64-bit encryption key is processed through Permuted Choice 1 (PC-1) to produce a 56-bit key.
  *    - The key is split into two 28-bit halves, and 16 different round keys are generated through 
  *      circular left shifts and Permuted Choice 2 (PC-2).
+ *    - generateRoundKeys returns the round keys as bitsets. DES::encrypt and friends use
+ *      expandDESKey (DESCore.cpp), which yields the same keys already packed for the
+ *      round function, and keep recently used keys in a KeyCache.
  *
  * 3. **16 Rounds of Feistel Structure**:
  *    - In each round:
@@ -36,6 +39,12 @@
  * 5. **Encryption/Decryption of Files**:
  *    - If the input data (e.g., a file) is not a multiple of 64 bits, padding is added to ensure all 
  *      blocks are 64 bits. This padding is removed after decryption.
+ *    - Files are streamed through a fixed-size chunk buffer (see util/io/BlockStream.h), so
+ *      memory use does not grow with the file size.
+ *    - With more than one thread, chunks are encrypted on a work-stealing thread pool and
+ *      written back with positional writes (see util/io/ParallelFile.h).
+ *    - The mode of operation (ECB, CBC or CTR) is applied by the generic modes layer in
+ *      util/algorithm/modes over DESBlockCipher.
  *
  * 6. **Decryption**:
  *    - Decryption is performed using the same process as encryption, but the round keys are applied in 
@@ -57,151 +66,53 @@
  * - generateRoundKeys
  * - desRound
  * - encryptBlock, decryptBlock
- * - padData, unpadData
  * - encryptFile, decryptFile
  *
+ * The std::bitset helpers above are the reference implementation. The permutations
+ * among them (IP, FP, E, P, PC-1 and PC-2) are one lookup per byte in tables generated
+ * at compile time and checked against the bit-by-bit definitions (DESPermutation.h).
+ * File encryption and decryption run on the bitsliced SIMD kernels in DESBitslice.cpp
+ * for bulk data and on the table-driven core in DESCore.cpp for the remaining blocks;
+ * both produce identical blocks.
+ *
  * @author Alexander DeJesus
  * @date 10/21/2024
  */
 
 #include "DES.h"
+#include "DESBlockCipher.h"
+#include "DESCore.h"
+#include "DESPermutation.h"
+#include "DESTables.h"
 #include <bitset>
+#include <cctype>
 #include <vector>
 #include <fstream>
 #include <iostream>
 #include <cstdint>
 
-// Permutation and Transformation Functions
-std::bitset<64> initialPermutation(const std::bitset<64>& block);
-std::bitset<64> finalPermutation(const std::bitset<64>& block);
-std::bitset<48> expansion(const std::bitset<32>& half);
-std::bitset<32> pBoxPermutation(const std::bitset<32>& input);
-std::bitset<32> sBoxSubstitution(const std::bitset<48>& input);
-
-// XOR Operation with Round Key
-std::bitset<48> xorWithKey(const std::bitset<48>& expandedHalf, const std::bitset<48>& roundKey);
-
-// Key Scheduling Functions
-std::vector<std::bitset<48>> generateRoundKeys(const std::bitset<64>& key);
-std::bitset<28> leftCircularShift(const std::bitset<28>& half, int shift);
-
-// Block Processing Functions
-void splitBlock(const std::bitset<64>& block, std::bitset<32>& left, std::bitset<32>& right);
-void desRound(std::bitset<32>& left, std::bitset<32>& right, const std::bitset<48>& roundKey);
-std::bitset<64> combineBlock(const std::bitset<32>& left, const std::bitset<32>& right);
-
-// Core Encryption and Decryption Functions
-std::bitset<64> encryptBlock(const std::bitset<64>& block, const std::vector<std::bitset<48>>& roundKeys);
-std::bitset<64> decryptBlock(const std::bitset<64>& block, const std::vector<std::bitset<48>>& roundKeys);
-
-// Padding Functions (for non-64-bit multiple inputs)
-std::string padData(const std::string& data);
-std::string unpadData(const std::string& data);
-
 // File Handling Functions
 void encryptFile(const std::string& inputFile, const std::string& outputFile, const std::bitset<64>& key);
 void decryptFile(const std::string& inputFile, const std::string& outputFile, const std::bitset<64>& key);
 
 std::bitset<64> initialPermutation(const std::bitset<64>& block) {
-    static const int IP[64] = {
-        58, 50, 42, 34, 26, 18, 10,  2,
-        60, 52, 44, 36, 28, 20, 12,  4,
-        62, 54, 46, 38, 30, 22, 14,  6,
-        64, 56, 48, 40, 32, 24, 16,  8,
-        57, 49, 41, 33, 25, 17,  9,  1,
-        59, 51, 43, 35, 27, 19, 11,  3,
-        61, 53, 45, 37, 29, 21, 13,  5,
-        63, 55, 47, 39, 31, 23, 15,  7
-    };
-    std::bitset<64> permuted;
-    for (int i = 0; i < 64; ++i) {
-        permuted[63 - i] = block[64 - IP[i]];
-    }
-    return permuted;
+    return std::bitset<64>(DESPermutation::IP(block.to_ullong()));
 }
 
 std::bitset<64> finalPermutation(const std::bitset<64>& block) {
-    static const int FP[64] = {
-        40,  8, 48, 16, 56, 24, 64, 32,
-        39,  7, 47, 15, 55, 23, 63, 31,
-        38,  6, 46, 14, 54, 22, 62, 30,
-        37,  5, 45, 13, 53, 21, 61, 29,
-        36,  4, 44, 12, 52, 20, 60, 28,
-        35,  3, 43, 11, 51, 19, 59, 27,
-        34,  2, 42, 10, 50, 18, 58, 26,
-        33,  1, 41,  9, 49, 17, 57, 25
-    };
-    std::bitset<64> permuted;
-    for (int i = 0; i < 64; ++i) {
-        permuted[63 - i] = block[64 - FP[i]];
-    }
-    return permuted;
+    return std::bitset<64>(DESPermutation::FP(block.to_ullong()));
 }
 
 std::bitset<48> expansion(const std::bitset<32>& half) {
-    static const int E[48] = {
-        32,  1,  2,  3,  4,  5,
-         4,  5,  6,  7,  8,  9,
-         8,  9, 10, 11, 12, 13,
-        12, 13, 14, 15, 16, 17,
-        16, 17, 18, 19, 20, 21,
-        20, 21, 22, 23, 24, 25,
-        24, 25, 26, 27, 28, 29,
-        28, 29, 30, 31, 32,  1
-    };
-    std::bitset<48> expanded;
-    for (int i = 0; i < 48; ++i) {
-        expanded[47 - i] = half[32 - E[i]];
-    }
-    return expanded;
+    return std::bitset<48>(DESPermutation::E(half.to_ullong()));
 }
 
 std::bitset<32> sBoxSubstitution(const std::bitset<48>& input) {
-    static const int S[8][4][16] = {{{14, 4, 13, 1, 2, 15, 11, 8, 3, 10, 6, 12, 5, 9, 0, 7},
-         {0, 15, 7, 4, 14, 2, 13, 1, 10, 6, 12, 11, 9, 5, 3, 8},
-         {4, 1, 14, 8, 13, 6, 2, 11, 15, 12, 9, 7, 3, 10, 5, 0},
-         {15, 12, 8, 2, 4, 9, 1, 7, 5, 11, 3, 14, 10, 0, 6, 13}},
- 
-        {{15, 1, 8, 14, 6, 11, 3, 4, 9, 7, 2, 13, 12, 0, 5, 10},
-         {3, 13, 4, 7, 15, 2, 8, 14, 12, 0, 1, 10, 6, 9, 11, 5},
-         {0, 14, 7, 11, 10, 4, 13, 1, 5, 8, 12, 6, 9, 3, 2, 15},
-         {13, 8, 10, 1, 3, 15, 4, 2, 11, 6, 7, 12, 0, 5, 14, 9}},
- 
-        {{10, 0, 9, 14, 6, 3, 15, 5, 1, 13, 12, 7, 11, 4, 2, 8},
-         {13, 7, 0, 9, 3, 4, 6, 10, 2, 8, 5, 14, 12, 11, 15, 1},
-         {13, 6, 4, 9, 8, 15, 3, 0, 11, 1, 2, 12, 5, 10, 14, 7},
-         {1, 10, 13, 0, 6, 9, 8, 7, 4, 15, 14, 3, 11, 5, 2, 12}},
- 
-        {{7, 13, 14, 3, 0, 6, 9, 10, 1, 2, 8, 5, 11, 12, 4, 15},
-         {13, 8, 11, 5, 6, 15, 0, 3, 4, 7, 2, 12, 1, 10, 14, 9},
-         {10, 6, 9, 0, 12, 11, 7, 13, 15, 1, 3, 14, 5, 2, 8, 4},
-         {3, 15, 0, 6, 10, 1, 13, 8, 9, 4, 5, 11, 12, 7, 2, 14}},
- 
-        {{2, 12, 4, 1, 7, 10, 11, 6, 8, 5, 3, 15, 13, 0, 14, 9},
-         {14, 11, 2, 12, 4, 7, 13, 1, 5, 0, 15, 10, 3, 9, 8, 6},
-         {4, 2, 1, 11, 10, 13, 7, 8, 15, 9, 12, 5, 6, 3, 0, 14},
-         {11, 8, 12, 7, 1, 14, 2, 13, 6, 15, 0, 9, 10, 4, 5, 3}},
- 
-        {{12, 1, 10, 15, 9, 2, 6, 8, 0, 13, 3, 4, 14, 7, 5, 11},
-         {10, 15, 4, 2, 7, 12, 9, 5, 6, 1, 13, 14, 0, 11, 3, 8},
-         {9, 14, 15, 5, 2, 8, 12, 3, 7, 0, 4, 10, 1, 13, 11, 6},
-         {4, 3, 2, 12, 9, 5, 15, 10, 11, 14, 1, 7, 6, 0, 8, 13}},
- 
-        {{4, 11, 2, 14, 15, 0, 8, 13, 3, 12, 9, 7, 5, 10, 6, 1},
-         {13, 0, 11, 7, 4, 9, 1, 10, 14, 3, 5, 12, 2, 15, 8, 6},
-         {1, 4, 11, 13, 12, 3, 7, 14, 10, 15, 6, 8, 0, 5, 9, 2},
-         {6, 11, 13, 8, 1, 4, 10, 7, 9, 5, 0, 15, 14, 2, 3, 12}},
- 
-        {{13, 2, 8, 4, 6, 15, 11, 1, 10, 9, 3, 14, 5, 0, 12, 7},
-         {1, 15, 13, 8, 10, 3, 7, 4, 12, 5, 6, 11, 0, 14, 9, 2},
-         {7, 11, 4, 1, 9, 12, 14, 2, 0, 6, 10, 13, 15, 3, 5, 8},
-         {2, 1, 14, 7, 4, 10, 8, 13, 15, 12, 9, 0, 3, 5, 6, 11}}
-    };
     std::bitset<32> output;
     for (int i = 0; i < 8; ++i) {
         int row = (input[47 - (i * 6)] << 1) + input[47 - (i * 6 + 5)];
         int col = (input[47 - (i * 6 + 1)] << 3) + (input[47 - (i * 6 + 2)] << 2) + (input[47 - (i * 6 + 3)] << 1) + input[47 - (i * 6 + 4)];
-        int val = S[i][row][col];
+        int val = DESTables::S[i][row][col];
         for (int j = 0; j < 4; ++j) {
             output[i * 4 + j] = (val >> j) & 1;
         }
@@ -210,21 +121,7 @@ std::bitset<32> sBoxSubstitution(const std::bitset<48>& input) {
 }
 
 std::bitset<32> pBoxPermutation(const std::bitset<32>& input) {
-    static const int P[32] = {
-        16,  7, 20, 21,
-        29, 12, 28, 17,
-         1, 15, 23, 26,
-         5, 18, 31, 10,
-         2,  8, 24, 14,
-        32, 27,  3,  9,
-        19, 13, 30,  6,
-        22, 11,  4, 25
-    };
-    std::bitset<32> permuted;
-    for (int i = 0; i < 32; ++i) {
-        permuted[31 - i] = input[32 - P[i]];
-    }
-    return permuted;
+    return std::bitset<32>(DESPermutation::P(input.to_ullong()));
 }
 
 std::bitset<48> xorWithKey(const std::bitset<48>& expandedHalf, const std::bitset<48>& roundKey) {
@@ -232,45 +129,23 @@ std::bitset<48> xorWithKey(const std::bitset<48>& expandedHalf, const std::bitse
 }
 
 
-std::vector<std::bitset<48>> generateRoundKeys(const std::bitset<64>& key) {
-    static const int PC1[56] = {
-        57, 49, 41, 33, 25, 17,  9,  1, 58, 50, 42, 34, 26, 18, 10,  2, 59, 51, 43, 35, 27, 19,
-        11,  3, 60, 52, 44, 36, 63, 55, 47, 39, 31, 23, 15,  7, 62, 54, 46, 38, 30, 22, 14,  6,
-        61, 53, 45, 37, 29, 21, 13,  5, 28, 20, 12,  4
-    };
-    static const int PC2[48] = {
-        14, 17, 11, 24,  1,  5,  3, 28, 15,  6, 21, 10, 23, 19, 12,  4, 26,  8, 16,  7, 27, 20, 13,  2,
-        41, 52, 31, 37, 47, 55, 30, 40, 51, 45, 33, 48, 44, 49, 39, 56, 34, 53, 46, 42, 50, 36, 29, 32
-    };
-    static const int shifts[16] = {1, 1, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 1};
-
-    std::bitset<56> permutedKey;
-    for (int i = 0; i < 56; ++i) {
-        permutedKey[55 - i] = key[64 - PC1[i]];
-    }
-
-    std::bitset<28> left, right;
-    for (int i = 0; i < 28; ++i) {
-        left[i] = permutedKey[i + 28];
-        right[i] = permutedKey[i];
-    }
+std::vector<std::bitset<48>> generateRoundKeys(const std::bitset<64>& key, bool standard) {
+    uint64_t permutedKey = DESPermutation::PC1(key.to_ullong());
+    uint32_t left = static_cast<uint32_t>(permutedKey >> 28);
+    uint32_t right = static_cast<uint32_t>(permutedKey) & 0x0FFFFFFFu;
 
     std::vector<std::bitset<48>> roundKeys;
+    roundKeys.reserve(16);
     for (int i = 0; i < 16; ++i) {
-        left = leftCircularShift(left, shifts[i]);
-        right = leftCircularShift(right, shifts[i]);
+        // leftCircularShift turns the halves the opposite way to FIPS 46-3 (towards bit 0);
+        // the original DES file format depends on that, so the standard schedule turns
+        // them back
+        int shift = standard ? 28 - DESTables::SHIFTS[i] : DESTables::SHIFTS[i];
+        left = ((left >> shift) | (left << (28 - shift))) & 0x0FFFFFFFu;
+        right = ((right >> shift) | (right << (28 - shift))) & 0x0FFFFFFFu;
 
-        std::bitset<56> combinedKey;
-        for (int j = 0; j < 28; ++j) {
-            combinedKey[j] = right[j];
-            combinedKey[j + 28] = left[j];
-        }
-
-        std::bitset<48> roundKey;
-        for (int j = 0; j < 48; ++j) {
-            roundKey[47 - j] = combinedKey[56 - PC2[j]];
-        }
-        roundKeys.push_back(roundKey);
+        uint64_t combinedKey = (static_cast<uint64_t>(left) << 28) | right;
+        roundKeys.emplace_back(DESPermutation::PC2(combinedKey));
     }
 
     return roundKeys;
@@ -293,18 +168,6 @@ std::bitset<28> leftCircularShift(const std::bitset<28>& half, int shift) {
     return shifted;
 }
 
-// PKCS#5/7 Padding function for DES encryption
-std::string padData(const std::string& data) {
-    size_t padLen = 8 - (data.size() % 8);  // Calculate padding size (PKCS#5/7)
-    return data + std::string(padLen, static_cast<char>(padLen));  // Append padding
-}
-
-// PKCS#5/7 Unpadding function for DES decryption
-std::string unpadData(const std::string& data) {
-    char padLen = data.back();  // Get the value of the padding
-    return data.substr(0, data.size() - padLen);  // Remove the padding
-}
-
 // Function to encrypt a single 64-bit block using DES
 std::bitset<64> encryptBlock(const std::bitset<64>& block, const std::vector<std::bitset<48>>& roundKeys) {
     std::bitset<64> permutedBlock = initialPermutation(block);
@@ -365,91 +228,22 @@ std::bitset<64> combineBlock(const std::bitset<32>& left, const std::bitset<32>&
     return combined;
 }
 
-// Encrypt function (DES encryption)
-void DES::encrypt(const std::string& inputFile, const std::string& outputFile) {
-    std::cout << "Encrypting " << inputFile << " using DES with key: " << key << std::endl;
-
-    // Open the input file
-    std::ifstream input(inputFile, std::ios::binary);
-    if (!input) {
-        std::cerr << "Error: Could not open input file " << inputFile << std::endl;
-        return;
+// Generate the round keys for a hex key and pack them for the table-driven core
+bool DES::makeCipher(const std::string& key, DESBlockCipher& cipher) const {
+    // The key is a hex number; the packed schedule is built without the bitset helpers.
+    // Every character must be a hex digit: std::stoull alone stops at the first other one.
+    bool hex = !key.empty() && key.size() <= 16;
+    for (char c : key) {
+        hex = hex && std::isxdigit(static_cast<unsigned char>(c));
     }
-
-    // Read input file data into a string
-    std::string fileData((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
-    input.close();
-
-    // Pad the input data to a multiple of 8 bytes (64 bits)
-    std::string paddedData = padData(fileData);
-
-    // Open the output file for writing the encrypted data
-    std::ofstream output(outputFile, std::ios::binary);
-    if (!output) {
-        std::cerr << "Error: Could not open output file " << outputFile << std::endl;
-        return;
+    if (!hex) {
+        std::cerr << "Error: DES key must be a hex number of up to 16 digits." << std::endl;
+        return false;
     }
-
-    // Convert the key to a 64-bit bitset
-    std::bitset<64> keyBits(std::stoull(key, nullptr, 16));  // Assuming key is a hex string
-
-    // Generate round keys
-    std::vector<std::bitset<48>> roundKeys = generateRoundKeys(keyBits);
-
-    // Encrypt each 64-bit block
-    for (size_t i = 0; i < paddedData.size(); i += 8) {
-        uint64_t* blockPtr = reinterpret_cast<uint64_t*>(paddedData.data() + i);  // Correct cast
-        std::bitset<64> block(*blockPtr);
-        std::bitset<64> ciphertext = encryptBlock(block, roundKeys);
-        output.write(reinterpret_cast<const char*>(&ciphertext), sizeof(ciphertext));
-    }
-
-    output.close();
-    std::cout << "Encryption complete. Ciphertext written to " << outputFile << std::endl;
+    expandDESKey(std::stoull(key, nullptr, 16), cipher.schedule);
+    return true;
 }
 
-// Decrypt function (DES decryption)
-void DES::decrypt(const std::string& inputFile, const std::string& outputFile) {
-    std::cout << "Decrypting " << inputFile << " using DES with key: " << key << std::endl;
-
-    // Open the input file
-    std::ifstream input(inputFile, std::ios::binary);
-    if (!input) {
-        std::cerr << "Error: Could not open input file " << inputFile << std::endl;
-        return;
-    }
-
-    // Read input file data into a string
-    std::string fileData((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
-    input.close();
-
-    // Open the output file for writing the decrypted data
-    std::ofstream output(outputFile, std::ios::binary);
-    if (!output) {
-        std::cerr << "Error: Could not open output file " << outputFile << std::endl;
-        return;
-    }
-
-    // Convert the key to a 64-bit bitset
-    std::bitset<64> keyBits(std::stoull(key, nullptr, 16));  // Assuming key is a hex string
-
-    // Generate round keys
-    std::vector<std::bitset<48>> roundKeys = generateRoundKeys(keyBits);
-
-    // Decrypt each 64-bit block
-    std::string decryptedData;
-    for (size_t i = 0; i < fileData.size(); i += 8) {
-        uint64_t* blockPtr = reinterpret_cast<uint64_t*>(fileData.data() + i);  // Correct cast
-        std::bitset<64> block(*blockPtr);
-        std::bitset<64> plaintext = decryptBlock(block, roundKeys);
-        decryptedData.append(reinterpret_cast<const char*>(&plaintext), 8);
-    }
-
-    // Remove padding after decryption
-    std::string unpaddedData = unpadData(decryptedData);
-    output.write(unpaddedData.data(), unpaddedData.size());
-
-    output.close();
-    std::cout << "Decryption complete. Plaintext written to " << outputFile << std::endl;
+const char* DES::algorithmName() const {
+    return "DES";
 }
-
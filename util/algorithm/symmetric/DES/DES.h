@@ -1,14 +1,45 @@
 #ifndef DES_H
 #define DES_H
 
-#include "../../CryptoAlgorithm.h"
+#include "../../BlockCipherAlgorithm.h"
+#include "DESBlockCipher.h"
+#include <bitset>
 #include <iostream>
 #include <string>
+#include <vector>
 
-class DES : public CryptoAlgorithm {
-public:
-    void encrypt(const std::string& inputFile, const std::string& outputFile) override;
-    void decrypt(const std::string& inputFile, const std::string& outputFile) override;
+class DES : public BlockCipherAlgorithm<DESBlockCipher, ContainerCipher::DES> {
+protected:
+    bool makeCipher(const std::string& key, DESBlockCipher& cipher) const override;
+    const char* algorithmName() const override;
 };
 
+// Generate the 16 round keys for a 64-bit key. DES files use the original schedule;
+// `standard` selects the FIPS 46-3 schedule (used by 3DES).
+std::vector<std::bitset<48>> generateRoundKeys(const std::bitset<64>& key, bool standard = false);
+
+// Reference implementation on std::bitset (DES.cpp), also timed by encryption_bench
+
+// Permutation and Transformation Functions
+std::bitset<64> initialPermutation(const std::bitset<64>& block);
+std::bitset<64> finalPermutation(const std::bitset<64>& block);
+std::bitset<48> expansion(const std::bitset<32>& half);
+std::bitset<32> pBoxPermutation(const std::bitset<32>& input);
+std::bitset<32> sBoxSubstitution(const std::bitset<48>& input);
+
+// XOR Operation with Round Key
+std::bitset<48> xorWithKey(const std::bitset<48>& expandedHalf, const std::bitset<48>& roundKey);
+
+// Key Scheduling Functions
+std::bitset<28> leftCircularShift(const std::bitset<28>& half, int shift);
+
+// Block Processing Functions
+void splitBlock(const std::bitset<64>& block, std::bitset<32>& left, std::bitset<32>& right);
+void desRound(std::bitset<32>& left, std::bitset<32>& right, const std::bitset<48>& roundKey);
+std::bitset<64> combineBlock(const std::bitset<32>& left, const std::bitset<32>& right);
+
+// Core Encryption and Decryption Functions
+std::bitset<64> encryptBlock(const std::bitset<64>& block, const std::vector<std::bitset<48>>& roundKeys);
+std::bitset<64> decryptBlock(const std::bitset<64>& block, const std::vector<std::bitset<48>>& roundKeys);
+
 #endif // DES_H
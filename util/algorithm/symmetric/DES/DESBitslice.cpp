@@ -0,0 +1,101 @@
+/**
+ * @file DESBitslice.cpp
+ * @brief Runtime dispatch for the bitsliced DES kernels.
+ *
+ * Bitslicing transposes a batch of blocks so that one machine word (or vector register)
+ * holds the same bit of 128, 256 or 512 different blocks. The permutations then
+ * become free renamings and every S-box is evaluated as a boolean gate network on all
+ * blocks at once (see DESBitsliceKernel.h). The per-ISA kernels live in
+ * DESBitsliceSSE2.cpp, DESBitsliceAVX2.cpp and DESBitsliceAVX512.cpp.
+ *
+ * A 64-bit general-purpose-register version of the kernel is slower than the
+ * table-driven core, so CPUs without SIMD (and short tails) use DESCore.cpp instead.
+ */
+
+#include "DESBitslice.h"
+#include "../../../cpu/CpuFeatures.h"
+
+namespace {
+
+using BatchKernel = void (*)(const uint8_t*, uint8_t*, size_t, const DESBitsliceKeys&);
+
+struct KernelChoice {
+    BatchKernel kernel;
+    size_t blocksPerBatch;
+};
+
+// Kernels usable on this CPU, widest first
+struct KernelTable {
+    KernelChoice kernels[3];
+    int count = 0;
+};
+
+KernelTable selectKernels() {
+    KernelTable table;
+    const CpuFeatures& cpu = cpuFeatures();
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    if (cpu.avx512f) {
+        table.kernels[table.count++] = {bitsliceBatchesAVX512, 512};
+    }
+    if (cpu.avx2) {
+        table.kernels[table.count++] = {bitsliceBatchesAVX2, 256};
+    }
+    if (cpu.sse2) {
+        table.kernels[table.count++] = {bitsliceBatchesSSE2, 128};
+    }
+#else
+    (void)cpu;
+#endif
+    return table;
+}
+
+const KernelTable& kernels() {
+    static const KernelTable table = selectKernels();
+    return table;
+}
+
+// Unpack the 6-bit groups of DESKeySchedule into per-bit masks
+void expandKeys(const DESKeySchedule& schedule, bool decrypt, DESBitsliceKeys& keys) {
+    for (int round = 0; round < 16; ++round) {
+        int source = decrypt ? 15 - round : round;
+        for (int box = 0; box < 8; ++box) {
+            // Groups 1, 3, 5, 7 are in the first word, 2, 4, 6, 8 in the second
+            uint32_t word = schedule.subkeys[2 * source + (box & 1)];
+            int shift = 24 - 8 * (box >> 1);
+            for (int t = 0; t < 6; ++t) {
+                uint64_t bit = (word >> (shift + 5 - t)) & 1;
+                keys.mask[round][box * 6 + t] = 0 - bit;
+            }
+        }
+    }
+}
+
+size_t bitsliceBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const DESKeySchedule& schedule, bool decrypt) {
+    const KernelTable& table = kernels();
+    if (table.count == 0 || blocks < table.kernels[table.count - 1].blocksPerBatch) {
+        return 0;
+    }
+
+    DESBitsliceKeys keys;
+    expandKeys(schedule, decrypt, keys);
+
+    size_t done = 0;
+    for (int i = 0; i < table.count; ++i) {
+        size_t batches = (blocks - done) / table.kernels[i].blocksPerBatch;
+        if (batches > 0) {
+            table.kernels[i].kernel(in + done * 8, out + done * 8, batches, keys);
+            done += batches * table.kernels[i].blocksPerBatch;
+        }
+    }
+    return done;
+}
+
+} // namespace
+
+size_t bitsliceEncryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const DESKeySchedule& schedule) {
+    return bitsliceBlocks(in, out, blocks, schedule, false);
+}
+
+size_t bitsliceDecryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const DESKeySchedule& schedule) {
+    return bitsliceBlocks(in, out, blocks, schedule, true);
+}
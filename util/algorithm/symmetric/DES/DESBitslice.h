@@ -0,0 +1,27 @@
+#ifndef DES_BITSLICE_H
+#define DES_BITSLICE_H
+
+#include "DESCore.h"
+#include <cstddef>
+#include <cstdint>
+
+// Round keys expanded to one all-zeros/all-ones mask per key bit, already in the
+// order the rounds consume them (reversed for decryption)
+struct DESBitsliceKeys {
+    uint64_t mask[16][48];
+};
+
+// Bitsliced bulk encryption/decryption. Runs the widest kernel the CPU supports
+// (AVX-512, AVX2 or SSE2) over as many whole batches as fit, then narrower kernels on
+// what is left. Returns the number of leading blocks processed; the remaining blocks
+// (fewer than 128, or all of them without SIMD support) are left for the scalar
+// encryptBlock path. `in` and `out` may alias.
+size_t bitsliceEncryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const DESKeySchedule& schedule);
+size_t bitsliceDecryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const DESKeySchedule& schedule);
+
+// Per-ISA kernels, each processing `batches` groups of (64 * words) blocks
+void bitsliceBatchesSSE2(const uint8_t* in, uint8_t* out, size_t batches, const DESBitsliceKeys& keys);
+void bitsliceBatchesAVX2(const uint8_t* in, uint8_t* out, size_t batches, const DESBitsliceKeys& keys);
+void bitsliceBatchesAVX512(const uint8_t* in, uint8_t* out, size_t batches, const DESBitsliceKeys& keys);
+
+#endif // DES_BITSLICE_H
@@ -0,0 +1,55 @@
+/**
+ * @file DESBitsliceAVX2.cpp
+ * @brief Bitsliced DES kernel on 256-bit AVX2 registers (256 blocks per batch).
+ */
+
+#include "DESBitslice.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+
+#include "DESTables.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "DESBitsliceKernel.h"
+
+namespace {
+
+struct VecAVX2 {
+    static constexpr int WORDS = 4;
+    __m256i v;
+
+    static VecAVX2 zero() { return {_mm256_setzero_si256()}; }
+    static VecAVX2 splat(uint64_t mask) { return {_mm256_set1_epi64x(static_cast<long long>(mask))}; }
+    static VecAVX2 load(const uint64_t* p) { return {_mm256_load_si256(reinterpret_cast<const __m256i*>(p))}; }
+    void store(uint64_t* p) const { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+};
+
+inline VecAVX2 operator&(VecAVX2 a, VecAVX2 b) { return {_mm256_and_si256(a.v, b.v)}; }
+inline VecAVX2 operator|(VecAVX2 a, VecAVX2 b) { return {_mm256_or_si256(a.v, b.v)}; }
+inline VecAVX2 operator^(VecAVX2 a, VecAVX2 b) { return {_mm256_xor_si256(a.v, b.v)}; }
+inline VecAVX2 operator~(VecAVX2 a) { return {_mm256_xor_si256(a.v, _mm256_set1_epi32(-1))}; }
+
+} // namespace
+
+void bitsliceBatchesAVX2(const uint8_t* in, uint8_t* out, size_t batches, const DESBitsliceKeys& keys) {
+    bitsliceBatches<VecAVX2>(in, out, batches, keys);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file DESBitsliceAVX512.cpp
+ * @brief Bitsliced DES kernel on 512-bit AVX-512 registers (512 blocks per batch).
+ */
+
+#include "DESBitslice.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+
+#include "DESTables.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+#include "DESBitsliceKernel.h"
+
+namespace {
+
+struct VecAVX512 {
+    static constexpr int WORDS = 8;
+    __m512i v;
+
+    static VecAVX512 zero() { return {_mm512_setzero_si512()}; }
+    static VecAVX512 splat(uint64_t mask) { return {_mm512_set1_epi64(static_cast<long long>(mask))}; }
+    static VecAVX512 load(const uint64_t* p) { return {_mm512_load_si512(p)}; }
+    void store(uint64_t* p) const { _mm512_store_si512(p, v); }
+};
+
+inline VecAVX512 operator&(VecAVX512 a, VecAVX512 b) { return {_mm512_and_si512(a.v, b.v)}; }
+inline VecAVX512 operator|(VecAVX512 a, VecAVX512 b) { return {_mm512_or_si512(a.v, b.v)}; }
+inline VecAVX512 operator^(VecAVX512 a, VecAVX512 b) { return {_mm512_xor_si512(a.v, b.v)}; }
+inline VecAVX512 operator~(VecAVX512 a) { return {_mm512_xor_si512(a.v, _mm512_set1_epi32(-1))}; }
+
+} // namespace
+
+void bitsliceBatchesAVX512(const uint8_t* in, uint8_t* out, size_t batches, const DESBitsliceKeys& keys) {
+    bitsliceBatches<VecAVX512>(in, out, batches, keys);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
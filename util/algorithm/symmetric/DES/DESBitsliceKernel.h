@@ -0,0 +1,158 @@
+#ifndef DES_BITSLICE_KERNEL_H
+#define DES_BITSLICE_KERNEL_H
+
+/**
+ * @file DESBitsliceKernel.h
+ * @brief Bitsliced DES rounds, generic over the vector type.
+ *
+ * Included only by the per-ISA translation units (DESBitslice*.cpp), each of which
+ * compiles it for its own target. Everything here therefore lives in an unnamed
+ * namespace: every translation unit must get its own copy, otherwise the linker could
+ * pick an AVX-512 build of a helper for the SSE2 path.
+ *
+ * A vector type V holds one bit of V::WORDS * 64 independent blocks and provides
+ * zero(), splat(mask), load/store of V::WORDS words, and the &, |, ^ and ~ operators.
+ * Bit planes are indexed by bit position in the 64-bit block value (0 = least
+ * significant), the same numbering DESCore.cpp uses.
+ */
+
+#include "DESBitslice.h"
+#include "DESTables.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// In-place transpose of a 64x64 bit matrix: afterwards bit k of a[i] is the former
+// bit i of a[k]
+inline void transpose64(uint64_t a[64]) {
+    uint64_t mask = 0x00000000FFFFFFFFull;
+    for (int j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+        for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            uint64_t t = ((a[k] >> j) ^ a[k | j]) & mask;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+// Round function output bit that receives bit `bit` of the substituted (pre-P) word
+constexpr int pBoxTarget(int bit) {
+    for (int k = 0; k < 32; ++k) {
+        if (32 - DESTables::P[k] == bit) {
+            return 31 - k;
+        }
+    }
+    return -1;
+}
+
+template <class V>
+inline V mux(V select, V whenClear, V whenSet) {
+    return whenClear ^ ((whenClear ^ whenSet) & select);
+}
+
+// XOR of the column minterms whose S-box entry has output bit `Bit` set
+template <int Box, int Row, int Bit, class V, int... Col>
+inline V sBoxRowBit(const V* minterms, std::integer_sequence<int, Col...>) {
+    V acc = V::zero();
+    ((acc = ((DESTables::S[Box][Row][Col] >> Bit) & 1) ? acc ^ minterms[Col] : acc), ...);
+    return acc;
+}
+
+// Evaluate output bit `Bit` of S-box `Box` from the column minterms and row bits
+template <int Box, int Bit, class V>
+inline V sBoxBit(const V* minterms, V rowHigh, V rowLow) {
+    auto cols = std::make_integer_sequence<int, 16>();
+    return mux(rowHigh,
+               mux(rowLow, sBoxRowBit<Box, 0, Bit>(minterms, cols), sBoxRowBit<Box, 1, Bit>(minterms, cols)),
+               mux(rowLow, sBoxRowBit<Box, 2, Bit>(minterms, cols), sBoxRowBit<Box, 3, Bit>(minterms, cols)));
+}
+
+// One S-box as a gate network: expand and key the six input bits, decode the column
+// into 16 minterms, select per row and XOR the permuted outputs into `target`
+template <int Box, class V>
+inline void applySBox(const V* half, V* target, const uint64_t* keyMask) {
+    V in[6];
+    for (int t = 0; t < 6; ++t) {
+        in[t] = half[32 - DESTables::E[Box * 6 + t]] ^ V::splat(keyMask[Box * 6 + t]);
+    }
+
+    V notIn1 = ~in[1], notIn2 = ~in[2], notIn3 = ~in[3], notIn4 = ~in[4];
+    V high[4] = {notIn1 & notIn2, notIn1 & in[2], in[1] & notIn2, in[1] & in[2]};
+    V low[4] = {notIn3 & notIn4, notIn3 & in[4], in[3] & notIn4, in[3] & in[4]};
+    V minterms[16];
+    for (int c = 0; c < 16; ++c) {
+        minterms[c] = high[c >> 2] & low[c & 3];
+    }
+
+    // sBoxSubstitution places bit j of S-box i at bit 4i + j before the P-box
+    target[pBoxTarget(Box * 4 + 0)] = target[pBoxTarget(Box * 4 + 0)] ^ sBoxBit<Box, 0>(minterms, in[0], in[5]);
+    target[pBoxTarget(Box * 4 + 1)] = target[pBoxTarget(Box * 4 + 1)] ^ sBoxBit<Box, 1>(minterms, in[0], in[5]);
+    target[pBoxTarget(Box * 4 + 2)] = target[pBoxTarget(Box * 4 + 2)] ^ sBoxBit<Box, 2>(minterms, in[0], in[5]);
+    target[pBoxTarget(Box * 4 + 3)] = target[pBoxTarget(Box * 4 + 3)] ^ sBoxBit<Box, 3>(minterms, in[0], in[5]);
+}
+
+template <class V, int... Box>
+inline void feistel(const V* half, V* target, const uint64_t* keyMask, std::integer_sequence<int, Box...>) {
+    (applySBox<Box>(half, target, keyMask), ...);
+}
+
+// Encrypt or decrypt (depending on the order of the key masks) `batches` groups of
+// V::WORDS * 64 blocks
+template <class V>
+void bitsliceBatches(const uint8_t* in, uint8_t* out, size_t batches, const DESBitsliceKeys& keys) {
+    constexpr int WORDS = V::WORDS;
+    constexpr size_t BATCH_BYTES = WORDS * 64 * 8;
+
+    alignas(64) uint64_t planes[64][WORDS];
+    alignas(64) uint64_t matrix[64];
+    V left[32], right[32];
+
+    for (size_t batch = 0; batch < batches; ++batch) {
+        const uint8_t* src = in + batch * BATCH_BYTES;
+        uint8_t* dst = out + batch * BATCH_BYTES;
+
+        // Transpose 64 blocks at a time into bit planes
+        for (int w = 0; w < WORDS; ++w) {
+            std::memcpy(matrix, src + w * 64 * 8, sizeof(matrix));
+            transpose64(matrix);
+            for (int bit = 0; bit < 64; ++bit) {
+                planes[bit][w] = matrix[bit];
+            }
+        }
+
+        // The initial permutation is only a renaming of the planes
+        for (int b = 0; b < 32; ++b) {
+            left[b] = V::load(planes[64 - DESTables::IP[31 - b]]);
+            right[b] = V::load(planes[64 - DESTables::IP[63 - b]]);
+        }
+
+        auto boxes = std::make_integer_sequence<int, 8>();
+        for (int round = 0; round < 16; round += 2) {
+            feistel(right, left, keys.mask[round], boxes);
+            feistel(left, right, keys.mask[round + 1], boxes);
+        }
+
+        // As in DESCore.cpp the halves come out exchanged; the final permutation is
+        // again a renaming
+        for (int i = 0; i < 64; ++i) {
+            int bit = 64 - DESTables::FP[i];
+            V value = bit >= 32 ? right[bit - 32] : left[bit];
+            value.store(planes[63 - i]);
+        }
+
+        for (int w = 0; w < WORDS; ++w) {
+            for (int bit = 0; bit < 64; ++bit) {
+                matrix[bit] = planes[bit][w];
+            }
+            transpose64(matrix);
+            std::memcpy(dst + w * 64 * 8, matrix, sizeof(matrix));
+        }
+    }
+}
+
+} // namespace
+
+#endif // DES_BITSLICE_KERNEL_H
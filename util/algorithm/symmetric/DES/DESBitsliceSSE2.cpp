@@ -0,0 +1,55 @@
+/**
+ * @file DESBitsliceSSE2.cpp
+ * @brief Bitsliced DES kernel on 128-bit SSE2 registers (128 blocks per batch).
+ */
+
+#include "DESBitslice.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+
+#include "DESTables.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#include "DESBitsliceKernel.h"
+
+namespace {
+
+struct VecSSE2 {
+    static constexpr int WORDS = 2;
+    __m128i v;
+
+    static VecSSE2 zero() { return {_mm_setzero_si128()}; }
+    static VecSSE2 splat(uint64_t mask) { return {_mm_set1_epi64x(static_cast<long long>(mask))}; }
+    static VecSSE2 load(const uint64_t* p) { return {_mm_load_si128(reinterpret_cast<const __m128i*>(p))}; }
+    void store(uint64_t* p) const { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+};
+
+inline VecSSE2 operator&(VecSSE2 a, VecSSE2 b) { return {_mm_and_si128(a.v, b.v)}; }
+inline VecSSE2 operator|(VecSSE2 a, VecSSE2 b) { return {_mm_or_si128(a.v, b.v)}; }
+inline VecSSE2 operator^(VecSSE2 a, VecSSE2 b) { return {_mm_xor_si128(a.v, b.v)}; }
+inline VecSSE2 operator~(VecSSE2 a) { return {_mm_xor_si128(a.v, _mm_set1_epi32(-1))}; }
+
+} // namespace
+
+void bitsliceBatchesSSE2(const uint8_t* in, uint8_t* out, size_t batches, const DESBitsliceKeys& keys) {
+    bitsliceBatches<VecSSE2>(in, out, batches, keys);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
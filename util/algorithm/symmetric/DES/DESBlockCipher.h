@@ -0,0 +1,45 @@
+#ifndef DES_BLOCK_CIPHER_H
+#define DES_BLOCK_CIPHER_H
+
+#include "DESBitslice.h"
+#include "DESCore.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// DES bound to a key schedule, in the shape the modes of operation expect
+// (see util/algorithm/modes/BlockModes.h)
+// It is also the prepared key context kept in KeyCache, aligned to a cache line so
+// the round keys span as few lines as possible.
+struct alignas(64) DESBlockCipher {
+    static constexpr size_t BLOCK_SIZE = 8;
+
+    DESKeySchedule schedule;
+
+    void encryptBlock(const uint8_t* in, uint8_t* out) const {
+        uint64_t block;
+        std::memcpy(&block, in, 8);
+        block = ::encryptBlock(block, schedule);
+        std::memcpy(out, &block, 8);
+    }
+
+    void decryptBlock(const uint8_t* in, uint8_t* out) const {
+        uint64_t block;
+        std::memcpy(&block, in, 8);
+        block = ::decryptBlock(block, schedule);
+        std::memcpy(out, &block, 8);
+    }
+
+    // Bulk paths: bitsliced SIMD batches first, then the scalar core for the tail
+    void encryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const {
+        size_t done = bitsliceEncryptBlocks(in, out, blocks, schedule);
+        ::encryptBlocks(in + done * 8, out + done * 8, blocks - done, schedule);
+    }
+
+    void decryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const {
+        size_t done = bitsliceDecryptBlocks(in, out, blocks, schedule);
+        ::decryptBlocks(in + done * 8, out + done * 8, blocks - done, schedule);
+    }
+};
+
+#endif // DES_BLOCK_CIPHER_H
@@ -0,0 +1,103 @@
+#ifndef DES_CORE_H
+#define DES_CORE_H
+
+#include <bit>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Round keys packed for the SP-box round: for every round, one word holds the
+// 6-bit groups 1, 3, 5, 7 and the next holds groups 2, 4, 6, 8, each group sitting
+// at the bit offset its lookup reads it from.
+struct DESKeySchedule {
+    uint32_t subkeys[32];
+};
+
+// Combined S-box + P-box lookup tables, one per S-box (generated at compile time in DESCore.cpp)
+struct DESSPBoxes {
+    uint32_t box[8][64];
+};
+extern const DESSPBoxes DES_SP_BOXES;           // S-box i output at bits 4i..4i+3, as in sBoxSubstitution
+extern const DESSPBoxes DES_SP_BOXES_STANDARD;  // FIPS 46-3 placement, S1 in the top nibble (used by 3DES)
+
+// Pack the 16 round keys produced by generateRoundKeys
+void packRoundKeys(const std::vector<std::bitset<48>>& roundKeys, DESKeySchedule& schedule);
+
+// Key schedule straight from the 64-bit key to packed round keys; the same result as
+// packRoundKeys(generateRoundKeys(key, standard)) without building any bitsets
+void expandDESKey(uint64_t key, DESKeySchedule& schedule, bool standard = false);
+
+// Building blocks of the single-block functions below, kept in the header so that
+// callers such as the CBC mode loop can inline a whole block
+namespace DESRound {
+
+// Swap the bits of `a` selected by `mask << shift` with the bits of `b` selected by `mask`
+constexpr void deltaSwap(uint32_t& a, uint32_t& b, int shift, uint32_t mask) {
+    uint32_t t = ((a >> shift) ^ b) & mask;
+    b ^= t;
+    a ^= t << shift;
+}
+
+constexpr void initialPermutation(uint32_t& left, uint32_t& right) {
+    deltaSwap(left, right, 4, 0x0F0F0F0Fu);
+    deltaSwap(left, right, 16, 0x0000FFFFu);
+    deltaSwap(right, left, 2, 0x33333333u);
+    deltaSwap(right, left, 8, 0x00FF00FFu);
+    deltaSwap(left, right, 1, 0x55555555u);
+}
+
+constexpr void finalPermutation(uint32_t& left, uint32_t& right) {
+    deltaSwap(left, right, 1, 0x55555555u);
+    deltaSwap(right, left, 8, 0x00FF00FFu);
+    deltaSwap(right, left, 2, 0x33333333u);
+    deltaSwap(left, right, 16, 0x0000FFFFu);
+    deltaSwap(left, right, 4, 0x0F0F0F0Fu);
+}
+
+// Round function f(R, K): rotr(R, 3) exposes the odd E-box groups at bits 24, 16, 8
+// and 0, rotl(R, 1) the even ones
+inline uint32_t feistel(uint32_t right, const uint32_t* subkey, const DESSPBoxes& sp) {
+    uint32_t t = std::rotr(right, 3) ^ subkey[0];
+    uint32_t u = std::rotl(right, 1) ^ subkey[1];
+    return sp.box[0][(t >> 24) & 0x3F] ^ sp.box[2][(t >> 16) & 0x3F]
+         ^ sp.box[4][(t >> 8) & 0x3F] ^ sp.box[6][t & 0x3F]
+         ^ sp.box[1][(u >> 24) & 0x3F] ^ sp.box[3][(u >> 16) & 0x3F]
+         ^ sp.box[5][(u >> 8) & 0x3F] ^ sp.box[7][u & 0x3F];
+}
+
+// 16 Feistel rounds, walking the round keys forwards (encrypt) or backwards (decrypt)
+template <bool Decrypt>
+inline uint64_t processBlock(uint64_t block, const DESKeySchedule& schedule, const DESSPBoxes& sp = DES_SP_BOXES) {
+    uint32_t left = static_cast<uint32_t>(block >> 32);
+    uint32_t right = static_cast<uint32_t>(block);
+    initialPermutation(left, right);
+
+    for (int round = 0; round < 16; round += 2) {
+        const uint32_t* k1 = schedule.subkeys + 2 * (Decrypt ? 15 - round : round);
+        const uint32_t* k2 = schedule.subkeys + 2 * (Decrypt ? 14 - round : round + 1);
+        left ^= feistel(right, k1, sp);
+        right ^= feistel(left, k2, sp);
+    }
+
+    // The last round is not followed by a swap, so the halves come out exchanged
+    finalPermutation(right, left);
+    return (static_cast<uint64_t>(right) << 32) | left;
+}
+
+} // namespace DESRound
+
+// Table-driven single-block encryption and decryption on the 64-bit block value
+inline uint64_t encryptBlock(uint64_t block, const DESKeySchedule& schedule) {
+    return DESRound::processBlock<false>(block, schedule);
+}
+
+inline uint64_t decryptBlock(uint64_t block, const DESKeySchedule& schedule) {
+    return DESRound::processBlock<true>(block, schedule);
+}
+
+// Encrypt/decrypt `blocks` consecutive 8-byte blocks; `in` and `out` may alias
+void encryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const DESKeySchedule& schedule);
+void decryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const DESKeySchedule& schedule);
+
+#endif // DES_CORE_H
@@ -0,0 +1,112 @@
+#ifndef DES_PERMUTATION_H
+#define DES_PERMUTATION_H
+
+/**
+ * @file DESPermutation.h
+ * @brief Byte-indexed bit permutation tables, generated at compile time from the FIPS tables.
+ *
+ * A DES permutation table lists, for every output bit, the input bit it takes, 1-indexed
+ * from the most significant bit. Applied bit by bit that is one move per output bit.
+ * Because every output bit comes from exactly one input bit, the output is the OR of
+ * what each input byte contributes on its own, so a table of 256 words per input byte
+ * turns the whole permutation into one lookup and one OR per input byte: 8 for IP, FP
+ * and PC-1, 7 for PC-2, 4 for E and P.
+ *
+ * makeBytePermutation builds those tables in a constant expression, so they are part of
+ * the binary rather than computed when the program starts. Each table below is checked
+ * with static_assert against permuteBits, the bit-by-bit loop, which is the reference.
+ * The optional `place` argument maps output bit i to the word it sets, so a permutation
+ * can be fused with a fixed repacking of its result (see the key schedule in DESCore.cpp).
+ */
+
+#include "DESTables.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace DESPermutation {
+
+// Reference: output bit i (from the most significant) is input bit table[i]
+template <size_t InBits, size_t OutBits>
+constexpr uint64_t permuteBits(const int (&table)[OutBits], uint64_t value) {
+    uint64_t permuted = 0;
+    for (size_t i = 0; i < OutBits; ++i) {
+        permuted |= ((value >> (InBits - table[i])) & 1) << (OutBits - 1 - i);
+    }
+    return permuted;
+}
+
+// One lookup per input byte, least significant byte first
+template <size_t InBits>
+struct BytePermutation {
+    static constexpr size_t BYTES = (InBits + 7) / 8;
+    uint64_t table[BYTES][256];
+
+    constexpr uint64_t operator()(uint64_t value) const {
+        uint64_t permuted = 0;
+        for (size_t i = 0; i < BYTES; ++i) {
+            permuted |= table[i][(value >> (8 * i)) & 0xFF];
+        }
+        return permuted;
+    }
+};
+
+template <size_t OutBits>
+struct StandardPlacement {
+    constexpr uint64_t operator()(size_t i) const {
+        return 1ull << (OutBits - 1 - i);
+    }
+};
+
+template <size_t InBits, size_t OutBits, class Place = StandardPlacement<OutBits>>
+constexpr BytePermutation<InBits> makeBytePermutation(const int (&table)[OutBits], Place place = Place{}) {
+    BytePermutation<InBits> permutation{};
+    for (size_t i = 0; i < OutBits; ++i) {
+        size_t source = InBits - static_cast<size_t>(table[i]);
+        uint64_t bit = place(i);
+        for (size_t v = 0; v < 256; ++v) {
+            if ((v >> (source % 8)) & 1) {
+                permutation.table[source / 8][v] |= bit;
+            }
+        }
+    }
+    return permutation;
+}
+
+// Whether `permutation` agrees with permuteBits on every single input bit and on a few
+// dense patterns, for use in static_assert
+template <size_t InBits, size_t OutBits>
+constexpr bool matchesReference(const BytePermutation<InBits>& permutation, const int (&table)[OutBits]) {
+    const uint64_t mask = InBits == 64 ? ~0ull : (1ull << InBits) - 1;
+    for (size_t bit = 0; bit < InBits; ++bit) {
+        if (permutation(1ull << bit) != permuteBits<InBits>(table, 1ull << bit)) {
+            return false;
+        }
+    }
+    for (uint64_t pattern : {0ull, ~0ull, 0x0123456789ABCDEFull, 0xA5A5F00F3CC3599Aull, 0x133457799BBCDFF1ull}) {
+        if (permutation(pattern & mask) != permuteBits<InBits>(table, pattern & mask)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The FIPS 46-3 permutations in this form, on values laid out as the std::bitset helpers
+// in DES.cpp lay them out (bit 0 of the value is the last bit of the table)
+inline constexpr BytePermutation<64> IP = makeBytePermutation<64>(DESTables::IP);
+inline constexpr BytePermutation<64> FP = makeBytePermutation<64>(DESTables::FP);
+inline constexpr BytePermutation<32> E = makeBytePermutation<32>(DESTables::E);
+inline constexpr BytePermutation<32> P = makeBytePermutation<32>(DESTables::P);
+inline constexpr BytePermutation<64> PC1 = makeBytePermutation<64>(DESTables::PC1);
+inline constexpr BytePermutation<56> PC2 = makeBytePermutation<56>(DESTables::PC2);
+
+static_assert(matchesReference(IP, DESTables::IP));
+static_assert(matchesReference(FP, DESTables::FP));
+static_assert(matchesReference(E, DESTables::E));
+static_assert(matchesReference(P, DESTables::P));
+static_assert(matchesReference(PC1, DESTables::PC1));
+static_assert(matchesReference(PC2, DESTables::PC2));
+static_assert(FP(IP(0x0123456789ABCDEFull)) == 0x0123456789ABCDEFull, "FP must undo IP");
+
+} // namespace DESPermutation
+
+#endif // DES_PERMUTATION_H
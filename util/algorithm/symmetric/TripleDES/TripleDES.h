@@ -0,0 +1,15 @@
+#ifndef TRIPLE_DES_H
+#define TRIPLE_DES_H
+
+#include "../../BlockCipherAlgorithm.h"
+#include "TripleDESBlockCipher.h"
+#include <string>
+
+// Triple DES in EDE3 form: encrypt with K1, decrypt with K2, encrypt with K3
+class TripleDES : public BlockCipherAlgorithm<TripleDESBlockCipher, ContainerCipher::TripleDES> {
+protected:
+    bool makeCipher(const std::string& key, TripleDESBlockCipher& cipher) const override;
+    const char* algorithmName() const override;
+};
+
+#endif // TRIPLE_DES_H
@@ -0,0 +1,35 @@
+#ifndef TRIPLE_DES_BLOCK_CIPHER_H
+#define TRIPLE_DES_BLOCK_CIPHER_H
+
+#include "TripleDESCore.h"
+#include <cstddef>
+#include <cstdint>
+
+// Triple DES (EDE3) bound to its key schedules, in the shape the modes of operation
+// expect (see util/algorithm/modes/BlockModes.h)
+// It is also the prepared key context kept in KeyCache, aligned to a cache line so
+// the round keys span as few lines as possible.
+struct alignas(64) TripleDESBlockCipher {
+    static constexpr size_t BLOCK_SIZE = 8;
+
+    TripleDESKeySchedule encryptSchedule;
+    TripleDESKeySchedule decryptSchedule;
+
+    void encryptBlock(const uint8_t* in, uint8_t* out) const {
+        TripleDESRound::processBlocks<1>(in, out, encryptSchedule);
+    }
+
+    void decryptBlock(const uint8_t* in, uint8_t* out) const {
+        TripleDESRound::processBlocks<1>(in, out, decryptSchedule);
+    }
+
+    void encryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const {
+        tripleDESBlocks(in, out, blocks, encryptSchedule);
+    }
+
+    void decryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const {
+        tripleDESBlocks(in, out, blocks, decryptSchedule);
+    }
+};
+
+#endif // TRIPLE_DES_BLOCK_CIPHER_H
@@ -0,0 +1,55 @@
+/**
+ * @file TripleDESCore.cpp
+ * @brief Triple DES (EDE3) block engine on top of the table-driven DES round.
+ *
+ * Unlike the DES file format, 3DES follows FIPS 46-3 / SP 800-67 exactly (big-endian
+ * blocks, the standard key schedule and S-box placement), so its output matches the
+ * published test vectors and other 3DES implementations.
+ *
+ * An EDE3 block costs 48 DES rounds. Two things keep that below three separate DES
+ * calls:
+ * - the FP/IP pairs between the stages cancel out and are skipped;
+ * - TRIPLE_DES_LANES blocks go through the rounds together, which keeps several
+ *   independent SP-box lookups in flight instead of waiting on each one in turn.
+ */
+
+#include "TripleDESCore.h"
+#include <cstring>
+
+namespace {
+
+// Append the 16 rounds of `key` to `out`, forwards or backwards
+uint32_t* appendRounds(uint32_t* out, const DESKeySchedule& key, bool reverse) {
+    for (int round = 0; round < 16; ++round) {
+        int from = reverse ? 15 - round : round;
+        out[0] = key.subkeys[2 * from];
+        out[1] = key.subkeys[2 * from + 1];
+        out += 2;
+    }
+    return out;
+}
+
+} // namespace
+
+void buildTripleDESSchedules(const DESKeySchedule keys[3], TripleDESKeySchedule& encrypt,
+                             TripleDESKeySchedule& decrypt) {
+    uint32_t* out = encrypt.subkeys;
+    out = appendRounds(out, keys[0], false);
+    out = appendRounds(out, keys[1], true);
+    appendRounds(out, keys[2], false);
+
+    out = decrypt.subkeys;
+    out = appendRounds(out, keys[2], true);
+    out = appendRounds(out, keys[1], false);
+    appendRounds(out, keys[0], true);
+}
+
+void tripleDESBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const TripleDESKeySchedule& schedule) {
+    size_t i = 0;
+    for (; i + TRIPLE_DES_LANES <= blocks; i += TRIPLE_DES_LANES) {
+        TripleDESRound::processBlocks<TRIPLE_DES_LANES>(in + i * 8, out + i * 8, schedule);
+    }
+    for (; i < blocks; ++i) {
+        TripleDESRound::processBlocks<1>(in + i * 8, out + i * 8, schedule);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef TRIPLE_DES_CORE_H
+#define TRIPLE_DES_CORE_H
+
+#include "../DES/DESCore.h"
+#include <cstddef>
+#include <cstdint>
+
+// The 48 rounds of an EDE3 pass, packed like DESKeySchedule and stored in the order
+// they are applied: encryption runs K1 forwards, K2 backwards and K3 forwards,
+// decryption runs K3 backwards, K2 forwards and K1 backwards.
+struct TripleDESKeySchedule {
+    uint32_t subkeys[96];
+};
+
+// Lay out the three DES key schedules for encryption and for decryption
+void buildTripleDESSchedules(const DESKeySchedule keys[3], TripleDESKeySchedule& encrypt,
+                             TripleDESKeySchedule& decrypt);
+
+namespace TripleDESRound {
+
+inline uint32_t loadBigEndian(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+inline void storeBigEndian(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+// Run `Lanes` independent blocks through all 48 rounds together, so the S-box lookups
+// of one block overlap with those of the others. IP and FP are applied once: the FP
+// of one stage and the IP of the next cancel out, leaving only the swap of the halves.
+template <size_t Lanes>
+inline void processBlocks(const uint8_t* in, uint8_t* out, const TripleDESKeySchedule& schedule) {
+    const DESSPBoxes& sp = DES_SP_BOXES_STANDARD;
+    uint32_t left[Lanes], right[Lanes];
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        left[lane] = loadBigEndian(in + lane * 8);
+        right[lane] = loadBigEndian(in + lane * 8 + 4);
+        DESRound::initialPermutation(left[lane], right[lane]);
+    }
+
+    for (int stage = 0; stage < 3; ++stage) {
+        if (stage > 0) {
+            for (size_t lane = 0; lane < Lanes; ++lane) {
+                uint32_t t = left[lane];
+                left[lane] = right[lane];
+                right[lane] = t;
+            }
+        }
+        for (int round = 0; round < 16; round += 2) {
+            const uint32_t* k1 = schedule.subkeys + 2 * (16 * stage + round);
+            const uint32_t* k2 = k1 + 2;
+            for (size_t lane = 0; lane < Lanes; ++lane) {
+                left[lane] ^= DESRound::feistel(right[lane], k1, sp);
+            }
+            for (size_t lane = 0; lane < Lanes; ++lane) {
+                right[lane] ^= DESRound::feistel(left[lane], k2, sp);
+            }
+        }
+    }
+
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        DESRound::finalPermutation(right[lane], left[lane]);
+        storeBigEndian(out + lane * 8, right[lane]);
+        storeBigEndian(out + lane * 8 + 4, left[lane]);
+    }
+}
+
+} // namespace TripleDESRound
+
+// Blocks processed together by tripleDESBlocks
+constexpr size_t TRIPLE_DES_LANES = 4;
+
+// Run `blocks` consecutive 8-byte blocks through the schedule (encryption or decryption
+// depending on which schedule is passed); `in` and `out` may alias
+void tripleDESBlocks(const uint8_t* in, uint8_t* out, size_t blocks, const TripleDESKeySchedule& schedule);
+
+#endif // TRIPLE_DES_CORE_H
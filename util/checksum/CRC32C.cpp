@@ -0,0 +1,87 @@
+/**
+ * @file CRC32C.cpp
+ * @brief CRC-32C with slicing-by-8 tables and runtime dispatch to SSE4.2.
+ *
+ * Slicing-by-8 keeps eight 256-entry tables: table k holds the CRC of a byte followed
+ * by k zero bytes, so eight input bytes are folded into the register with eight
+ * independent lookups instead of eight dependent ones. The tables are built when the
+ * program starts.
+ *
+ * CPUs with SSE4.2 use the CRC32 instruction instead (CRC32CHardware.cpp), which
+ * computes the same polynomial eight bytes at a time.
+ */
+
+#include "CRC32C.h"
+#include "../cpu/CpuFeatures.h"
+
+namespace {
+
+constexpr uint32_t POLYNOMIAL = 0x82F63B78;  // 0x1EDC6F41 bit-reversed
+
+struct SliceTables {
+    uint32_t table[8][256];
+};
+
+SliceTables buildSliceTables() {
+    SliceTables tables{};
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        uint32_t crc = byte;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? POLYNOMIAL : 0);
+        }
+        tables.table[0][byte] = crc;
+    }
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        for (int k = 1; k < 8; ++k) {
+            uint32_t previous = tables.table[k - 1][byte];
+            tables.table[k][byte] = (previous >> 8) ^ tables.table[0][previous & 0xFF];
+        }
+    }
+    return tables;
+}
+
+const SliceTables SLICE_TABLES = buildSliceTables();
+
+uint32_t loadLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint32_t sliceBy8(const uint8_t* data, size_t length, uint32_t state) {
+    const auto& t = SLICE_TABLES.table;
+    for (; length >= 8; data += 8, length -= 8) {
+        uint32_t low = loadLE32(data) ^ state;
+        uint32_t high = loadLE32(data + 4);
+        state = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+                t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+    }
+    for (; length > 0; ++data, --length) {
+        state = (state >> 8) ^ t[0][(state ^ *data) & 0xFF];
+    }
+    return state;
+}
+
+bool useHardware() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    return cpuFeatures().sse42;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+uint32_t crc32c(const uint8_t* data, size_t length, uint32_t crc) {
+    static const bool hardware = useHardware();
+    uint32_t state = ~crc;
+    state = hardware ? crc32cHardware(data, length, state) : sliceBy8(data, length, state);
+    return ~state;
+}
+
+uint32_t crc32cSoftware(const uint8_t* data, size_t length, uint32_t crc) {
+    return ~sliceBy8(data, length, ~crc);
+}
+
+bool crc32cHardwareAccelerated() {
+    return useHardware();
+}
@@ -0,0 +1,22 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32C (Castagnoli, reflected polynomial 0x82F63B78) of `length` bytes. Pass the
+// previous result as `crc` to continue over several buffers; start from 0. Runs on the
+// SSE4.2 CRC32 instruction when the CPU has it, slicing-by-8 tables otherwise.
+uint32_t crc32c(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+// The table-driven version, whatever the CPU supports (for benchmarks and checks)
+uint32_t crc32cSoftware(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+// Whether crc32c uses the CRC32 instruction on this CPU
+bool crc32cHardwareAccelerated();
+
+// SSE4.2 kernel in CRC32CHardware.cpp; only called after CPU detection. Takes and
+// returns the CRC register, i.e. without the initial and final inversion.
+uint32_t crc32cHardware(const uint8_t* data, size_t length, uint32_t state);
+
+#endif // CRC32C_H
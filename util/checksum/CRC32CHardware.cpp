@@ -0,0 +1,132 @@
+/**
+ * @file CRC32CHardware.cpp
+ * @brief CRC-32C on the SSE4.2 CRC32 instruction.
+ *
+ * CRC32 folds eight bytes into the register per instruction and can start one every
+ * cycle, but its latency is three cycles, so one dependency chain runs at a third of
+ * the possible rate. Long inputs are therefore cut into three equal stretches whose
+ * CRCs are computed side by side and then joined: the CRC of A followed by B is the CRC
+ * of A shifted over |B| zero bytes, XORed with the CRC of B on its own, and shifting
+ * over a fixed length is a multiplication by a constant modulo the polynomial. Only
+ * called after CPU detection (see CRC32C.cpp).
+ */
+
+#include "CRC32C.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+
+#include <cstring>
+#include <iterator>
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+#endif
+
+namespace {
+
+constexpr uint32_t POLYNOMIAL = 0x82F63B78;
+
+// Stretch lengths for the three-way loop, longest first
+constexpr size_t STRETCHES[] = {4096, 256};
+
+// a * b modulo the polynomial, both in the reflected bit order of the CRC register
+uint32_t multiplyModP(uint32_t a, uint32_t b) {
+    uint32_t product = 0;
+    for (uint32_t bit = 1u << 31; bit != 0; bit >>= 1) {
+        if (a & bit) {
+            product ^= b;
+        }
+        b = (b & 1) ? (b >> 1) ^ POLYNOMIAL : b >> 1;
+    }
+    return product;
+}
+
+// x^(8 * bytes) modulo the polynomial: multiplying a register by it shifts the register
+// over `bytes` zero bytes
+uint32_t shiftConstant(size_t bytes) {
+    uint32_t power = 1u << 31;  // x^0
+    for (size_t bit = 0; bit < 8 * bytes; ++bit) {
+        power = (power & 1) ? (power >> 1) ^ POLYNOMIAL : power >> 1;
+    }
+    return power;
+}
+
+struct ShiftConstants {
+    uint32_t once[std::size(STRETCHES)];   // Over one stretch
+    uint32_t twice[std::size(STRETCHES)];  // Over two stretches
+};
+
+ShiftConstants buildShiftConstants() {
+    ShiftConstants constants{};
+    for (size_t i = 0; i < std::size(STRETCHES); ++i) {
+        constants.once[i] = shiftConstant(STRETCHES[i]);
+        constants.twice[i] = shiftConstant(2 * STRETCHES[i]);
+    }
+    return constants;
+}
+
+const ShiftConstants SHIFT_CONSTANTS = buildShiftConstants();
+
+#if defined(__x86_64__) || defined(_M_X64)
+using CrcWord = uint64_t;
+
+inline uint64_t crcWord(uint64_t state, const uint8_t* p) {
+    uint64_t word;
+    std::memcpy(&word, p, 8);
+    return _mm_crc32_u64(state, word);
+}
+#else
+using CrcWord = uint32_t;
+
+inline uint32_t crcWord(uint32_t state, const uint8_t* p) {
+    uint32_t word;
+    std::memcpy(&word, p, 4);
+    return _mm_crc32_u32(state, word);
+}
+#endif
+
+} // namespace
+
+uint32_t crc32cHardware(const uint8_t* data, size_t length, uint32_t state) {
+    for (size_t s = 0; s < std::size(STRETCHES); ++s) {
+        size_t stretch = STRETCHES[s];
+        for (; length >= 3 * stretch; data += 3 * stretch, length -= 3 * stretch) {
+            CrcWord a = state;
+            CrcWord b = 0;
+            CrcWord c = 0;
+            for (size_t i = 0; i < stretch; i += sizeof(CrcWord)) {
+                a = crcWord(a, data + i);
+                b = crcWord(b, data + stretch + i);
+                c = crcWord(c, data + 2 * stretch + i);
+            }
+            state = multiplyModP(SHIFT_CONSTANTS.twice[s], static_cast<uint32_t>(a)) ^
+                    multiplyModP(SHIFT_CONSTANTS.once[s], static_cast<uint32_t>(b)) ^ static_cast<uint32_t>(c);
+        }
+    }
+    CrcWord wide = state;
+    for (; length >= sizeof(CrcWord); data += sizeof(CrcWord), length -= sizeof(CrcWord)) {
+        wide = crcWord(wide, data);
+    }
+    state = static_cast<uint32_t>(wide);
+    for (; length >= 4; data += 4, length -= 4) {
+        uint32_t word;
+        std::memcpy(&word, data, 4);
+        state = _mm_crc32_u32(state, word);
+    }
+    for (; length > 0; ++data, --length) {
+        state = _mm_crc32_u8(state, *data);
+    }
+    return state;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
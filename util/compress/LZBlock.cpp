@@ -0,0 +1,217 @@
+/**
+ * @file LZBlock.cpp
+ * @brief A fast LZ77 block compressor for the container's --compress stage.
+ *
+ * The block is a list of sequences in the layout of the LZ4 block format: a token
+ * byte holding the literal count (high nibble) and the match length minus four (low
+ * nibble), extra length bytes when a nibble is 15, the literals, and a 16-bit
+ * little-endian match offset. The last sequence has literals only.
+ *
+ * The compressor is greedy: a hash of the next four bytes looks up the last position
+ * with the same hash, and a match is taken whenever the four bytes agree. After 64
+ * misses in a row the scan starts skipping ahead, faster the longer nothing matches,
+ * so incompressible data costs little more than a copy. Decompression is a loop of
+ * copies with every length checked against both buffers.
+ */
+
+#include "LZBlock.h"
+#include <bit>
+#include <cstring>
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr size_t LAST_LITERALS = 5;    // The block always ends with this many literals
+constexpr size_t MATCH_SAFE_END = 12;  // No match starts this close to the end
+constexpr int HASH_BITS = 13;
+constexpr unsigned SKIP_TRIGGER = 6;   // log2 of the misses before the scan speeds up
+
+uint32_t load32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, 4);
+    return value;
+}
+
+uint64_t load64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, 8);
+    return value;
+}
+
+// Number of equal bytes at `a` and `b`, not going past `aEnd`
+size_t commonLength(const uint8_t* a, const uint8_t* b, const uint8_t* aEnd) {
+    const uint8_t* start = a;
+    while (aEnd - a >= 8) {
+        uint64_t diff = load64(a) ^ load64(b);
+        if (diff != 0) {
+            int bits = std::endian::native == std::endian::little ? std::countr_zero(diff) : std::countl_zero(diff);
+            return static_cast<size_t>(a - start) + bits / 8;
+        }
+        a += 8;
+        b += 8;
+    }
+    while (a < aEnd && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return static_cast<size_t>(a - start);
+}
+
+uint32_t hashOf(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+uint8_t* writeLength(uint8_t* out, size_t length) {
+    for (; length >= 255; length -= 255) {
+        *out++ = 255;
+    }
+    *out++ = static_cast<uint8_t>(length);
+    return out;
+}
+
+uint8_t* writeSequence(uint8_t* out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength) {
+    uint8_t* token = out++;
+    size_t matchCode = matchLength - MIN_MATCH;
+    *token = static_cast<uint8_t>(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+    if (literalCount >= 15) {
+        out = writeLength(out, literalCount - 15);
+    }
+    std::memcpy(out, literals, literalCount);
+    out += literalCount;
+    *out++ = static_cast<uint8_t>(offset);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+    if (matchCode >= 15) {
+        out = writeLength(out, matchCode - 15);
+    }
+    return out;
+}
+
+uint8_t* writeLastLiterals(uint8_t* out, const uint8_t* literals, size_t literalCount) {
+    *out++ = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+    if (literalCount >= 15) {
+        out = writeLength(out, literalCount - 15);
+    }
+    std::memcpy(out, literals, literalCount);
+    return out + literalCount;
+}
+
+// Read an extended length; false if the input ends first
+bool readLength(const uint8_t*& in, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (in == end) {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // namespace
+
+size_t lzCompressBound(size_t length) {
+    return length + length / 255 + 16;
+}
+
+size_t lzCompress(const uint8_t* input, size_t length, uint8_t* output) {
+    uint8_t* out = output;
+    const uint8_t* anchor = input;
+    if (length > MATCH_SAFE_END) {
+        uint32_t table[1 << HASH_BITS] = {};  // Positions in `input`
+        const uint8_t* ip = input + 1;
+        const uint8_t* matchEnd = input + length - MATCH_SAFE_END;
+        const uint8_t* extendEnd = input + length - LAST_LITERALS;
+        unsigned misses = 1u << SKIP_TRIGGER;
+
+        while (ip < matchEnd) {
+            uint32_t sequence = load32(ip);
+            uint32_t& slot = table[hashOf(sequence)];
+            const uint8_t* ref = input + slot;
+            slot = static_cast<uint32_t>(ip - input);
+            if (ip - ref > static_cast<std::ptrdiff_t>(MAX_OFFSET) || load32(ref) != sequence) {
+                ip += misses++ >> SKIP_TRIGGER;
+                continue;
+            }
+            misses = 1u << SKIP_TRIGGER;
+
+            // Grow the match backwards over the pending literals, then forwards
+            while (ip > anchor && ref > input && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            const uint8_t* end = ip + MIN_MATCH;
+            end += commonLength(end, ref + MIN_MATCH, extendEnd);
+
+            out = writeSequence(out, anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - ref),
+                                static_cast<size_t>(end - ip));
+            anchor = end;
+            if (end - 2 > input && end < matchEnd) {
+                table[hashOf(load32(end - 2))] = static_cast<uint32_t>(end - 2 - input);
+            }
+            ip = end;
+        }
+    }
+    out = writeLastLiterals(out, anchor, static_cast<size_t>(input + length - anchor));
+    return static_cast<size_t>(out - output);
+}
+
+bool lzDecompress(const uint8_t* input, size_t inputLength, uint8_t* output, size_t length) {
+    const uint8_t* in = input;
+    const uint8_t* inEnd = input + inputLength;
+    uint8_t* out = output;
+    uint8_t* outEnd = output + length;
+
+    while (in < inEnd) {
+        uint8_t token = *in++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(in, inEnd, literalCount)) {
+            return false;
+        }
+        if (literalCount > static_cast<size_t>(inEnd - in) || literalCount > static_cast<size_t>(outEnd - out)) {
+            return false;
+        }
+        if (literalCount <= 16 && inEnd - in >= 16 && outEnd - out >= 16) {
+            std::memcpy(out, in, 16);  // Short runs: one fixed-size copy, the excess is overwritten later
+        } else {
+            std::memcpy(out, in, literalCount);
+        }
+        in += literalCount;
+        out += literalCount;
+        if (in == inEnd) {
+            break;  // The last sequence has no match
+        }
+
+        if (inEnd - in < 2) {
+            return false;
+        }
+        size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(in, inEnd, matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(out - output) ||
+            matchLength > static_cast<size_t>(outEnd - out)) {
+            return false;
+        }
+
+        const uint8_t* from = out - offset;
+        if (offset >= 8 && static_cast<size_t>(outEnd - out) >= matchLength + 8) {
+            // Eight bytes at a time; each copy reads only bytes that are already final
+            for (size_t i = 0; i < matchLength; i += 8) {
+                std::memcpy(out + i, from + i, 8);
+            }
+        } else if (offset >= matchLength) {
+            std::memcpy(out, from, matchLength);
+        } else {
+            for (size_t i = 0; i < matchLength; ++i) {
+                out[i] = from[i];  // Overlapping: the match repeats its last `offset` bytes
+            }
+        }
+        out += matchLength;
+    }
+    return out == outEnd;
+}
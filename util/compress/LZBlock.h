@@ -0,0 +1,19 @@
+#ifndef LZ_BLOCK_H
+#define LZ_BLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Size `output` must have for lzCompress of `length` bytes, whatever the data
+size_t lzCompressBound(size_t length);
+
+// Compress `length` bytes into `output` (at least lzCompressBound(length) bytes) and
+// return the compressed size. Blocks are independent: nothing refers outside them.
+size_t lzCompress(const uint8_t* input, size_t length, uint8_t* output);
+
+// Decompress a block into exactly `length` bytes of `output`. Returns false if the
+// block is malformed or does not decompress to `length` bytes; never reads or writes
+// outside the two buffers, whatever the input.
+bool lzDecompress(const uint8_t* input, size_t inputLength, uint8_t* output, size_t length);
+
+#endif // LZ_BLOCK_H
@@ -0,0 +1,16 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Instruction-set extensions the accelerated kernels can be dispatched to
+struct CpuFeatures {
+    bool sse2 = false;
+    bool sse42 = false;
+    bool avx2 = false;
+    bool avx512f = false;
+    bool aesni = false;
+};
+
+// Features of the CPU we are running on, detected once on first use
+const CpuFeatures& cpuFeatures();
+
+#endif // CPU_FEATURES_H
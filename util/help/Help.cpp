@@ -2,17 +2,74 @@
 #include <iostream>
 
 void displayHelp() {
-    std::cout << "Usage: encryption_tool.exe [options] <encryption_type> <encryption_key> <input_file> <output_file>\n";
+    std::cout << "Usage: encryption_tool.exe [options] <encryption_type> <encryption_key> <input_file> <output_file> [--threads N] [--processes N] [--mode M] [--io B] [--recursive] [--container] [--compress] [--range R] [--in-place] [--rollback] [--stats] [--perf]\n";
+    std::cout << "       encryption_tool.exe --verify <input_file> [--threads N]\n";
+    std::cout << "       encryption_tool.exe --serve <socket_path> [--threads N]\n";
     std::cout << "\nOptions:\n";
     std::cout << "  --help                            Show this help message and exit.\n";
     std::cout << "  --encrypt                         Encrypt the specified input file.\n";
     std::cout << "  --decrypt                         Decrypt the specified input file.\n";
+    std::cout << "  --verify                          Check every chunk of a container against its CRC-32C on all\n";
+    std::cout << "                                    cores (or --threads N), without the key and without writing\n";
+    std::cout << "                                    anything. Exits with status 1 if any chunk is damaged.\n";
+    std::cout << "  --serve                           Run as a daemon taking jobs (in memory, by path or as passed\n";
+    std::cout << "                                    file descriptors) over a Unix socket, with warm threads and\n";
+    std::cout << "                                    cached keys; --threads N handlers start up front (default:\n";
+    std::cout << "                                    one per core). Stops on Ctrl+C or SIGTERM.\n";
+    std::cout << "  --threads N                       Encrypt/decrypt using N threads (0 = all cores, default 1).\n";
+    std::cout << "  --processes N                     Split a single file across N worker processes (0 = one per\n";
+    std::cout << "                                    core), each with its own byte range, pinned to a NUMA node\n";
+    std::cout << "                                    where there are several. A failed worker is restarted where\n";
+    std::cout << "                                    it stopped. Not with --threads, --io, containers or -.\n";
+    std::cout << "  --mode M                          Block cipher mode: ECB (default), CBC or CTR.\n";
+    std::cout << "                                    CBC and CTR write a random IV in front of the ciphertext;\n";
+    std::cout << "                                    CBC encryption always runs on a single thread.\n";
+    std::cout << "  --io B                            File I/O backend: auto (default), mmap, pipeline or stream.\n";
+    std::cout << "                                    pipeline overlaps reading, encrypting and writing on one\n";
+    std::cout << "                                    thread (io_uring where available); --stats shows the overlap.\n";
+    std::cout << "  --recursive                       <input_file> and <output_file> are directories: process every\n";
+    std::cout << "                                    file in the tree, spread over --threads, largest first.\n";
+    std::cout << "  --container                       Write (or read) the seekable container format: the file is\n";
+    std::cout << "                                    encrypted in 64 KB chunks, each with its own IV and checksum,\n";
+    std::cout << "                                    plus an index.\n";
+    std::cout << "                                    Decryption takes the mode from the container.\n";
+    std::cout << "  --compress                        Compress each container chunk before encrypting it (implies\n";
+    std::cout << "                                    --container); chunks that do not shrink are stored as they are.\n";
+    std::cout << "  --range OFFSET:LENGTH             Decrypt only these plaintext bytes of a container, reading\n";
+    std::cout << "                                    just the chunks they fall in (implies --container).\n";
+    std::cout << "  --in-place                        Rewrite <input_file> itself (give it again as <output_file>)\n";
+    std::cout << "                                    chunk by chunk, with no second copy on disk or in memory.\n";
+    std::cout << "                                    A journal (<input_file>.journal) lets an interrupted run\n";
+    std::cout << "                                    resume: repeat the same command.\n";
+    std::cout << "  --rollback                        Undo an interrupted --in-place job instead, with the same\n";
+    std::cout << "                                    algorithm, key and mode (implies --in-place).\n";
+    std::cout << "  --stats                           After the job, print a JSON report: bytes, blocks, time and\n";
+    std::cout << "                                    MB/s per stage (key setup, read, cipher, write, ...), peak RSS.\n";
+    std::cout << "  --perf                            Add CPU cycles, instructions, cache and branch misses to the\n";
+    std::cout << "                                    --stats report (Linux perf_event_open; implies --stats).\n";
     std::cout << "\nArguments:\n";
-    std::cout << "  <encryption_type>                 The encryption algorithm to use (e.g., DES).\n";
-    std::cout << "  <encryption_key>                  The key used for encryption or decryption.\n";
-    std::cout << "  <input_file>                      The file to encrypt or decrypt.\n";
-    std::cout << "  <output_file>                     The output file where the result will be saved.\n";
+    std::cout << "  <encryption_type>                 The encryption algorithm to use: DES, 3DES or AES.\n";
+    std::cout << "  <encryption_key>                  The key used for encryption or decryption, in hex.\n";
+    std::cout << "                                    DES: 16 digits. 3DES: 48 digits (K1 K2 K3) or 32 (K1 K2).\n";
+    std::cout << "                                    AES: 32, 48 or 64 digits (AES-128, AES-192, AES-256).\n";
+    std::cout << "  <input_file>                      The file to encrypt or decrypt, or - for standard input.\n";
+    std::cout << "  <output_file>                     The output file where the result will be saved, or - for\n";
+    std::cout << "                                    standard output (messages then go to standard error).\n";
+    std::cout << "                                    With -, data is streamed in one pass, whatever --io says.\n";
     std::cout << "\nExamples:\n";
     std::cout << "  encryption_tool.exe --encrypt DES my_secret_key input.txt encrypted_output.txt\n";
     std::cout << "  encryption_tool.exe --decrypt DES my_secret_key encrypted_output.txt decrypted_output.txt\n";
+    std::cout << "  encryption_tool.exe --encrypt DES my_secret_key input.bin encrypted.bin --threads 8\n";
+    std::cout << "  encryption_tool.exe --encrypt DES my_secret_key input.bin encrypted.bin --mode CTR --threads 8\n";
+    std::cout << "  encryption_tool.exe --encrypt AES 000102030405060708090a0b0c0d0e0f input.bin encrypted.bin --mode CTR\n";
+    std::cout << "  encryption_tool.exe --encrypt AES 000102030405060708090a0b0c0d0e0f archive.tar archive.enc --mode CTR --processes 4\n";
+    std::cout << "  encryption_tool.exe --encrypt AES 000102030405060708090a0b0c0d0e0f backups/ encrypted/ --recursive --threads 0\n";
+    std::cout << "  encryption_tool.exe --encrypt AES 000102030405060708090a0b0c0d0e0f archive.tar archive.enc --container --mode CTR\n";
+    std::cout << "  encryption_tool.exe --decrypt AES 000102030405060708090a0b0c0d0e0f archive.enc slice.bin --range 1048576:4096\n";
+    std::cout << "  encryption_tool.exe --encrypt AES 000102030405060708090a0b0c0d0e0f logs.csv logs.enc --compress --threads 0\n";
+    std::cout << "  encryption_tool.exe --verify archive.enc\n";
+    std::cout << "  encryption_tool.exe --serve /run/encryption.sock --threads 8\n";
+    std::cout << "  encryption_tool.exe --encrypt AES 000102030405060708090a0b0c0d0e0f disk.img disk.img --mode CTR --in-place\n";
+    std::cout << "  tar cf - docs/ | encryption_tool.exe --encrypt AES 000102030405060708090a0b0c0d0e0f - - --mode CTR | ssh backup 'cat > docs.enc'\n";
+    std::cout << "  encryption_tool.exe --encrypt 3DES 0123456789ABCDEF23456789ABCDEF01456789ABCDEF0123 input.bin encrypted.bin\n";
 }
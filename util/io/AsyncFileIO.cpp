@@ -0,0 +1,309 @@
+/**
+ * @file AsyncFileIO.cpp
+ * @brief io_uring and thread-based implementations of AsyncFileIO.
+ *
+ * The io_uring backend talks to the kernel through the raw system calls and the
+ * shared submission/completion rings (no liburing dependency). IORING_OP_READ/WRITE
+ * need Linux 5.6, which is recognised by IORING_FEAT_RW_CUR_POS; on older kernels, on
+ * other systems, or where io_uring is disabled (e.g. by seccomp), a reader thread and a
+ * writer thread run pread/pwrite instead, so reads and writes still overlap with each
+ * other and with the caller.
+ */
+
+#include "AsyncFileIO.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASYNC_FILE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+#ifdef ASYNC_FILE_IO_URING
+
+class UringFileIO : public AsyncFileIO {
+public:
+    ~UringFileIO() override {
+        // Requests still in flight write into the caller's buffers; let them finish
+        AsyncCompletion completion;
+        while (pending > 0 && wait(completion)) {
+        }
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        if (ringFd >= 0) {
+            close(ringFd);
+        }
+    }
+
+    // Set up the rings; false if io_uring or the read/write opcodes are unavailable
+    bool init(unsigned depth) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+        if (ringFd < 0 || !(params.features & IORING_FEAT_RW_CUR_POS)) {
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                      IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        cqRing = singleMap ? sqRing
+                           : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                                  IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqEntries = params.sq_entries;
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    const char* name() const override {
+        return "io_uring";
+    }
+
+    bool submitRead(int fd, uint8_t* buffer, size_t length, uint64_t offset, uint64_t tag) override {
+        return submit(IORING_OP_READ, fd, buffer, length, offset, tag);
+    }
+
+    bool submitWrite(int fd, const uint8_t* buffer, size_t length, uint64_t offset, uint64_t tag) override {
+        return submit(IORING_OP_WRITE, fd, buffer, length, offset, tag);
+    }
+
+    bool wait(AsyncCompletion& completion) override {
+        while (!poll(completion)) {
+            if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool poll(AsyncCompletion& completion) override {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        const io_uring_cqe& cqe = cqes[head & cqMask];
+        completion = AsyncCompletion{cqe.user_data, cqe.res};
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        --pending;
+        return true;
+    }
+
+private:
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        int result;
+        do {
+            result = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+        } while (result < 0 && errno == EINTR);
+        return result;
+    }
+
+    bool submit(uint8_t opcode, int fd, const uint8_t* buffer, size_t length, uint64_t offset, uint64_t tag) {
+        unsigned tail = *sqTail;
+        if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+            return false;
+        }
+        unsigned index = tail & sqMask;
+        io_uring_sqe& sqe = static_cast<io_uring_sqe*>(sqes)[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(buffer);
+        sqe.len = static_cast<uint32_t>(length);
+        sqe.off = offset;
+        sqe.user_data = tag;
+        // Page-cache hits would otherwise be copied inline by io_uring_enter on the
+        // submitting thread, the very thread the pipeline wants to keep transforming
+        sqe.flags = IOSQE_ASYNC;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        if (enter(1, 0, 0) != 1) {
+            // The kernel did not take the entry: withdraw it, so neither a later enter
+            // submits it nor the destructor waits for its completion
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+            return false;
+        }
+        ++pending;
+        return true;
+    }
+
+    int ringFd = -1;
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    void* sqes = MAP_FAILED;
+    size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+    unsigned *sqHead = nullptr, *sqTail = nullptr, *sqArray = nullptr;
+    unsigned sqMask = 0, sqEntries = 0;
+    unsigned *cqHead = nullptr, *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+    unsigned pending = 0;
+};
+
+#endif
+
+// One thread for reads and one for writes, each working through its own queue
+class ThreadFileIO : public AsyncFileIO {
+public:
+    ThreadFileIO() : reader([this] { run(reads); }), writer([this] { run(writes); }) {}
+
+    ~ThreadFileIO() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        reads.ready.notify_one();
+        writes.ready.notify_one();
+        reader.join();
+        writer.join();
+    }
+
+    const char* name() const override {
+        return "threads";
+    }
+
+    bool submitRead(int fd, uint8_t* buffer, size_t length, uint64_t offset, uint64_t tag) override {
+        return push(reads, Request{false, fd, buffer, length, offset, tag});
+    }
+
+    bool submitWrite(int fd, const uint8_t* buffer, size_t length, uint64_t offset, uint64_t tag) override {
+        return push(writes, Request{true, fd, const_cast<uint8_t*>(buffer), length, offset, tag});
+    }
+
+    bool wait(AsyncCompletion& completion) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        completed.wait(lock, [this] { return !completions.empty(); });
+        completion = completions.front();
+        completions.pop_front();
+        return true;
+    }
+
+    bool poll(AsyncCompletion& completion) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (completions.empty()) {
+            return false;
+        }
+        completion = completions.front();
+        completions.pop_front();
+        return true;
+    }
+
+private:
+    struct Request {
+        bool write;
+        int fd;
+        uint8_t* buffer;
+        size_t length;
+        uint64_t offset;
+        uint64_t tag;
+    };
+
+    struct Queue {
+        std::deque<Request> requests;
+        std::condition_variable ready;
+    };
+
+    bool push(Queue& queue, const Request& request) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.requests.push_back(request);
+        }
+        queue.ready.notify_one();
+        return true;
+    }
+
+    void run(Queue& queue) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            queue.ready.wait(lock, [&] { return stopping || !queue.requests.empty(); });
+            if (queue.requests.empty()) {
+                return;
+            }
+            Request request = queue.requests.front();
+            queue.requests.pop_front();
+            lock.unlock();
+
+            ssize_t result;
+            do {
+                result = request.write ? pwrite(request.fd, request.buffer, request.length, static_cast<off_t>(request.offset))
+                                       : pread(request.fd, request.buffer, request.length, static_cast<off_t>(request.offset));
+            } while (result < 0 && errno == EINTR);
+
+            lock.lock();
+            completions.push_back(AsyncCompletion{request.tag, result < 0 ? -errno : static_cast<int64_t>(result)});
+            completed.notify_one();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable completed;
+    std::deque<AsyncCompletion> completions;
+    Queue reads, writes;
+    bool stopping = false;
+    std::thread reader, writer;
+};
+
+} // namespace
+
+std::unique_ptr<AsyncFileIO> createAsyncFileIO(unsigned queueDepth) {
+#ifdef ASYNC_FILE_IO_URING
+    auto uring = std::make_unique<UringFileIO>();
+    if (uring->init(queueDepth)) {
+        return uring;
+    }
+#else
+    (void)queueDepth;
+#endif
+    return std::make_unique<ThreadFileIO>();
+}
+
+#else
+
+std::unique_ptr<AsyncFileIO> createAsyncFileIO(unsigned) {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef ASYNC_FILE_IO_H
+#define ASYNC_FILE_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// One finished request: the tag it was submitted with and the byte count, or -errno
+struct AsyncCompletion {
+    uint64_t tag;
+    int64_t result;
+};
+
+// Positional reads and writes that complete in the background. Requests may finish in
+// any order and may transfer fewer bytes than asked for. Buffers must stay alive until
+// their request completes or the AsyncFileIO is destroyed, which waits for everything
+// still in flight. Not thread-safe: one thread submits and waits.
+class AsyncFileIO {
+public:
+    virtual ~AsyncFileIO() = default;
+
+    // Name of the implementation, for reports ("io_uring" or "threads")
+    virtual const char* name() const = 0;
+
+    virtual bool submitRead(int fd, uint8_t* buffer, size_t length, uint64_t offset, uint64_t tag) = 0;
+    virtual bool submitWrite(int fd, const uint8_t* buffer, size_t length, uint64_t offset, uint64_t tag) = 0;
+
+    // Block until a request completes; false if waiting itself failed
+    virtual bool wait(AsyncCompletion& completion) = 0;
+
+    // Take a completion if one is ready, without blocking
+    virtual bool poll(AsyncCompletion& completion) = 0;
+};
+
+// io_uring when the kernel supports it, otherwise a reader and a writer thread doing
+// pread/pwrite. `queueDepth` bounds the number of requests in flight.
+std::unique_ptr<AsyncFileIO> createAsyncFileIO(unsigned queueDepth);
+
+#endif // ASYNC_FILE_IO_H
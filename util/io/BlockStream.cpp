@@ -0,0 +1,167 @@
+#include "BlockStream.h"
+#include "../memory/BufferPool.h"
+#include "../stats/Stats.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Read up to `length` bytes; a short count means end of input
+size_t readChunk(std::istream& input, uint8_t* buffer, size_t length) {
+    StageTimer timer(Stage::Read);
+    input.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(length));
+    timer.setBytes(static_cast<uint64_t>(input.gcount()));
+    return static_cast<size_t>(input.gcount());
+}
+
+bool writeChunk(std::ostream& output, const uint8_t* buffer, size_t length) {
+    StageTimer timer(Stage::Write, length);
+    output.write(reinterpret_cast<const char*>(buffer), static_cast<std::streamsize>(length));
+    if (!output) {
+        std::cerr << "Error: Failed to write output data." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Chunk loop shared by encryption and unpadded decryption; `addPadding` pads the
+// final chunk
+bool processStream(std::istream& input, std::ostream& output, size_t blockSize, const ChunkTransform& transform,
+                   bool addPadding) {
+    // One spare block so the padding always fits behind a full chunk. Recycled from the
+    // previous file of a batch; a short input touches only the pages it uses.
+    PooledBuffer buffer = BufferPool::acquire(STREAM_CHUNK_SIZE + blockSize);
+    ChunkChain chain(transform, blockSize);
+
+    while (true) {
+        size_t length = readChunk(input, buffer.data(), STREAM_CHUNK_SIZE);
+        if (input.bad()) {
+            std::cerr << "Error: Failed to read input data." << std::endl;
+            return false;
+        }
+
+        if (length < STREAM_CHUNK_SIZE) {
+            // Final chunk: PKCS#5/7 padding, a full block of it if already aligned
+            if (addPadding) {
+                size_t padLen = blockSize - (length % blockSize);
+                std::memset(buffer.data() + length, static_cast<int>(padLen), padLen);
+                length += padLen;
+            }
+            chain.run(buffer.data(), length);
+            return writeChunk(output, buffer.data(), length);
+        }
+
+        chain.run(buffer.data(), length);
+        if (!writeChunk(output, buffer.data(), length)) {
+            return false;
+        }
+    }
+}
+
+bool openFileStreams(const std::string& inputFile, const std::string& outputFile, std::ifstream& input,
+                     std::ofstream& output) {
+    if (!checkDistinctFiles(inputFile, outputFile)) {
+        return false;
+    }
+    input.open(inputFile, std::ios::binary);
+    if (!input) {
+        std::cerr << "Error: Could not open input file " << inputFile << std::endl;
+        return false;
+    }
+    output.open(outputFile, std::ios::binary);
+    if (!output) {
+        std::cerr << "Error: Could not open output file " << outputFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool checkDistinctFiles(const std::string& inputFile, const std::string& outputFile) {
+    // An output that does not exist yet cannot be the input
+    std::error_code error;
+    if (!std::filesystem::equivalent(inputFile, outputFile, error)) {
+        return true;
+    }
+    std::cerr << "Error: " << outputFile << " is the input file; writing it would destroy the input. "
+              << "Use --in-place to encrypt or decrypt a file in place." << std::endl;
+    return false;
+}
+
+bool encryptStream(std::istream& input, std::ostream& output, size_t blockSize, const ChunkTransform& transform,
+                   bool padded) {
+    return processStream(input, output, blockSize, transform, padded);
+}
+
+bool decryptStream(std::istream& input, std::ostream& output, size_t blockSize, const ChunkTransform& transform,
+                   bool padded) {
+    if (!padded) {
+        return processStream(input, output, blockSize, transform, false);
+    }
+
+    // The first `held` bytes are the already decrypted last block of the previous chunk
+    PooledBuffer buffer = BufferPool::acquire(STREAM_CHUNK_SIZE + blockSize);
+    ChunkChain chain(transform, blockSize);
+    size_t held = 0;
+
+    while (true) {
+        size_t length = readChunk(input, buffer.data() + held, STREAM_CHUNK_SIZE);
+        if (input.bad()) {
+            std::cerr << "Error: Failed to read input data." << std::endl;
+            return false;
+        }
+        if (length % blockSize != 0) {
+            std::cerr << "Error: Ciphertext length is not a multiple of the block size." << std::endl;
+            return false;
+        }
+
+        chain.run(buffer.data() + held, length);
+        size_t total = held + length;
+
+        if (length < STREAM_CHUNK_SIZE) {
+            // End of input: the last block carries the padding
+            if (total == 0) {
+                std::cerr << "Error: Ciphertext is empty." << std::endl;
+                return false;
+            }
+            size_t padLen = buffer[total - 1];
+            if (padLen == 0 || padLen > blockSize) {
+                std::cerr << "Error: Invalid padding (wrong key or corrupted data)." << std::endl;
+                return false;
+            }
+            return writeChunk(output, buffer.data(), total - padLen);
+        }
+
+        if (!writeChunk(output, buffer.data(), total - blockSize)) {
+            return false;
+        }
+        std::memmove(buffer.data(), buffer.data() + total - blockSize, blockSize);
+        held = blockSize;
+    }
+}
+
+bool encryptFileStream(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                       const ChunkTransform& transform, const std::vector<uint8_t>& header, bool padded) {
+    std::ifstream input;
+    std::ofstream output;
+    if (!openFileStreams(inputFile, outputFile, input, output)) {
+        return false;
+    }
+    output.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    return encryptStream(input, output, blockSize, transform, padded);
+}
+
+bool decryptFileStream(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                       const ChunkTransform& transform, size_t headerSize, bool padded) {
+    std::ifstream input;
+    std::ofstream output;
+    if (!openFileStreams(inputFile, outputFile, input, output)) {
+        return false;
+    }
+    input.seekg(static_cast<std::streamoff>(headerSize));
+    return decryptStream(input, output, blockSize, transform, padded);
+}
@@ -0,0 +1,82 @@
+#ifndef BLOCK_STREAM_H
+#define BLOCK_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Size of the reusable chunk buffer; a multiple of every supported block size and of
+// the widest bitsliced batch
+constexpr size_t STREAM_CHUNK_SIZE = 1 << 20;
+
+// One chunk of data handed to a transform
+struct FileChunk {
+    uint8_t* data;            // where the transformed chunk goes
+    const uint8_t* input;     // chunk contents; equal to `data` when transforming in place
+    size_t length;            // whole blocks, except for the final chunk of an unpadded stream
+    uint64_t offset;          // byte offset of the chunk in the (header-less) input
+    const uint8_t* previous;  // input block just before the chunk, nullptr at offset 0
+};
+
+// Encrypts or decrypts one chunk from `input` into `data`
+using ChunkTransform = std::function<void(const FileChunk& chunk)>;
+
+// Hands consecutive in-place chunks to the transform with their offset, keeping a copy
+// of the last input block of each chunk because the transform overwrites it
+class ChunkChain {
+public:
+    ChunkChain(const ChunkTransform& transform, size_t blockSize)
+        : transform(transform), blockSize(blockSize), previous(blockSize), next(blockSize) {}
+
+    void run(uint8_t* data, size_t length) {
+        if (length == 0) {
+            return;
+        }
+        if (length >= blockSize) {
+            std::memcpy(next.data(), data + length - blockSize, blockSize);
+        }
+        transform(FileChunk{data, data, length, offset, offset > 0 ? previous.data() : nullptr});
+        previous.swap(next);
+        offset += length;
+    }
+
+private:
+    const ChunkTransform& transform;
+    size_t blockSize;
+    std::vector<uint8_t> previous, next;
+    uint64_t offset = 0;
+};
+
+// Stream `input` through `transform` into `output` one chunk at a time. When `padded`,
+// PKCS#5/7 padding is appended to the final chunk; unpadded streams (e.g. CTR) may end
+// in a partial block. Memory use is bounded by one chunk buffer.
+bool encryptStream(std::istream& input, std::ostream& output, size_t blockSize, const ChunkTransform& transform,
+                   bool padded = true);
+
+// Stream ciphertext through `transform` into `output`. When `padded`, only the last
+// decrypted block is held back so its PKCS#5/7 padding can be checked and stripped at
+// the end.
+bool decryptStream(std::istream& input, std::ostream& output, size_t blockSize, const ChunkTransform& transform,
+                   bool padded = true);
+
+// Whether `inputFile` and `outputFile` are different files. Opening the output truncates
+// it, so a job whose output is its own input would destroy the data before reading it;
+// returns false (after printing the error) in that case. --in-place is the way to
+// rewrite a file.
+bool checkDistinctFiles(const std::string& inputFile, const std::string& outputFile);
+
+// encryptStream between two files, writing `header` (e.g. an IV) in front of the output
+bool encryptFileStream(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                       const ChunkTransform& transform, const std::vector<uint8_t>& header = {},
+                       bool padded = true);
+
+// decryptStream between two files, skipping a `headerSize`-byte header read by the caller
+bool decryptFileStream(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                       const ChunkTransform& transform, size_t headerSize = 0, bool padded = true);
+
+#endif // BLOCK_STREAM_H
@@ -0,0 +1,181 @@
+#include "ContainerFormat.h"
+#include "../algorithm/modes/CipherMode.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char MAGIC[4] = {'F', 'E', 'D', 'C'};
+
+void putLE(uint8_t* p, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint64_t getLE(const uint8_t* p, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+bool corrupted() {
+    std::cerr << "Error: Container index is corrupted." << std::endl;
+    return false;
+}
+
+} // namespace
+
+const char* containerCipherName(ContainerCipher cipher) {
+    switch (cipher) {
+        case ContainerCipher::DES: return "DES";
+        case ContainerCipher::TripleDES: return "3DES";
+        case ContainerCipher::AES: return "AES";
+    }
+    return "an unknown cipher";
+}
+
+bool writeContainerHeader(std::ostream& output, const ContainerHeader& header) {
+    uint8_t bytes[CONTAINER_HEADER_SIZE] = {};
+    std::memcpy(bytes, MAGIC, 4);
+    putLE(bytes + 4, header.version, 2);
+    bytes[6] = static_cast<uint8_t>(header.cipher);
+    bytes[7] = header.mode;
+    putLE(bytes + 8, header.blockSize, 2);
+    putLE(bytes + 12, header.chunkSize, 4);
+    putLE(bytes + 16, header.chunkCount, 8);
+    putLE(bytes + 24, header.plaintextSize, 8);
+    putLE(bytes + 32, header.indexOffset, 8);
+    output.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    return static_cast<bool>(output);
+}
+
+bool readContainerHeader(std::istream& input, ContainerHeader& header) {
+    uint8_t bytes[CONTAINER_HEADER_SIZE];
+    if (!input.read(reinterpret_cast<char*>(bytes), sizeof(bytes)) || std::memcmp(bytes, MAGIC, 4) != 0) {
+        std::cerr << "Error: Input is not an encrypted container (was it written with --container?)." << std::endl;
+        return false;
+    }
+    header.version = static_cast<uint16_t>(getLE(bytes + 4, 2));
+    header.cipher = static_cast<ContainerCipher>(bytes[6]);
+    header.mode = bytes[7];
+    header.blockSize = static_cast<uint16_t>(getLE(bytes + 8, 2));
+    header.chunkSize = static_cast<uint32_t>(getLE(bytes + 12, 4));
+    header.chunkCount = getLE(bytes + 16, 8);
+    header.plaintextSize = getLE(bytes + 24, 8);
+    header.indexOffset = getLE(bytes + 32, 8);
+
+    if (header.version != CONTAINER_VERSION) {
+        std::cerr << "Error: Unsupported container version " << header.version << "." << std::endl;
+        return false;
+    }
+    if (header.mode > static_cast<uint8_t>(CipherMode::CTR) || header.blockSize == 0 ||
+        header.blockSize > CONTAINER_IV_SIZE || header.chunkSize == 0 || header.chunkSize > CONTAINER_CHUNK_SIZE ||
+        header.chunkSize % header.blockSize != 0 ||
+        header.chunkCount != (header.plaintextSize + header.chunkSize - 1) / header.chunkSize +
+                                 (header.plaintextSize == 0 ? 1 : 0)) {
+        std::cerr << "Error: Container header is corrupted." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool readContainerHeader(std::istream& input, ContainerCipher expected, ContainerHeader& header) {
+    if (!readContainerHeader(input, header)) {
+        return false;
+    }
+    if (header.cipher != expected) {
+        std::cerr << "Error: Container was encrypted with " << containerCipherName(header.cipher) << ", not "
+                  << containerCipherName(expected) << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+CipherMode containerFileMode(const std::string& inputFile, CipherMode fallback) {
+    std::ifstream input(inputFile, std::ios::binary);
+    uint8_t bytes[8];
+    if (!input.read(reinterpret_cast<char*>(bytes), sizeof(bytes)) || std::memcmp(bytes, MAGIC, 4) != 0 ||
+        bytes[7] > static_cast<uint8_t>(CipherMode::CTR)) {
+        return fallback;
+    }
+    return static_cast<CipherMode>(bytes[7]);
+}
+
+uint64_t containerChunkPlaintext(const ContainerHeader& header, uint64_t number) {
+    return std::min<uint64_t>(header.chunkSize, header.plaintextSize - number * header.chunkSize);
+}
+
+uint64_t containerChunkLength(const ContainerHeader& header, uint64_t number) {
+    uint64_t plain = containerChunkPlaintext(header, number);
+    bool padded = header.mode != static_cast<uint8_t>(CipherMode::CTR) && number + 1 == header.chunkCount;
+    return plain + (padded ? header.blockSize - plain % header.blockSize : 0);
+}
+
+bool writeContainerIndex(std::ostream& output, const std::vector<ContainerChunk>& chunks) {
+    for (const ContainerChunk& chunk : chunks) {
+        uint8_t bytes[CONTAINER_INDEX_ENTRY_SIZE];
+        putLE(bytes, chunk.offset, 8);
+        putLE(bytes + 8, chunk.length, 4);
+        std::memcpy(bytes + 12, chunk.iv, CONTAINER_IV_SIZE);
+        putLE(bytes + 12 + CONTAINER_IV_SIZE, chunk.checksum, 4);
+        putLE(bytes + 16 + CONTAINER_IV_SIZE, chunk.flags, 4);
+        output.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+    return static_cast<bool>(output);
+}
+
+bool readContainerIndex(std::istream& input, const ContainerHeader& header, uint64_t first, uint64_t count,
+                        std::vector<ContainerChunk>& chunks) {
+    if (first + count > header.chunkCount) {
+        return corrupted();
+    }
+    bool padded = header.mode != static_cast<uint8_t>(CipherMode::CTR);
+    input.seekg(static_cast<std::streamoff>(header.indexOffset + first * CONTAINER_INDEX_ENTRY_SIZE));
+
+    chunks.resize(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        ContainerChunk& chunk = chunks[i];
+        uint8_t bytes[CONTAINER_INDEX_ENTRY_SIZE];
+        if (!input.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+            return corrupted();
+        }
+        chunk.offset = getLE(bytes, 8);
+        chunk.length = static_cast<uint32_t>(getLE(bytes + 8, 4));
+        std::memcpy(chunk.iv, bytes + 12, CONTAINER_IV_SIZE);
+        chunk.checksum = static_cast<uint32_t>(getLE(bytes + 12 + CONTAINER_IV_SIZE, 4));
+        chunk.flags = static_cast<uint32_t>(getLE(bytes + 16 + CONTAINER_IV_SIZE, 4));
+
+        // Every chunk must lie between the header and the index. An uncompressed chunk
+        // is exactly as long as its plaintext says; a compressed one is never longer
+        // than a full chunk and, when padded, whole blocks.
+        bool lengthOk = (chunk.flags & CONTAINER_CHUNK_COMPRESSED)
+                            ? chunk.length <= header.chunkSize && (!padded || (chunk.length != 0 && chunk.length % header.blockSize == 0))
+                            : chunk.length == containerChunkLength(header, first + i);
+        if (chunk.offset < CONTAINER_HEADER_SIZE || chunk.offset > header.indexOffset ||
+            chunk.length > header.indexOffset - chunk.offset || (chunk.flags & ~CONTAINER_CHUNK_COMPRESSED) != 0 ||
+            !lengthOk) {
+            return corrupted();
+        }
+    }
+    return true;
+}
+
+bool parseByteRange(const std::string& text, ByteRange& range) {
+    size_t colon = text.find(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == text.size() ||
+        text.find_first_not_of("0123456789:") != std::string::npos || text.find(':', colon + 1) != std::string::npos) {
+        return false;
+    }
+    try {
+        range.offset = std::stoull(text.substr(0, colon));
+        range.length = std::stoull(text.substr(colon + 1));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
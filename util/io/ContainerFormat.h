@@ -0,0 +1,118 @@
+#ifndef CONTAINER_FORMAT_H
+#define CONTAINER_FORMAT_H
+
+/**
+ * @file ContainerFormat.h
+ * @brief On-disk layout of the seekable container format (--container).
+ *
+ * A container splits the plaintext into chunks of `chunkSize` bytes and encrypts each
+ * chunk on its own, with its own IV, so any chunk can be decrypted without the others.
+ * All integers are little-endian.
+ *
+ *   header  CONTAINER_HEADER_SIZE bytes
+ *           magic "FEDC", version (u16), cipher (u8), mode (u8), block size (u16),
+ *           reserved (u16), chunk size (u32), chunk count (u64), plaintext size (u64),
+ *           index offset (u64)
+ *   chunks  the ciphertext of every chunk, in order. Only the last chunk is padded
+ *           (ECB and CBC); CTR chunks are exactly as long as their plaintext.
+ *   index   chunk count entries of CONTAINER_INDEX_ENTRY_SIZE bytes:
+ *           ciphertext offset in the file (u64), ciphertext length (u32), IV (16 bytes,
+ *           the first block size bytes used), CRC-32C of the chunk's ciphertext (u32),
+ *           flags (u32, CONTAINER_CHUNK_* bits)
+ *
+ * A chunk flagged CONTAINER_CHUNK_COMPRESSED holds its plaintext compressed with
+ * util/compress/LZBlock.h; in ECB and CBC the compressed bytes are padded on their own.
+ * Other chunks hold the plaintext as it is.
+ *
+ * The index is written last so a container can be produced in one pass; the header
+ * is rewritten at the end with the totals.
+ *
+ * The checksums cover the ciphertext, so a container can be checked for corruption
+ * (--verify) without the key and without decrypting anything. Chunk buffers are sized
+ * from the header before any checksum is seen, so a chunk size above the one written
+ * (CONTAINER_CHUNK_SIZE) is rejected as corrupted.
+ */
+
+#include "../algorithm/modes/CipherMode.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+constexpr uint16_t CONTAINER_VERSION = 1;
+constexpr uint32_t CONTAINER_CHUNK_SIZE = 64 << 10;
+constexpr size_t CONTAINER_HEADER_SIZE = 40;
+constexpr size_t CONTAINER_IV_SIZE = 16;
+constexpr size_t CONTAINER_INDEX_ENTRY_SIZE = 20 + CONTAINER_IV_SIZE;
+
+// ContainerChunk::flags
+constexpr uint32_t CONTAINER_CHUNK_COMPRESSED = 1;
+
+// Which algorithm wrote a container; stored so a wrong algorithm is reported
+enum class ContainerCipher : uint8_t {
+    DES = 1,
+    TripleDES = 2,
+    AES = 3
+};
+
+struct ContainerHeader {
+    uint16_t version = CONTAINER_VERSION;
+    ContainerCipher cipher = ContainerCipher::DES;
+    uint8_t mode = 0;  // CipherMode value
+    uint16_t blockSize = 0;
+    uint32_t chunkSize = CONTAINER_CHUNK_SIZE;
+    uint64_t chunkCount = 0;
+    uint64_t plaintextSize = 0;
+    uint64_t indexOffset = 0;
+};
+
+struct ContainerChunk {
+    uint64_t offset = 0;  // Where the chunk's ciphertext starts in the file
+    uint32_t length = 0;  // Ciphertext bytes
+    uint8_t iv[CONTAINER_IV_SIZE] = {};
+    uint32_t checksum = 0;  // CRC-32C of the ciphertext
+    uint32_t flags = 0;  // CONTAINER_CHUNK_*
+};
+
+// Plaintext bytes [offset, offset + length) for --range; the default is everything
+struct ByteRange {
+    uint64_t offset = 0;
+    uint64_t length = UINT64_MAX;
+};
+
+const char* containerCipherName(ContainerCipher cipher);
+
+// Write the header at the current position
+bool writeContainerHeader(std::ostream& output, const ContainerHeader& header);
+
+// Read and check the header at the start of `input`. False (after printing the error)
+// if it is not a container, has an unknown version or was written by another cipher.
+bool readContainerHeader(std::istream& input, ContainerCipher expected, ContainerHeader& header);
+
+// The same, accepting a container written by any cipher
+bool readContainerHeader(std::istream& input, ContainerHeader& header);
+
+// The mode recorded in the header of the container `inputFile`, which decryption uses
+// whatever --mode says; `fallback` if the header cannot be read (decryption then
+// reports why)
+CipherMode containerFileMode(const std::string& inputFile, CipherMode fallback);
+
+// Plaintext bytes in chunk `number`
+uint64_t containerChunkPlaintext(const ContainerHeader& header, uint64_t number);
+
+// Ciphertext length chunk `number` must have when stored uncompressed: its plaintext,
+// plus the padding on the last chunk in the padded modes
+uint64_t containerChunkLength(const ContainerHeader& header, uint64_t number);
+
+bool writeContainerIndex(std::ostream& output, const std::vector<ContainerChunk>& chunks);
+
+// Read index entries [first, first + count), checking each against the header (where
+// it lies and how long it is)
+bool readContainerIndex(std::istream& input, const ContainerHeader& header, uint64_t first, uint64_t count,
+                        std::vector<ContainerChunk>& chunks);
+
+// Parse "<offset>:<length>" (decimal byte counts)
+bool parseByteRange(const std::string& text, ByteRange& range);
+
+#endif // CONTAINER_FORMAT_H
@@ -0,0 +1,22 @@
+#ifndef CONTAINER_VERIFY_H
+#define CONTAINER_VERIFY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Totals of a --verify scan
+struct VerifyResult {
+    uint64_t chunks = 0;
+    uint64_t damaged = 0;
+    uint64_t bytes = 0;  // Ciphertext bytes checked
+    double seconds = 0;
+};
+
+// Check every chunk of a container against the CRC-32C in its index, on `threads`
+// threads. Needs neither the key nor the algorithm: only ciphertext is read and
+// nothing is decrypted or written. Each damaged chunk is reported with the plaintext
+// bytes it holds. Returns false if the container is unreadable or any chunk is damaged.
+bool verifyContainer(const std::string& inputFile, size_t threads, VerifyResult& result);
+
+#endif // CONTAINER_VERIFY_H
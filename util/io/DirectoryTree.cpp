@@ -0,0 +1,141 @@
+#include "DirectoryTree.h"
+#include "../thread/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Consecutive runs of the sorted file list, one per task
+struct TreeTask {
+    size_t first;
+    size_t count;
+};
+
+std::vector<TreeTask> batchFiles(const std::vector<TreeFile>& files) {
+    std::vector<TreeTask> tasks;
+    for (size_t index = 0; index < files.size();) {
+        TreeTask task{index, 0};
+        uint64_t bytes = 0;
+        do {
+            bytes += files[index].size;
+            ++task.count;
+            ++index;
+        } while (index < files.size() && bytes < TREE_BATCH_BYTES && task.count < TREE_BATCH_FILES);
+        tasks.push_back(task);
+    }
+    return tasks;
+}
+
+} // namespace
+
+bool collectTree(const std::string& inputDir, const std::string& outputDir, std::vector<TreeFile>& files) {
+    std::error_code error;
+    fs::path input(inputDir);
+    if (!fs::is_directory(input, error)) {
+        std::cerr << "Error: " << inputDir << " is not a directory." << std::endl;
+        return false;
+    }
+
+    // Every output file would be its own input, truncated before it is read
+    fs::path output(outputDir);
+    if (fs::equivalent(input, output, error)) {
+        std::cerr << "Error: " << outputDir << " is the input directory; writing into it would destroy the input. "
+                  << "Give a separate output directory." << std::endl;
+        return false;
+    }
+    error.clear();
+
+    // An output directory inside the input must not be walked into
+    fs::path outputCanonical = fs::weakly_canonical(output, error);
+
+    std::vector<fs::path> directories{fs::path()};
+    files.clear();
+    fs::recursive_directory_iterator it(input, fs::directory_options::skip_permission_denied, error);
+    for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+        const fs::directory_entry& entry = *it;
+        fs::path relative = entry.path().lexically_relative(input);
+        std::error_code status;
+        if (entry.is_directory(status)) {
+            if (fs::weakly_canonical(entry.path(), status) == outputCanonical) {
+                it.disable_recursion_pending();
+            } else {
+                directories.push_back(relative);
+            }
+        } else if (entry.is_regular_file(status)) {
+            files.push_back(TreeFile{entry.path().string(), (output / relative).string(), entry.file_size(status)});
+        }
+    }
+    if (error) {
+        std::cerr << "Error: Could not read directory " << inputDir << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    // Create the output tree only now, so none of it shows up in the walk
+    for (const fs::path& directory : directories) {
+        fs::create_directories(output / directory, error);
+        if (error) {
+            std::cerr << "Error: Could not create directory " << (output / directory).string() << std::endl;
+            return false;
+        }
+    }
+
+    std::stable_sort(files.begin(), files.end(),
+                     [](const TreeFile& a, const TreeFile& b) { return a.size > b.size; });
+    return true;
+}
+
+TreeResult processTree(const std::vector<TreeFile>& files, size_t threads,
+                       const std::function<bool(const TreeFile& file)>& process) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<TreeTask> tasks = batchFiles(files);
+    std::atomic<size_t> nextTask{0};
+    std::atomic<size_t> failed{0};
+    std::mutex reportMutex;
+
+    // Every thread takes the next task in size order; the pool's own deques would hand
+    // them out in whatever order they were queued per worker
+    auto runTasks = [&](size_t) {
+        for (size_t task = nextTask++; task < tasks.size(); task = nextTask++) {
+            for (size_t index = tasks[task].first; index < tasks[task].first + tasks[task].count; ++index) {
+                if (!process(files[index])) {
+                    ++failed;
+                    std::lock_guard<std::mutex> lock(reportMutex);
+                    std::cerr << "Error: Failed to process " << files[index].input << std::endl;
+                }
+            }
+        }
+    };
+
+    size_t workers = std::max<size_t>(1, std::min(threads, tasks.size()));
+    ThreadPool pool(workers - 1);
+    pool.parallelFor(workers, runTasks);
+
+    TreeResult result;
+    result.files = files.size();
+    result.failed = failed.load();
+    for (const TreeFile& file : files) {
+        result.bytes += file.size;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// Through std::cout like the job's other messages, so whoever redirects those (e.g. the
+// --serve daemon) gets these lines too
+void printTreeResult(const char* action, const TreeResult& result) {
+    char line[128];
+    std::snprintf(line, sizeof(line), "%s %zu files (%.1f MB) in %.3f s", action, result.files - result.failed,
+                  static_cast<double>(result.bytes) / (1 << 20), result.seconds);
+    std::cout << line << std::endl;
+    if (result.failed > 0) {
+        std::cout << result.failed << " files failed" << std::endl;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef DIRECTORY_TREE_H
+#define DIRECTORY_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Files smaller than this are grouped so that one task covers at least this many bytes
+// (or TREE_BATCH_FILES files), keeping per-task overhead small next to the work
+constexpr uint64_t TREE_BATCH_BYTES = 1 << 20;
+constexpr size_t TREE_BATCH_FILES = 256;
+
+// A regular file found under the input directory and where its result goes
+struct TreeFile {
+    std::string input;
+    std::string output;
+    uint64_t size;
+};
+
+// Totals of a directory job
+struct TreeResult {
+    size_t files = 0;
+    size_t failed = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+// Walk `inputDir` recursively and create the same directory structure under
+// `outputDir`. Returns the regular files sorted largest first, or false (after printing
+// the error) if the input is not a directory, the output is the input directory itself
+// or the output cannot be created.
+bool collectTree(const std::string& inputDir, const std::string& outputDir, std::vector<TreeFile>& files);
+
+// Run `process` on every file on `threads` threads. Files are started largest first so
+// a big file picked up late does not leave one thread working alone at the end; files
+// under TREE_BATCH_BYTES are handed out in batches. A file for which `process` returns
+// false is reported and counted as failed.
+TreeResult processTree(const std::vector<TreeFile>& files, size_t threads,
+                       const std::function<bool(const TreeFile& file)>& process);
+
+// Print e.g. "Encrypted 1200 files (35.2 MB) in 0.412 s", plus the number that failed
+void printTreeResult(const char* action, const TreeResult& result);
+
+#endif // DIRECTORY_TREE_H
@@ -0,0 +1,25 @@
+#ifndef FILE_DESCRIPTOR_H
+#define FILE_DESCRIPTOR_H
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <unistd.h>
+
+// Closes the descriptor when the job is done, whichever way it ends
+struct FileDescriptor {
+    int fd = -1;
+
+    FileDescriptor() = default;
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    ~FileDescriptor() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+#endif
+
+#endif // FILE_DESCRIPTOR_H
@@ -0,0 +1,27 @@
+#include "IOBackend.h"
+#include <algorithm>
+#include <cctype>
+
+bool parseIOBackend(const std::string& name, IOBackend& backend) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    for (IOBackend candidate : {IOBackend::Auto, IOBackend::Mapped, IOBackend::Pipeline, IOBackend::Stream}) {
+        if (lower == ioBackendName(candidate)) {
+            backend = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* ioBackendName(IOBackend backend) {
+    switch (backend) {
+        case IOBackend::Auto: return "auto";
+        case IOBackend::Mapped: return "mmap";
+        case IOBackend::Pipeline: return "pipeline";
+        case IOBackend::Stream: return "stream";
+    }
+    return "?";
+}
@@ -0,0 +1,20 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <string>
+
+// How file jobs move data between the disk and the cipher, selectable with --io
+enum class IOBackend {
+    Auto,      // mmap for large regular files, else pread/pwrite on the pool or the pipeline
+    Mapped,    // memory-map both files whenever they can be mapped
+    Pipeline,  // asynchronous read/transform/write pipeline on one thread
+    Stream     // plain chunk loop (or pread/pwrite on the pool with --threads)
+};
+
+// Parse a backend name such as "pipeline" (case-insensitive); returns false if unknown
+bool parseIOBackend(const std::string& name, IOBackend& backend);
+
+// Lower-case name of the backend, e.g. "mmap"
+const char* ioBackendName(IOBackend backend);
+
+#endif // IO_BACKEND_H
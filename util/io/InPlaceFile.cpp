@@ -0,0 +1,553 @@
+/**
+ * @file InPlaceFile.cpp
+ * @brief Journaled chunk loop for --in-place.
+ *
+ * Journal record, at the start of slot `sequence % 2` (integers little-endian):
+ *
+ *   magic "FEIJ", version (u16), operation (u8: 0 encrypt, 1 decrypt), cipher (u8),
+ *   mode (u8), flags (u8, FLAG_*), block size (u16), header size (u8), carry length (u8),
+ *   trailer length (u8), reserved (u8), key check (u32), pending length (u32),
+ *   sequence (u64), input length (u64), original size (u64), truncate to (u64),
+ *   done (u64), output end (u64), pending offset (u64), IV, trailer, carry and chain
+ *   (16 bytes each), CRC-32C of all of the above and the pending bytes (u32), zeros up to
+ *   RECORD_SIZE
+ *
+ * It is followed by the pending bytes, which the step writes to the file at the pending
+ * offset. Offsets in the job (done, input length) count body bytes: after the IV header
+ * in ciphertext, from the start in plaintext.
+ */
+
+#include "InPlaceFile.h"
+#include "ContainerFormat.h"
+#include "../algorithm/modes/CipherMode.h"
+#include "../checksum/CRC32C.h"
+#include "../memory/BufferPool.h"
+#include "../stats/Stats.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define IN_PLACE_FILE_IO 1
+#include "FileDescriptor.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::string inPlaceJournalPath(const std::string& file) {
+    return file + ".journal";
+}
+
+#ifdef IN_PLACE_FILE_IO
+
+namespace {
+
+const char JOURNAL_MAGIC[4] = {'F', 'E', 'I', 'J'};
+constexpr uint16_t JOURNAL_VERSION = 1;
+constexpr size_t RECORD_SIZE = 160;
+constexpr size_t CHECKSUMMED_SIZE = 144;  // Record bytes before the CRC
+constexpr size_t MAX_BLOCK = 16;
+// A chunk plus the IV header, the padding and the trailer
+constexpr size_t MAX_PENDING = IN_PLACE_CHUNK_SIZE + 3 * MAX_BLOCK;
+constexpr size_t SLOT_SIZE = RECORD_SIZE + MAX_PENDING;
+
+constexpr uint8_t FLAG_PADDED = 1;
+constexpr uint8_t FLAG_ROLLBACK = 2;  // The job undoes an interrupted one
+constexpr uint8_t FLAG_COMPLETE = 4;  // The last chunk has been processed
+
+// Everything needed to carry on after the last committed step
+struct JournalState {
+    bool encrypt = true;
+    uint8_t cipher = 0;
+    uint8_t mode = 0;
+    uint8_t flags = 0;
+    uint16_t blockSize = 0;
+    uint8_t headerSize = 0;      // IV header bytes in front of the ciphertext
+    uint8_t carryLength = 0;
+    uint8_t trailerLength = 0;
+    uint32_t keyCheck = 0;
+    uint32_t pendingLength = 0;
+    uint64_t sequence = 0;
+    uint64_t inputLength = 0;    // Body bytes the job processes
+    uint64_t originalSize = 0;   // File size before the first job started
+    uint64_t truncateTo = 0;     // Final file size; UINT64_MAX means where the output ends
+    uint64_t done = 0;           // Body bytes processed
+    uint64_t outputEnd = 0;      // Where the output written so far ends in the file
+    uint64_t pendingOffset = 0;
+    uint8_t iv[MAX_BLOCK] = {};
+    uint8_t trailer[MAX_BLOCK] = {};  // Written right after the output of the last chunk
+    uint8_t carry[MAX_BLOCK] = {};    // Input bytes [done, done + carryLength) the file no longer holds
+    uint8_t chain[MAX_BLOCK] = {};    // Last ciphertext block before `done`
+};
+
+void putLE(uint8_t* p, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint64_t getLE(const uint8_t* p, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+// Record header for `state` into `buffer`, whose pending bytes follow at RECORD_SIZE
+void encodeRecord(const JournalState& state, uint8_t* buffer) {
+    std::memset(buffer, 0, RECORD_SIZE);
+    std::memcpy(buffer, JOURNAL_MAGIC, 4);
+    putLE(buffer + 4, JOURNAL_VERSION, 2);
+    buffer[6] = state.encrypt ? 0 : 1;
+    buffer[7] = state.cipher;
+    buffer[8] = state.mode;
+    buffer[9] = state.flags;
+    putLE(buffer + 10, state.blockSize, 2);
+    buffer[12] = state.headerSize;
+    buffer[13] = state.carryLength;
+    buffer[14] = state.trailerLength;
+    putLE(buffer + 16, state.keyCheck, 4);
+    putLE(buffer + 20, state.pendingLength, 4);
+    putLE(buffer + 24, state.sequence, 8);
+    putLE(buffer + 32, state.inputLength, 8);
+    putLE(buffer + 40, state.originalSize, 8);
+    putLE(buffer + 48, state.truncateTo, 8);
+    putLE(buffer + 56, state.done, 8);
+    putLE(buffer + 64, state.outputEnd, 8);
+    putLE(buffer + 72, state.pendingOffset, 8);
+    std::memcpy(buffer + 80, state.iv, MAX_BLOCK);
+    std::memcpy(buffer + 96, state.trailer, MAX_BLOCK);
+    std::memcpy(buffer + 112, state.carry, MAX_BLOCK);
+    std::memcpy(buffer + 128, state.chain, MAX_BLOCK);
+    uint32_t checksum = crc32c(buffer, CHECKSUMMED_SIZE);
+    putLE(buffer + CHECKSUMMED_SIZE, crc32c(buffer + RECORD_SIZE, state.pendingLength, checksum), 4);
+}
+
+// Header fields of a record; false if it is not one
+bool decodeRecord(const uint8_t* buffer, JournalState& state) {
+    if (std::memcmp(buffer, JOURNAL_MAGIC, 4) != 0 || getLE(buffer + 4, 2) != JOURNAL_VERSION) {
+        return false;
+    }
+    state.encrypt = buffer[6] == 0;
+    state.cipher = buffer[7];
+    state.mode = buffer[8];
+    state.flags = buffer[9];
+    state.blockSize = static_cast<uint16_t>(getLE(buffer + 10, 2));
+    state.headerSize = buffer[12];
+    state.carryLength = buffer[13];
+    state.trailerLength = buffer[14];
+    state.keyCheck = static_cast<uint32_t>(getLE(buffer + 16, 4));
+    state.pendingLength = static_cast<uint32_t>(getLE(buffer + 20, 4));
+    state.sequence = getLE(buffer + 24, 8);
+    state.inputLength = getLE(buffer + 32, 8);
+    state.originalSize = getLE(buffer + 40, 8);
+    state.truncateTo = getLE(buffer + 48, 8);
+    state.done = getLE(buffer + 56, 8);
+    state.outputEnd = getLE(buffer + 64, 8);
+    state.pendingOffset = getLE(buffer + 72, 8);
+    std::memcpy(state.iv, buffer + 80, MAX_BLOCK);
+    std::memcpy(state.trailer, buffer + 96, MAX_BLOCK);
+    std::memcpy(state.carry, buffer + 112, MAX_BLOCK);
+    std::memcpy(state.chain, buffer + 128, MAX_BLOCK);
+    return state.blockSize != 0 && state.blockSize <= MAX_BLOCK && state.headerSize <= state.blockSize &&
+           state.carryLength <= MAX_BLOCK && state.trailerLength <= MAX_BLOCK && state.pendingLength <= MAX_PENDING &&
+           state.done <= state.inputLength;
+}
+
+bool readAt(int fd, uint8_t* buffer, size_t length, uint64_t offset) {
+    StageTimer timer(Stage::Read, length);
+    while (length > 0) {
+        ssize_t got = pread(fd, buffer, length, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        buffer += got;
+        length -= static_cast<size_t>(got);
+        offset += static_cast<uint64_t>(got);
+    }
+    return true;
+}
+
+bool writeAt(int fd, const uint8_t* buffer, size_t length, uint64_t offset) {
+    StageTimer timer(Stage::Write, length);
+    while (length > 0) {
+        ssize_t written = pwrite(fd, buffer, length, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        buffer += written;
+        length -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+// Flush the file's data to the disk; its size is included, its timestamps need not be
+bool syncFile(int fd) {
+    StageTimer timer(Stage::Write);
+#if defined(__APPLE__)
+    return fsync(fd) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+// Make the creation or removal of the journal durable
+void syncDirectory(const std::string& file) {
+    std::filesystem::path directory = std::filesystem::path(file).parent_path();
+    FileDescriptor dir;
+    dir.fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (dir.fd >= 0) {
+        fsync(dir.fd);
+    }
+}
+
+const char* operationName(const JournalState& state) {
+    if (state.flags & FLAG_ROLLBACK) {
+        return "rollback";
+    }
+    return state.encrypt ? "encryption" : "decryption";
+}
+
+// The newest intact record of the journal, with its pending bytes in `buffer`
+bool loadJournal(int journal, JournalState& state, uint8_t* buffer) {
+    bool found = false;
+    uint64_t bestSlot = 0;
+    for (uint64_t slot = 0; slot < 2; ++slot) {
+        JournalState candidate;
+        if (!readAt(journal, buffer, RECORD_SIZE, slot * SLOT_SIZE) || !decodeRecord(buffer, candidate) ||
+            !readAt(journal, buffer + RECORD_SIZE, candidate.pendingLength, slot * SLOT_SIZE + RECORD_SIZE)) {
+            continue;
+        }
+        uint32_t checksum = crc32c(buffer + RECORD_SIZE, candidate.pendingLength, crc32c(buffer, CHECKSUMMED_SIZE));
+        if (checksum != getLE(buffer + CHECKSUMMED_SIZE, 4) || candidate.sequence % 2 != slot) {
+            continue;
+        }
+        if (!found || candidate.sequence > state.sequence) {
+            state = candidate;
+            bestSlot = slot;
+            found = true;
+        }
+    }
+    // The second slot was read last; read the first again if it holds the newer record
+    if (found && bestSlot == 0 &&
+        !readAt(journal, buffer + RECORD_SIZE, state.pendingLength, RECORD_SIZE)) {
+        found = false;
+    }
+    return found;
+}
+
+// Whether a record was ever started in slot 0. The first record of a journal goes to
+// slot 1, so without one the run stopped while writing its first record, before the
+// file was touched.
+bool journalStarted(int journal) {
+    uint8_t magic[4] = {};
+    return readAt(journal, magic, sizeof(magic), 0) && std::memcmp(magic, JOURNAL_MAGIC, 4) == 0;
+}
+
+// Write the pending bytes of the committed step to the file
+bool applyPending(int fd, const JournalState& state, const uint8_t* buffer) {
+    if (!writeAt(fd, buffer + RECORD_SIZE, state.pendingLength, state.pendingOffset) || !syncFile(fd)) {
+        std::cerr << "Error: Failed to write output data." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Journal the step in `state` (and its pending bytes in `buffer`), then carry it out.
+// The record reaches the disk before the file is touched, so a crash during the file
+// write is repaired by replaying the record.
+bool commitStep(int fd, int journal, JournalState& state, uint8_t* buffer) {
+    ++state.sequence;
+    encodeRecord(state, buffer);
+    if (!writeAt(journal, buffer, RECORD_SIZE + state.pendingLength, (state.sequence % 2) * SLOT_SIZE) ||
+        !syncFile(journal)) {
+        std::cerr << "Error: Could not write the journal." << std::endl;
+        return false;
+    }
+    return applyPending(fd, state, buffer);
+}
+
+// The job that undoes `job` from where it stopped, under the same IV and key
+JournalState rollbackJob(const JournalState& job) {
+    JournalState undo = job;
+    bool complete = (job.flags & FLAG_COMPLETE) != 0;
+    undo.encrypt = !job.encrypt;
+    undo.flags = FLAG_ROLLBACK | (complete ? (job.flags & FLAG_PADDED) : 0);
+    if (job.encrypt) {
+        // Decrypt the ciphertext written so far; the block the last chunk overwrote
+        // (the carry) goes back behind it
+        undo.inputLength = complete ? job.outputEnd - job.headerSize : job.done;
+        undo.trailerLength = complete ? 0 : job.carryLength;
+        std::memcpy(undo.trailer, job.carry, MAX_BLOCK);
+    } else {
+        // Encrypt the plaintext written so far back in front of the ciphertext not yet read
+        undo.inputLength = complete ? job.outputEnd : job.done;
+        undo.trailerLength = 0;
+    }
+    undo.truncateTo = job.originalSize;
+    undo.done = 0;
+    undo.outputEnd = 0;
+    undo.carryLength = 0;
+    undo.pendingOffset = 0;
+    undo.pendingLength = 0;
+    return undo;
+}
+
+// Process the next chunk of the job and commit it
+bool runStep(int fd, int journal, JournalState& state, const InPlaceCipher& cipher, uint8_t* buffer) {
+    size_t B = state.blockSize;
+    size_t S = state.headerSize;
+    uint64_t offset = state.done;
+    size_t length = static_cast<size_t>(std::min<uint64_t>(IN_PLACE_CHUNK_SIZE, state.inputLength - offset));
+    bool last = offset + length == state.inputLength;
+    bool padded = (state.flags & FLAG_PADDED) != 0;
+    uint8_t* pending = buffer + RECORD_SIZE;
+
+    if (state.encrypt) {
+        // The first chunk goes out behind the IV header
+        bool first = offset == 0 && S > 0;
+        uint8_t* data = pending + (first ? S : 0);
+        size_t carried = std::min<size_t>(state.carryLength, length);
+        std::memcpy(data, state.carry, carried);
+        if (!readAt(fd, data + carried, length - carried, offset + carried)) {
+            std::cerr << "Error: Failed to read input data." << std::endl;
+            return false;
+        }
+        // Written S bytes further on, the ciphertext covers the start of the next chunk
+        uint8_t nextCarry[MAX_BLOCK] = {};
+        size_t nextCarryLength = last ? 0 : static_cast<size_t>(std::min<uint64_t>(S, state.inputLength - offset - length));
+        if (!readAt(fd, nextCarry, nextCarryLength, offset + length)) {
+            std::cerr << "Error: Failed to read input data." << std::endl;
+            return false;
+        }
+
+        size_t chunkLength = length;
+        if (last && padded) {
+            size_t padLen = B - length % B;
+            std::memset(data + length, static_cast<int>(padLen), padLen);
+            chunkLength += padLen;
+        }
+        cipher.encrypt(FileChunk{data, data, chunkLength, offset, offset > 0 ? state.chain : nullptr});
+        if (chunkLength >= B) {
+            std::memcpy(state.chain, data + chunkLength - B, B);
+        }
+        if (first) {
+            std::memcpy(pending, state.iv, S);
+        }
+        state.pendingOffset = first ? 0 : S + offset;
+        state.pendingLength = static_cast<uint32_t>(chunkLength + (first ? S : 0));
+        state.outputEnd = S + offset + chunkLength;
+        std::memcpy(state.carry, nextCarry, MAX_BLOCK);
+        state.carryLength = static_cast<uint8_t>(nextCarryLength);
+    } else {
+        // Plaintext lands S bytes before the ciphertext it comes from, never on unread input
+        uint8_t* data = pending;
+        if (!readAt(fd, data, length, S + offset)) {
+            std::cerr << "Error: Failed to read input data." << std::endl;
+            return false;
+        }
+        uint8_t lastBlock[MAX_BLOCK] = {};
+        if (length >= B) {
+            std::memcpy(lastBlock, data + length - B, B);
+        }
+        cipher.decrypt(FileChunk{data, data, length, offset, offset > 0 ? state.chain : nullptr});
+
+        size_t outputLength = length;
+        if (last && padded) {
+            size_t padLen = data[length - 1];
+            if (padLen == 0 || padLen > B) {
+                std::cerr << "Error: Invalid padding (wrong key or corrupted data)." << std::endl;
+                return false;
+            }
+            outputLength -= padLen;
+        }
+        if (length >= B) {
+            std::memcpy(state.chain, lastBlock, B);
+        }
+        if (last) {
+            std::memcpy(data + outputLength, state.trailer, state.trailerLength);
+        }
+        state.pendingOffset = offset;
+        state.pendingLength = static_cast<uint32_t>(outputLength + (last ? state.trailerLength : 0));
+        state.outputEnd = offset + outputLength;
+    }
+
+    state.done += length;
+    if (last) {
+        state.flags |= FLAG_COMPLETE;
+    }
+    return commitStep(fd, journal, state, buffer);
+}
+
+// A new job for a file with no journal
+bool startJob(int fd, uint64_t size, InPlaceOperation operation, const InPlaceCipher& cipher, JournalState& state) {
+    size_t B = cipher.blockSize;
+    state.encrypt = operation == InPlaceOperation::Encrypt;
+    state.cipher = cipher.cipher;
+    state.mode = cipher.mode;
+    state.flags = cipher.padded ? FLAG_PADDED : 0;
+    state.blockSize = static_cast<uint16_t>(B);
+    state.headerSize = static_cast<uint8_t>(cipher.hasIV ? B : 0);
+    state.keyCheck = cipher.keyCheck;
+    state.originalSize = size;
+    state.truncateTo = UINT64_MAX;
+
+    if (state.encrypt) {
+        state.inputLength = size;
+        std::memcpy(state.iv, cipher.iv, state.headerSize);
+        return true;
+    }
+    if (size < state.headerSize) {
+        std::cerr << "Error: Ciphertext is too short to contain an IV." << std::endl;
+        return false;
+    }
+    state.inputLength = size - state.headerSize;
+    if (cipher.padded && state.inputLength == 0) {
+        std::cerr << "Error: Ciphertext is empty." << std::endl;
+        return false;
+    }
+    if (cipher.padded && state.inputLength % B != 0) {
+        std::cerr << "Error: Ciphertext length is not a multiple of the block size." << std::endl;
+        return false;
+    }
+    if (!readAt(fd, state.iv, state.headerSize, 0)) {
+        std::cerr << "Error: Failed to read input data." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Whether the journal's job can be continued with the caller's operation, cipher and key
+bool checkJournal(const std::string& file, const JournalState& state, InPlaceOperation operation,
+                  const InPlaceCipher& cipher) {
+    if (state.cipher != cipher.cipher || state.mode != cipher.mode || state.blockSize != cipher.blockSize) {
+        std::cerr << "Error: The interrupted job on " << file << " used "
+                  << containerCipherName(static_cast<ContainerCipher>(state.cipher)) << " in "
+                  << cipherModeName(static_cast<CipherMode>(state.mode))
+                  << " mode; resume or roll it back with the same algorithm and mode." << std::endl;
+        return false;
+    }
+    if (state.keyCheck != cipher.keyCheck) {
+        std::cerr << "Error: The interrupted job on " << file << " used another key." << std::endl;
+        return false;
+    }
+    bool rollingBack = (state.flags & FLAG_ROLLBACK) != 0;
+    if (operation != InPlaceOperation::Rollback &&
+        (rollingBack || state.encrypt != (operation == InPlaceOperation::Encrypt))) {
+        std::cerr << "Error: " << file << " has an interrupted in-place " << operationName(state)
+                  << "; repeat that command to resume it" << (rollingBack ? "." : ", or add --rollback to undo it.")
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool processFileInPlace(const std::string& file, InPlaceOperation operation, const InPlaceCipher& cipher) {
+    FileDescriptor data;
+    data.fd = open(file.c_str(), O_RDWR);
+    struct stat info;
+    if (data.fd < 0 || fstat(data.fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        std::cerr << "Error: Could not open " << file << " for writing in place (it must be a writable regular file)."
+                  << std::endl;
+        return false;
+    }
+
+    std::string journalPath = inPlaceJournalPath(file);
+    PooledBuffer buffer = BufferPool::acquire(SLOT_SIZE);
+    JournalState state;
+    FileDescriptor journal;
+    journal.fd = open(journalPath.c_str(), O_RDWR);
+    if (journal.fd < 0 && errno != ENOENT) {
+        std::cerr << "Error: Could not open the journal " << journalPath << std::endl;
+        return false;
+    }
+    if (journal.fd >= 0 && !loadJournal(journal.fd, state, buffer.data())) {
+        if (journalStarted(journal.fd)) {
+            std::cerr << "Error: The journal " << journalPath << " is damaged; " << file
+                      << " cannot be recovered automatically." << std::endl;
+            return false;
+        }
+        close(journal.fd);
+        journal.fd = -1;
+        unlink(journalPath.c_str());
+    }
+
+    if (journal.fd >= 0) {
+        if (!checkJournal(file, state, operation, cipher)) {
+            return false;
+        }
+        // The newest step may not have reached the file; writing it again is harmless
+        if (!applyPending(data.fd, state, buffer.data())) {
+            return false;
+        }
+        if (operation == InPlaceOperation::Rollback && !(state.flags & FLAG_ROLLBACK)) {
+            std::cout << "Rolling back the interrupted in-place " << operationName(state) << " of " << file << " ("
+                      << state.done << " of " << state.inputLength << " bytes done)." << std::endl;
+            state = rollbackJob(state);
+            if (!commitStep(data.fd, journal.fd, state, buffer.data())) {
+                return false;
+            }
+        } else {
+            std::cout << "Resuming the interrupted in-place " << operationName(state) << " of " << file << " at byte "
+                      << state.done << " of " << state.inputLength << "." << std::endl;
+        }
+    } else if (operation == InPlaceOperation::Rollback) {
+        std::cerr << "Error: " << file << " has no interrupted in-place job to roll back (no " << journalPath << ")."
+                  << std::endl;
+        return false;
+    } else {
+        if (!startJob(data.fd, static_cast<uint64_t>(info.st_size), operation, cipher, state)) {
+            return false;
+        }
+        journal.fd = open(journalPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (journal.fd < 0) {
+            std::cerr << "Error: Could not create the journal " << journalPath << std::endl;
+            return false;
+        }
+        syncDirectory(journalPath);
+        if (!commitStep(data.fd, journal.fd, state, buffer.data())) {
+            return false;
+        }
+    }
+
+    std::memcpy(cipher.iv, state.iv, state.headerSize);
+    while (!(state.flags & FLAG_COMPLETE)) {
+        if (!runStep(data.fd, journal.fd, state, cipher, buffer.data())) {
+            std::cerr << "The job on " << file << " stopped; the journal " << journalPath
+                      << " was kept so it can be resumed or undone with --rollback." << std::endl;
+            return false;
+        }
+    }
+
+    uint64_t size = state.truncateTo == UINT64_MAX ? state.outputEnd : state.truncateTo;
+    if (ftruncate(data.fd, static_cast<off_t>(size)) != 0 || !syncFile(data.fd)) {
+        std::cerr << "Error: Could not resize " << file << std::endl;
+        return false;
+    }
+    unlink(journalPath.c_str());
+    syncDirectory(journalPath);
+    return true;
+}
+
+#else
+
+bool processFileInPlace(const std::string& file, InPlaceOperation, const InPlaceCipher&) {
+    std::cerr << "Error: --in-place is not supported on this platform (" << file << " was not changed)." << std::endl;
+    return false;
+}
+
+#endif
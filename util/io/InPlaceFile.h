@@ -0,0 +1,71 @@
+#ifndef IN_PLACE_FILE_H
+#define IN_PLACE_FILE_H
+
+/**
+ * @file InPlaceFile.h
+ * @brief Encrypting and decrypting a file in place (--in-place), with a journal.
+ *
+ * The file is rewritten chunk by chunk with pread/pwrite on the same descriptor, so no
+ * second copy of the data is ever stored and memory stays at one chunk. The result is
+ * byte for byte what a normal file job writes. When an IV header is written, every
+ * ciphertext chunk lands one block after its plaintext and overwrites the first block
+ * of the next chunk. That block (the "carry") is kept in memory and in the journal.
+ * Decryption moves the data one block towards the start, which never overwrites
+ * unread input. The padding at the tail is added (or stripped and truncated) on the
+ * last chunk.
+ *
+ * The journal, "<file>.journal", makes an interrupted run safe to resume or undo. It
+ * has two slots, written alternately. Before a chunk is written to the file, the
+ * chunk's output and the state after it (progress, carry, CBC chain) are written to
+ * the older slot with a CRC-32C and a sequence number, and synced. On restart the
+ * newest intact record is replayed, which rewrites the same bytes at the same place,
+ * and the job continues from there. Each chunk is therefore written twice, and both
+ * files are synced once per chunk. That is the cost of a run that can be interrupted
+ * at any point.
+ *
+ * Rolling back runs the inverse job over the part already done, under the same IV. A
+ * half-encrypted file is decrypted up to where encryption stopped and the carry is put
+ * back, so the original bytes come back exactly. The rollback has its own journal
+ * records and can itself be interrupted and resumed.
+ */
+
+#include "BlockStream.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Bytes of input per journaled step. Memory is about two of these: the chunk and the
+// slot it is journaled in are the same buffer.
+constexpr size_t IN_PLACE_CHUNK_SIZE = 4 << 20;
+
+enum class InPlaceOperation {
+    Encrypt,
+    Decrypt,
+    Rollback  // Undo the interrupted job recorded in the journal
+};
+
+// What the in-place job needs to know about the cipher. The transforms work in place.
+// For both of them `previous` is the last ciphertext block before the chunk (nullptr
+// at offset 0), which is what CBC chains to in either direction.
+struct InPlaceCipher {
+    uint8_t cipher = 0;       // ContainerCipher value, recorded in the journal
+    uint8_t mode = 0;         // CipherMode value
+    size_t blockSize = 0;
+    bool hasIV = false;       // Ciphertext starts with an IV of one block
+    bool padded = true;       // PKCS#5/7 padding on the last block
+    uint32_t keyCheck = 0;    // Fingerprint of the key, so a resume under another key is refused
+    uint8_t* iv = nullptr;    // A fresh random IV for a new encryption; set to the job's IV before the first chunk
+    ChunkTransform encrypt;
+    ChunkTransform decrypt;
+};
+
+// Journal that goes with `file`
+std::string inPlaceJournalPath(const std::string& file);
+
+// Encrypt or decrypt `file` in place, or roll back its interrupted job. An existing
+// journal for the same operation is resumed instead of starting over; one for the
+// other operation is reported. Returns false (after printing the error) on failure;
+// the journal is then left behind so the job can be resumed or rolled back.
+bool processFileInPlace(const std::string& file, InPlaceOperation operation, const InPlaceCipher& cipher);
+
+#endif // IN_PLACE_FILE_H
@@ -0,0 +1,245 @@
+/**
+ * @file MappedFile.cpp
+ * @brief Memory-mapped file backend for the encryption and decryption jobs.
+ *
+ * The input is mapped read-only and the output is sized up front with ftruncate and
+ * mapped writable, so the cipher kernels read plaintext from and write ciphertext to
+ * the page cache directly. Compared with the streaming path this saves the copy into
+ * the chunk buffer on read(), the copy out of it on write() and the iostream layer.
+ *
+ * Both mappings are advised MADV_SEQUENTIAL (aggressive read-ahead, early reclaim) and,
+ * where the kernel offers it, MADV_HUGEPAGE; the hints are best effort and their
+ * results are ignored.
+ */
+
+#include "MappedFile.h"
+#include "ParallelFile.h"
+#include "../stats/Stats.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_IO 1
+#include "FileDescriptor.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef MAPPED_FILE_IO
+
+// Unmaps the region when the job is done, whichever way it ends
+struct Mapping {
+    uint8_t* data = nullptr;
+    size_t length = 0;
+
+    Mapping() = default;
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    ~Mapping() {
+        unmap();
+    }
+
+    bool map(int fd, uint64_t size, bool writable) {
+        void* address = mmap(nullptr, static_cast<size_t>(size), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                             MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<uint8_t*>(address);
+        length = static_cast<size_t>(size);
+        madvise(address, length, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+        madvise(address, length, MADV_HUGEPAGE);
+#endif
+        return true;
+    }
+
+    void unmap() {
+        if (data) {
+            munmap(data, length);
+            data = nullptr;
+        }
+    }
+};
+
+// Open the input; false if it cannot be opened or is not a regular file worth mapping
+bool openMappableInput(const std::string& inputFile, uint64_t minimumSize, FileDescriptor& input,
+                       uint64_t& inputSize) {
+    input.fd = open(inputFile.c_str(), O_RDONLY);
+    struct stat info;
+    if (input.fd < 0 || fstat(input.fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+    inputSize = static_cast<uint64_t>(info.st_size);
+    return inputSize >= std::max<uint64_t>(minimumSize, 1);
+}
+
+bool openOutput(const std::string& inputFile, const std::string& outputFile, FileDescriptor& output) {
+    // The input is mapped only after this, so truncating it would leave nothing to read
+    if (!checkDistinctFiles(inputFile, outputFile)) {
+        return false;
+    }
+    // Writable mappings need the descriptor open for reading as well
+    output.fd = open(outputFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (output.fd < 0) {
+        std::cerr << "Error: Could not open output file " << outputFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool resizeOutput(int fd, uint64_t size, const std::string& outputFile) {
+    bool ok = ftruncate(fd, static_cast<off_t>(size)) == 0;
+#ifdef __linux__
+    // Reserve the blocks now: running out of disk space while writing through the
+    // mapping would raise SIGBUS instead of returning an error. Plain fallocate rather
+    // than posix_fallocate, which writes zeros where the file system cannot reserve.
+    // An empty file has nothing to reserve, and fallocate rejects a zero length.
+    if (ok && size > 0 && fallocate(fd, 0, 0, static_cast<off_t>(size)) != 0) {
+        ok = errno == EOPNOTSUPP || errno == ENOSYS;
+    }
+#endif
+    if (!ok) {
+        std::cerr << "Error: Could not allocate space for output file " << outputFile << std::endl;
+    }
+    return ok;
+}
+
+// Transform `bodyLength` bytes from `input` into `output` in PARALLEL_CHUNK_SIZE pieces,
+// on the pool if there is one and in order otherwise
+void processBody(const uint8_t* input, uint8_t* output, uint64_t bodyLength, size_t blockSize, ThreadPool* pool,
+                 const ChunkTransform& transform) {
+    size_t chunkCount = static_cast<size_t>((bodyLength + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE);
+    auto processChunk = [&](size_t index) {
+        uint64_t offset = static_cast<uint64_t>(index) * PARALLEL_CHUNK_SIZE;
+        size_t length = static_cast<size_t>(std::min<uint64_t>(PARALLEL_CHUNK_SIZE, bodyLength - offset));
+        transform(FileChunk{output + offset, input + offset, length, offset,
+                            offset > 0 ? input + offset - blockSize : nullptr});
+    };
+
+    if (pool) {
+        pool->parallelFor(chunkCount, processChunk);
+    } else {
+        for (size_t index = 0; index < chunkCount; ++index) {
+            processChunk(index);
+        }
+    }
+}
+
+#endif
+
+} // namespace
+
+MappedIO encryptFileMapped(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           ThreadPool* pool, const ChunkTransform& transform,
+                           const std::vector<uint8_t>& header, bool padded, uint64_t minimumSize) {
+#ifdef MAPPED_FILE_IO
+    FileDescriptor input, output;
+    uint64_t inputSize = 0;
+    if (!openMappableInput(inputFile, minimumSize, input, inputSize)) {
+        return MappedIO::NotMapped;
+    }
+    if (!openOutput(inputFile, outputFile, output)) {
+        return MappedIO::Failed;
+    }
+
+    uint64_t bodyLength = padded ? inputSize - inputSize % blockSize : inputSize;
+    uint64_t outputSize = header.size() + bodyLength + (padded ? blockSize : 0);
+    StageTimer mapping(Stage::Map, inputSize + outputSize);
+    if (!resizeOutput(output.fd, outputSize, outputFile)) {
+        return MappedIO::Failed;
+    }
+    if (outputSize == 0) {
+        return MappedIO::Done;
+    }
+    Mapping in, out;
+    if (!in.map(input.fd, inputSize, false) || !out.map(output.fd, outputSize, true)) {
+        return MappedIO::NotMapped;
+    }
+    mapping.stop();
+
+    std::memcpy(out.data, header.data(), header.size());
+    uint8_t* body = out.data + header.size();
+    processBody(in.data, body, bodyLength, blockSize, pool, transform);
+    if (padded) {
+        // Final block: the remaining input bytes plus PKCS#5/7 padding
+        std::vector<uint8_t> tail(blockSize);
+        size_t tailLength = static_cast<size_t>(inputSize - bodyLength);
+        std::memcpy(tail.data(), in.data + bodyLength, tailLength);
+        std::memset(tail.data() + tailLength, static_cast<int>(blockSize - tailLength), blockSize - tailLength);
+        transform(FileChunk{body + bodyLength, tail.data(), blockSize, bodyLength,
+                            bodyLength > 0 ? in.data + bodyLength - blockSize : nullptr});
+    }
+    return MappedIO::Done;
+#else
+    (void)inputFile, (void)outputFile, (void)blockSize, (void)pool, (void)transform, (void)header, (void)padded, (void)minimumSize;
+    return MappedIO::NotMapped;
+#endif
+}
+
+MappedIO decryptFileMapped(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           ThreadPool* pool, const ChunkTransform& transform,
+                           size_t headerSize, bool padded, uint64_t minimumSize) {
+#ifdef MAPPED_FILE_IO
+    FileDescriptor input, output;
+    uint64_t inputSize = 0;
+    if (!openMappableInput(inputFile, minimumSize, input, inputSize)) {
+        return MappedIO::NotMapped;
+    }
+    uint64_t dataSize = inputSize >= headerSize ? inputSize - headerSize : 0;
+    if (padded && dataSize == 0) {
+        std::cerr << "Error: Ciphertext is empty." << std::endl;
+        return MappedIO::Failed;
+    }
+    if (padded && dataSize % blockSize != 0) {
+        std::cerr << "Error: Ciphertext length is not a multiple of the block size." << std::endl;
+        return MappedIO::Failed;
+    }
+    StageTimer mapping(Stage::Map, inputSize + dataSize);
+    if (!openOutput(inputFile, outputFile, output) || !resizeOutput(output.fd, dataSize, outputFile)) {
+        return MappedIO::Failed;
+    }
+    if (dataSize == 0) {
+        // Only the header (e.g. a CTR IV): the plaintext is empty, and there is nothing to map
+        return MappedIO::Done;
+    }
+    Mapping in, out;
+    if (!in.map(input.fd, inputSize, false) || !out.map(output.fd, dataSize, true)) {
+        return MappedIO::NotMapped;
+    }
+    mapping.stop();
+
+    const uint8_t* data = in.data + headerSize;
+    uint64_t bodyLength = padded ? dataSize - blockSize : dataSize;
+    processBody(data, out.data, bodyLength, blockSize, pool, transform);
+    if (!padded) {
+        return MappedIO::Done;
+    }
+
+    // Last block: decrypt, then check the padding and cut it off the end of the file
+    uint8_t* last = out.data + bodyLength;
+    transform(FileChunk{last, data + bodyLength, blockSize, bodyLength,
+                        bodyLength > 0 ? data + bodyLength - blockSize : nullptr});
+    size_t padLen = last[blockSize - 1];
+    if (padLen == 0 || padLen > blockSize) {
+        std::cerr << "Error: Invalid padding (wrong key or corrupted data)." << std::endl;
+        return MappedIO::Failed;
+    }
+    out.unmap();
+    if (ftruncate(output.fd, static_cast<off_t>(dataSize - padLen)) != 0) {
+        std::cerr << "Error: Failed to write output data." << std::endl;
+        return MappedIO::Failed;
+    }
+    return MappedIO::Done;
+#else
+    (void)inputFile, (void)outputFile, (void)blockSize, (void)pool, (void)transform, (void)headerSize, (void)padded, (void)minimumSize;
+    return MappedIO::NotMapped;
+#endif
+}
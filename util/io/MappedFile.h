@@ -0,0 +1,39 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "BlockStream.h"
+#include "../thread/ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Inputs smaller than this are not mapped by default: setting up and tearing down two mappings
+// costs more than it saves on a handful of chunks
+constexpr uint64_t MAPPED_IO_MIN_SIZE = 4 << 20;
+
+// Outcome of a memory-mapped job. NotMapped means nothing was done because the input
+// is too small, not a regular file or could not be mapped, and the caller should use
+// the streaming path instead.
+enum class MappedIO {
+    Done,
+    Failed,
+    NotMapped
+};
+
+// Encrypt `inputFile` into `outputFile` through memory mappings of both: the transform
+// reads the input pages and writes the output pages directly, with no read/write copies.
+// Chunks run on `pool` when given, otherwise in order on the calling thread. `header`
+// and `padded` are as for encryptFileParallel. Inputs under `minimumSize` are not mapped.
+MappedIO encryptFileMapped(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           ThreadPool* pool, const ChunkTransform& transform,
+                           const std::vector<uint8_t>& header = {}, bool padded = true,
+                           uint64_t minimumSize = MAPPED_IO_MIN_SIZE);
+
+// Memory-mapped counterpart of decryptFileParallel
+MappedIO decryptFileMapped(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           ThreadPool* pool, const ChunkTransform& transform,
+                           size_t headerSize = 0, bool padded = true,
+                           uint64_t minimumSize = MAPPED_IO_MIN_SIZE);
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,250 @@
+#include "ParallelFile.h"
+#include "BlockStream.h"
+#include "../memory/BufferPool.h"
+#include "../stats/Stats.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PARALLEL_FILE_POSITIONAL_IO 1
+#include "FileDescriptor.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef PARALLEL_FILE_POSITIONAL_IO
+
+bool readAt(int fd, uint8_t* buffer, size_t length, uint64_t offset) {
+    StageTimer timer(Stage::Read, length);
+    while (length > 0) {
+        ssize_t got = pread(fd, buffer, length, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        buffer += got;
+        length -= static_cast<size_t>(got);
+        offset += static_cast<uint64_t>(got);
+    }
+    return true;
+}
+
+bool writeAt(int fd, const uint8_t* buffer, size_t length, uint64_t offset) {
+    StageTimer timer(Stage::Write, length);
+    while (length > 0) {
+        ssize_t written = pwrite(fd, buffer, length, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        buffer += written;
+        length -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+bool openFiles(const std::string& inputFile, const std::string& outputFile, FileDescriptor& input,
+               FileDescriptor& output, uint64_t& inputSize) {
+    input.fd = open(inputFile.c_str(), O_RDONLY);
+    struct stat info;
+    if (input.fd < 0 || fstat(input.fd, &info) != 0) {
+        std::cerr << "Error: Could not open input file " << inputFile << std::endl;
+        return false;
+    }
+    inputSize = static_cast<uint64_t>(info.st_size);
+    if (!checkDistinctFiles(inputFile, outputFile)) {
+        return false;
+    }
+
+    output.fd = open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (output.fd < 0) {
+        std::cerr << "Error: Could not open output file " << outputFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Transform chunk `index` of the body: PARALLEL_CHUNK_SIZE bytes (fewer for the last)
+// that start at `inputBase` + offset in the input and go to `outputBase` + offset
+bool transformChunk(int input, int output, uint64_t bodyLength, uint64_t inputBase, uint64_t outputBase,
+                    size_t blockSize, size_t index, const ChunkTransform& transform) {
+    // Recycled from this thread's previous chunk, or a thread of an earlier job; the
+    // first block holds the input block preceding the chunk
+    PooledBuffer buffer = BufferPool::acquire(blockSize + PARALLEL_CHUNK_SIZE);
+
+    uint64_t offset = static_cast<uint64_t>(index) * PARALLEL_CHUNK_SIZE;
+    size_t length = static_cast<size_t>(std::min<uint64_t>(PARALLEL_CHUNK_SIZE, bodyLength - offset));
+    size_t lookBehind = offset > 0 ? blockSize : 0;
+    uint8_t* data = buffer.data() + blockSize;
+
+    if (!readAt(input, data - lookBehind, length + lookBehind, inputBase + offset - lookBehind)) {
+        return false;
+    }
+    transform(FileChunk{data, data, length, offset, lookBehind ? buffer.data() : nullptr});
+    return writeAt(output, data, length, outputBase + offset);
+}
+
+size_t chunkCountOf(uint64_t bodyLength) {
+    return static_cast<size_t>((bodyLength + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE);
+}
+
+// The body spread over `pool`, one chunk per task in whatever order they finish
+BodyTransform poolBody(ThreadPool& pool, size_t blockSize, const ChunkTransform& transform) {
+    return [&pool, blockSize, &transform](int input, int output, uint64_t bodyLength, uint64_t inputBase,
+                                          uint64_t outputBase) {
+        std::atomic<bool> failed{false};
+        pool.parallelFor(chunkCountOf(bodyLength), [&](size_t index) {
+            if (!failed.load() &&
+                !transformChunk(input, output, bodyLength, inputBase, outputBase, blockSize, index, transform)) {
+                failed = true;
+            }
+        });
+        return !failed.load();
+    };
+}
+
+#endif
+
+} // namespace
+
+#ifdef PARALLEL_FILE_POSITIONAL_IO
+
+bool encryptFilePositional(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           const BodyTransform& body, const ChunkTransform& transform,
+                           const std::vector<uint8_t>& header, bool padded) {
+    FileDescriptor input, output;
+    uint64_t inputSize = 0;
+    if (!openFiles(inputFile, outputFile, input, output, inputSize)) {
+        return false;
+    }
+
+    uint64_t bodyLength = padded ? inputSize - inputSize % blockSize : inputSize;
+    uint64_t outputSize = header.size() + bodyLength + (padded ? blockSize : 0);
+    if (ftruncate(output.fd, static_cast<off_t>(outputSize)) != 0 ||
+        !writeAt(output.fd, header.data(), header.size(), 0) ||
+        !body(input.fd, output.fd, bodyLength, 0, header.size())) {
+        std::cerr << "Error: Failed to encrypt " << inputFile << " in parallel." << std::endl;
+        return false;
+    }
+    if (!padded) {
+        return true;
+    }
+
+    // Final block: the remaining input bytes plus PKCS#5/7 padding
+    std::vector<uint8_t> tail(2 * blockSize);
+    size_t tailLength = static_cast<size_t>(inputSize - bodyLength);
+    size_t lookBehind = bodyLength > 0 ? blockSize : 0;
+    uint8_t* data = tail.data() + blockSize;
+    if (!readAt(input.fd, data - lookBehind, tailLength + lookBehind, bodyLength - lookBehind)) {
+        std::cerr << "Error: Failed to read input data." << std::endl;
+        return false;
+    }
+    size_t padLen = blockSize - tailLength;
+    std::memset(data + tailLength, static_cast<int>(padLen), padLen);
+    transform(FileChunk{data, data, blockSize, bodyLength, lookBehind ? tail.data() : nullptr});
+    if (!writeAt(output.fd, data, blockSize, header.size() + bodyLength)) {
+        std::cerr << "Error: Failed to write output data." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool decryptFilePositional(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           const BodyTransform& body, const ChunkTransform& transform, size_t headerSize,
+                           bool padded) {
+    FileDescriptor input, output;
+    uint64_t inputSize = 0;
+    if (!openFiles(inputFile, outputFile, input, output, inputSize)) {
+        return false;
+    }
+    uint64_t dataSize = inputSize >= headerSize ? inputSize - headerSize : 0;
+    if (padded && (dataSize == 0 || dataSize % blockSize != 0)) {
+        std::cerr << "Error: Ciphertext length is not a multiple of the block size." << std::endl;
+        return false;
+    }
+
+    // Sized up front like the encrypted output; the padding is cut off at the end
+    uint64_t bodyLength = padded ? dataSize - blockSize : dataSize;
+    if (ftruncate(output.fd, static_cast<off_t>(dataSize)) != 0 ||
+        !body(input.fd, output.fd, bodyLength, headerSize, 0)) {
+        std::cerr << "Error: Failed to decrypt " << inputFile << " in parallel." << std::endl;
+        return false;
+    }
+    if (!padded) {
+        return true;
+    }
+
+    // Last block: decrypt, then check and strip the padding
+    std::vector<uint8_t> tail(2 * blockSize);
+    size_t lookBehind = bodyLength > 0 ? blockSize : 0;
+    uint8_t* data = tail.data() + blockSize;
+    if (!readAt(input.fd, data - lookBehind, blockSize + lookBehind, headerSize + bodyLength - lookBehind)) {
+        std::cerr << "Error: Failed to read input data." << std::endl;
+        return false;
+    }
+    transform(FileChunk{data, data, blockSize, bodyLength, lookBehind ? tail.data() : nullptr});
+
+    size_t padLen = data[blockSize - 1];
+    if (padLen == 0 || padLen > blockSize) {
+        std::cerr << "Error: Invalid padding (wrong key or corrupted data)." << std::endl;
+        return false;
+    }
+    if (!writeAt(output.fd, data, blockSize - padLen, bodyLength) ||
+        ftruncate(output.fd, static_cast<off_t>(bodyLength + blockSize - padLen)) != 0) {
+        std::cerr << "Error: Failed to write output data." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool transformChunks(int input, int output, uint64_t bodyLength, uint64_t inputBase, uint64_t outputBase,
+                     size_t blockSize, size_t firstChunk, size_t lastChunk, const ChunkTransform& transform,
+                     std::atomic<uint64_t>* chunksDone) {
+    for (size_t index = firstChunk; index < std::min(lastChunk, chunkCountOf(bodyLength)); ++index) {
+        if (!transformChunk(input, output, bodyLength, inputBase, outputBase, blockSize, index, transform)) {
+            return false;
+        }
+        if (chunksDone) {
+            chunksDone->fetch_add(1);
+        }
+    }
+    return true;
+}
+
+#endif
+
+bool encryptFileParallel(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                         ThreadPool& pool, const ChunkTransform& transform,
+                         const std::vector<uint8_t>& header, bool padded) {
+#ifdef PARALLEL_FILE_POSITIONAL_IO
+    return encryptFilePositional(inputFile, outputFile, blockSize, poolBody(pool, blockSize, transform), transform,
+                                 header, padded);
+#else
+    (void)pool;
+    return encryptFileStream(inputFile, outputFile, blockSize, transform, header, padded);
+#endif
+}
+
+bool decryptFileParallel(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                         ThreadPool& pool, const ChunkTransform& transform,
+                         size_t headerSize, bool padded) {
+#ifdef PARALLEL_FILE_POSITIONAL_IO
+    return decryptFilePositional(inputFile, outputFile, blockSize, poolBody(pool, blockSize, transform), transform,
+                                 headerSize, padded);
+#else
+    (void)pool;
+    return decryptFileStream(inputFile, outputFile, blockSize, transform, headerSize, padded);
+#endif
+}
@@ -0,0 +1,58 @@
+#ifndef PARALLEL_FILE_H
+#define PARALLEL_FILE_H
+
+#include "BlockStream.h"
+#include "../thread/ThreadPool.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Bytes per task handed to the thread pool; a multiple of STREAM_CHUNK_SIZE
+constexpr size_t PARALLEL_CHUNK_SIZE = 4 << 20;
+
+// Split the input into PARALLEL_CHUNK_SIZE chunks, transform them on `pool` and write
+// each result at its own position in the output with pwrite, so completion order does
+// not matter. `header` (e.g. an IV) is written in front of the ciphertext. When
+// `padded`, the final partial block is padded (PKCS#5/7) and transformed last.
+// Only modes without a chain from one block to the next may use this.
+// Falls back to the sequential streaming path where positional I/O is unavailable.
+bool encryptFileParallel(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                         ThreadPool& pool, const ChunkTransform& transform,
+                         const std::vector<uint8_t>& header = {}, bool padded = true);
+
+// Parallel counterpart of decryptStream for input that starts with a `headerSize`-byte
+// header (read by the caller). When `padded`, everything but the last block is
+// decrypted on the pool, then the last block is decrypted and its padding stripped.
+bool decryptFileParallel(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                         ThreadPool& pool, const ChunkTransform& transform,
+                         size_t headerSize = 0, bool padded = true);
+
+#if defined(__unix__) || defined(__APPLE__)
+
+// Transforms the `bodyLength` bytes of whole blocks starting at `inputBase` in the input
+// into place at `outputBase` in the output; false if a read or write failed
+using BodyTransform = std::function<bool(int input, int output, uint64_t bodyLength, uint64_t inputBase,
+                                         uint64_t outputBase)>;
+
+// encryptFileParallel and decryptFileParallel with the body handed to `body` instead of a
+// thread pool, for other ways of spreading its chunks (see ShardedFile.h). The output is
+// sized before `body` runs, so every chunk can be written at its place independently.
+bool encryptFilePositional(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           const BodyTransform& body, const ChunkTransform& transform,
+                           const std::vector<uint8_t>& header, bool padded);
+bool decryptFilePositional(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           const BodyTransform& body, const ChunkTransform& transform, size_t headerSize,
+                           bool padded);
+
+// Transform chunks [firstChunk, lastChunk) of such a body, in order, on the calling
+// thread. `chunksDone`, if given, is incremented once each chunk has been written.
+bool transformChunks(int input, int output, uint64_t bodyLength, uint64_t inputBase, uint64_t outputBase,
+                     size_t blockSize, size_t firstChunk, size_t lastChunk, const ChunkTransform& transform,
+                     std::atomic<uint64_t>* chunksDone = nullptr);
+
+#endif
+
+#endif // PARALLEL_FILE_H
@@ -0,0 +1,364 @@
+/**
+ * @file PipelinedFile.cpp
+ * @brief Read / transform / write pipeline over a ring of chunk buffers.
+ *
+ * Chunk i always lives in buffer i % PIPELINE_BUFFERS. The read of chunk i is issued
+ * as soon as the write of chunk i - PIPELINE_BUFFERS has released the buffer, so while
+ * the calling thread transforms chunk N the kernel (or the I/O threads) are filling
+ * the buffers of N + 1, N + 2, ... and draining those of N - 1, N - 2, ...
+ *
+ * Completions are reaped whenever the transform stage waits for a read and, without
+ * blocking, after every chunk; the in-flight time in PipelineStats runs from the first
+ * submission to the reaping of the last request outstanding, so it may include a little
+ * time a finished request spent waiting to be reaped.
+ */
+
+#include "PipelinedFile.h"
+#include "AsyncFileIO.h"
+#include "../memory/BufferPool.h"
+#include "../stats/Stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PIPELINED_FILE_IO 1
+#include "FileDescriptor.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef PIPELINED_FILE_IO
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Transforms chunk `index` in place; `length` comes in as the bytes read and goes out
+// as the bytes to write. False (after printing the error) stops the job.
+using ChunkStage = std::function<bool(size_t index, uint8_t* data, size_t& length)>;
+
+struct PipelineJob {
+    int input;
+    int output;
+    uint64_t inputBase;    // first body byte in the input
+    uint64_t inputLength;  // body bytes to read
+    uint64_t outputBase;   // where the transformed body starts in the output
+    size_t chunkCount;     // may exceed the chunks of input, e.g. a padding-only last chunk
+    size_t bufferSize;     // STREAM_CHUNK_SIZE (or the whole input, if shorter) plus room for padding
+};
+
+class Pipeline {
+public:
+    Pipeline(const PipelineJob& job, PipelineStats& stats)
+        : job(job), stats(stats), memory(BufferPool::acquire(std::min(PIPELINE_BUFFERS, job.chunkCount) * slotStride())),
+          slots(PIPELINE_BUFFERS), ioPointer(createAsyncFileIO(2 * PIPELINE_BUFFERS)), io(*ioPointer) {
+        stats.backend = io.name();
+    }
+
+    bool run(const ChunkStage& stage) {
+        Clock::time_point start = Clock::now();
+        for (size_t index = 0; index < std::min(PIPELINE_BUFFERS, job.chunkCount); ++index) {
+            startRead(index);
+        }
+
+        for (size_t index = 0; index < job.chunkCount && !failed; ++index) {
+            Slot& slot = slots[index % PIPELINE_BUFFERS];
+            if (!slot.ready) {
+                StageTimer waiting(Stage::IOWait);
+                Clock::time_point stalled = Clock::now();
+                while (!slot.ready && !failed) {
+                    reapBlocking();
+                }
+                stats.stallSeconds += secondsSince(stalled);
+                if (failed) {
+                    break;
+                }
+            }
+
+            Clock::time_point busy = Clock::now();
+            size_t length = slot.length;
+            bool ok = stage(index, buffer(index), length);
+            stats.transformSeconds += secondsSince(busy);
+            if (!ok) {
+                failed = true;
+                break;
+            }
+
+            slot.length = length;
+            slot.done = 0;
+            slot.writing = true;
+            slot.ready = false;
+            if (length == 0) {
+                finishWrite(index);
+            } else {
+                submit(slot, index);
+            }
+
+            AsyncCompletion completion;
+            while (io.poll(completion)) {
+                complete(completion);
+            }
+        }
+
+        // Let the remaining writes (or, after an error, everything in flight) land
+        StageTimer waiting(Stage::IOWait);
+        while (inFlight > 0) {
+            reapBlocking();
+        }
+        waiting.stop();
+        stats.chunks = job.chunkCount;
+        stats.wallSeconds = secondsSince(start);
+        return !failed;
+    }
+
+private:
+    struct Slot {
+        size_t length = 0;  // bytes to read, then bytes to write
+        size_t done = 0;    // bytes of the current request transferred so far
+        bool writing = false;
+        bool ready = false;  // read complete, chunk waiting for the transform
+    };
+
+    size_t slotStride() const {
+        return alignedBufferSize(job.bufferSize);
+    }
+
+    uint8_t* buffer(size_t index) {
+        return memory.data() + (index % PIPELINE_BUFFERS) * slotStride();
+    }
+
+    void fail(bool writing) {
+        if (!failed) {
+            std::cerr << (writing ? "Error: Failed to write output data." : "Error: Failed to read input data.")
+                      << std::endl;
+        }
+        failed = true;
+    }
+
+    void startRead(size_t index) {
+        uint64_t offset = static_cast<uint64_t>(index) * STREAM_CHUNK_SIZE;
+        Slot& slot = slots[index % PIPELINE_BUFFERS];
+        slot.length = offset < job.inputLength
+                          ? static_cast<size_t>(std::min<uint64_t>(STREAM_CHUNK_SIZE, job.inputLength - offset))
+                          : 0;
+        slot.done = 0;
+        slot.writing = false;
+        slot.ready = slot.length == 0;
+        if (!slot.ready) {
+            submit(slot, index);
+        }
+    }
+
+    void finishWrite(size_t index) {
+        if (!failed && index + PIPELINE_BUFFERS < job.chunkCount) {
+            startRead(index + PIPELINE_BUFFERS);
+        }
+    }
+
+    // Issue the rest of the slot's current request
+    void submit(Slot& slot, size_t index) {
+        uint64_t offset = static_cast<uint64_t>(index) * STREAM_CHUNK_SIZE + slot.done;
+        uint8_t* data = buffer(index) + slot.done;
+        size_t remaining = slot.length - slot.done;
+        uint64_t tag = index * 2 + (slot.writing ? 1 : 0);
+
+        bool ok = slot.writing ? io.submitWrite(job.output, data, remaining, job.outputBase + offset, tag)
+                               : io.submitRead(job.input, data, remaining, job.inputBase + offset, tag);
+        if (!ok) {
+            fail(slot.writing);
+            return;
+        }
+        if (inFlight++ == 0) {
+            ioStart = Clock::now();
+        }
+    }
+
+    void reapBlocking() {
+        AsyncCompletion completion;
+        if (!io.wait(completion)) {
+            // Nothing more will be reaped; the requests in flight finish when `io` goes
+            fail(false);
+            inFlight = 0;
+            return;
+        }
+        complete(completion);
+    }
+
+    void complete(const AsyncCompletion& completion) {
+        if (--inFlight == 0) {
+            stats.ioSeconds += secondsSince(ioStart);
+        }
+        size_t index = static_cast<size_t>(completion.tag / 2);
+        Slot& slot = slots[index % PIPELINE_BUFFERS];
+
+        // A read returning 0 bytes means the input shrank while we were reading it
+        if (completion.result <= 0) {
+            fail(slot.writing);
+            return;
+        }
+        slot.done += static_cast<size_t>(completion.result);
+        if (slot.done < slot.length) {
+            if (!failed) {
+                submit(slot, index);
+            }
+        } else if (slot.writing) {
+            finishWrite(index);
+        } else {
+            slot.ready = true;
+        }
+    }
+
+    const PipelineJob& job;
+    PipelineStats& stats;
+    PooledBuffer memory;
+    std::vector<Slot> slots;
+    // Declared after the buffers so it is destroyed, finishing any request still in
+    // flight, before they are freed
+    std::unique_ptr<AsyncFileIO> ioPointer;
+    AsyncFileIO& io;
+    size_t inFlight = 0;
+    Clock::time_point ioStart;
+    bool failed = false;
+};
+
+// Open both files for positional I/O; false if either is not a regular file, in which
+// case the job is streamed instead
+bool openRegularFiles(const std::string& inputFile, const std::string& outputFile, FileDescriptor& input,
+                      FileDescriptor& output, uint64_t& inputSize) {
+    struct stat info;
+    input.fd = open(inputFile.c_str(), O_RDONLY);
+    if (input.fd < 0 || fstat(input.fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+    inputSize = static_cast<uint64_t>(info.st_size);
+
+    // Check before opening: opening a FIFO for writing would block until a reader comes
+    if (stat(outputFile.c_str(), &info) == 0 && !S_ISREG(info.st_mode)) {
+        return false;
+    }
+    output.fd = open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (output.fd < 0) {
+        return false;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(input.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+bool runPipeline(const PipelineJob& job, const ChunkStage& stage, PipelineStats* stats) {
+    PipelineStats local;
+    Pipeline pipeline(job, stats ? *stats : local);
+    return pipeline.run(stage);
+}
+
+#endif
+
+} // namespace
+
+bool encryptFilePipelined(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                          const ChunkTransform& transform, const std::vector<uint8_t>& header, bool padded,
+                          PipelineStats* stats) {
+#ifdef PIPELINED_FILE_IO
+    FileDescriptor input, output;
+    uint64_t inputSize = 0;
+    if (!checkDistinctFiles(inputFile, outputFile)) {
+        return false;
+    }
+    if (!openRegularFiles(inputFile, outputFile, input, output, inputSize)) {
+        return encryptFileStream(inputFile, outputFile, blockSize, transform, header, padded);
+    }
+    if (!header.empty() && pwrite(output.fd, header.data(), header.size(), 0) != static_cast<ssize_t>(header.size())) {
+        std::cerr << "Error: Failed to write output data." << std::endl;
+        return false;
+    }
+
+    // Padded, the chunk holding the end of the input gets the padding; when the input
+    // ends on a chunk boundary that is an extra chunk of padding alone
+    size_t chunkCount = static_cast<size_t>(padded ? inputSize / STREAM_CHUNK_SIZE + 1
+                                                   : (inputSize + STREAM_CHUNK_SIZE - 1) / STREAM_CHUNK_SIZE);
+    // A small file gets buffers of its own size rather than four zeroed chunks
+    size_t bufferSize = static_cast<size_t>(std::min<uint64_t>(STREAM_CHUNK_SIZE, inputSize)) + blockSize;
+    PipelineJob job{input.fd, output.fd, 0, inputSize, header.size(), chunkCount, bufferSize};
+
+    ChunkChain chain(transform, blockSize);
+    return runPipeline(job, [&](size_t index, uint8_t* data, size_t& length) {
+        if (padded && index == chunkCount - 1) {
+            size_t padLen = blockSize - (length % blockSize);
+            std::memset(data + length, static_cast<int>(padLen), padLen);
+            length += padLen;
+        }
+        chain.run(data, length);
+        return true;
+    }, stats);
+#else
+    (void)stats;
+    return encryptFileStream(inputFile, outputFile, blockSize, transform, header, padded);
+#endif
+}
+
+bool decryptFilePipelined(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                          const ChunkTransform& transform, size_t headerSize, bool padded, PipelineStats* stats) {
+#ifdef PIPELINED_FILE_IO
+    FileDescriptor input, output;
+    uint64_t inputSize = 0;
+    if (!checkDistinctFiles(inputFile, outputFile)) {
+        return false;
+    }
+    if (!openRegularFiles(inputFile, outputFile, input, output, inputSize)) {
+        return decryptFileStream(inputFile, outputFile, blockSize, transform, headerSize, padded);
+    }
+    uint64_t dataSize = inputSize >= headerSize ? inputSize - headerSize : 0;
+    if (padded && dataSize == 0) {
+        std::cerr << "Error: Ciphertext is empty." << std::endl;
+        return false;
+    }
+    if (padded && dataSize % blockSize != 0) {
+        std::cerr << "Error: Ciphertext length is not a multiple of the block size." << std::endl;
+        return false;
+    }
+
+    size_t chunkCount = static_cast<size_t>((dataSize + STREAM_CHUNK_SIZE - 1) / STREAM_CHUNK_SIZE);
+    size_t bufferSize = static_cast<size_t>(std::min<uint64_t>(STREAM_CHUNK_SIZE, dataSize));
+    PipelineJob job{input.fd, output.fd, headerSize, dataSize, 0, chunkCount, bufferSize};
+
+    ChunkChain chain(transform, blockSize);
+    return runPipeline(job, [&](size_t index, uint8_t* data, size_t& length) {
+        chain.run(data, length);
+        if (padded && index == chunkCount - 1) {
+            size_t padLen = data[length - 1];
+            if (padLen == 0 || padLen > blockSize) {
+                std::cerr << "Error: Invalid padding (wrong key or corrupted data)." << std::endl;
+                return false;
+            }
+            length -= padLen;
+        }
+        return true;
+    }, stats);
+#else
+    (void)stats;
+    return decryptFileStream(inputFile, outputFile, blockSize, transform, headerSize, padded);
+#endif
+}
+
+// Through std::cout like the job's other messages, so whoever redirects those (e.g. the
+// --serve daemon) gets this line too
+void printPipelineStats(const PipelineStats& stats) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "Pipeline (%s, %zu buffers): %zu chunks in %.3f s; transform %.3f s, I/O in flight %.3f s, "
+                  "overlapped %.3f s, waiting for buffers %.3f s",
+                  stats.backend, PIPELINE_BUFFERS, stats.chunks, stats.wallSeconds, stats.transformSeconds,
+                  stats.ioSeconds, stats.overlapSeconds(), stats.stallSeconds);
+    std::cout << line << std::endl;
+}
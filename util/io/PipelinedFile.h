@@ -0,0 +1,48 @@
+#ifndef PIPELINED_FILE_H
+#define PIPELINED_FILE_H
+
+#include "BlockStream.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Chunk buffers in the ring: while chunk N is transformed, the reads of the chunks after
+// it and the writes of the chunks before it are in flight
+constexpr size_t PIPELINE_BUFFERS = 4;
+
+// How much the read, transform and write stages of a pipelined job overlapped
+struct PipelineStats {
+    const char* backend = nullptr;  // "io_uring" or "threads"; nullptr if the job was streamed
+    size_t chunks = 0;
+    double wallSeconds = 0;       // whole job
+    double transformSeconds = 0;  // transform stage busy
+    double ioSeconds = 0;         // at least one read or write in flight
+    double stallSeconds = 0;      // transform stage waiting for its next buffer to fill
+
+    // Time the transform and the I/O ran at the same time
+    double overlapSeconds() const {
+        double overlap = transformSeconds + ioSeconds - wallSeconds;
+        return overlap > 0 ? overlap : 0;
+    }
+};
+
+// Encrypt `inputFile` into `outputFile` one STREAM_CHUNK_SIZE chunk at a time like
+// encryptStream, but with the reads and writes issued asynchronously (io_uring, or I/O
+// threads where it is unavailable) into a ring of PIPELINE_BUFFERS buffers, so reading,
+// transforming and writing overlap. Chunks are transformed in order on the calling
+// thread, so chained modes (CBC encryption) work. `header` and `padded` are as for
+// encryptFileParallel. Streams instead when either file is not a regular file.
+bool encryptFilePipelined(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                          const ChunkTransform& transform, const std::vector<uint8_t>& header = {},
+                          bool padded = true, PipelineStats* stats = nullptr);
+
+// Pipelined counterpart of decryptFileParallel
+bool decryptFilePipelined(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                          const ChunkTransform& transform, size_t headerSize = 0, bool padded = true,
+                          PipelineStats* stats = nullptr);
+
+// One-line summary of how the stages overlapped, printed for --stats
+void printPipelineStats(const PipelineStats& stats);
+
+#endif // PIPELINED_FILE_H
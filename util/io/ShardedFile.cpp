@@ -0,0 +1,300 @@
+/**
+ * @file ShardedFile.cpp
+ * @brief Forked workers over byte ranges of one file, with a shared progress table.
+ */
+
+#include "ShardedFile.h"
+#include "ParallelFile.h"
+#include "../stats/Stats.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SHARDED_FILE_PROCESSES 1
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <fstream>
+#include <sched.h>
+#endif
+
+namespace {
+
+#ifdef SHARDED_FILE_PROCESSES
+
+enum ShardStatus : uint32_t {
+    Pending,
+    Done,
+    Failed
+};
+
+// One shard's entry in the table; written by its worker, read by the parent once the
+// worker has exited
+struct ShardSlot {
+    std::atomic<uint64_t> chunksDone{0};  // Chunks from the shard's first, written in order
+    std::atomic<uint32_t> status{Pending};
+    StatsSnapshot stats;  // The worker's --stats totals, filled in as it exits
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shard progress is shared between processes");
+
+// Shared anonymous mapping, so forked workers write into the parent's copy
+class ShardTable {
+public:
+    explicit ShardTable(size_t count) : count(count), bytes(count * sizeof(ShardSlot)) {
+        void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED) {
+            slots = static_cast<ShardSlot*>(memory);
+            for (size_t i = 0; i < count; ++i) {
+                new (slots + i) ShardSlot();
+            }
+        }
+    }
+
+    ~ShardTable() {
+        if (slots) {
+            munmap(slots, bytes);
+        }
+    }
+
+    ShardTable(const ShardTable&) = delete;
+    ShardTable& operator=(const ShardTable&) = delete;
+
+    bool valid() const {
+        return slots != nullptr;
+    }
+
+    ShardSlot& operator[](size_t index) {
+        return slots[index];
+    }
+
+private:
+    ShardSlot* slots = nullptr;
+    size_t count;
+    size_t bytes;
+};
+
+// The CPUs of each NUMA node this process may run on; empty on single-node machines
+std::vector<std::vector<int>> numaNodeCpus() {
+    std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return nodes;
+    }
+    for (int node = 0;; ++node) {
+        std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!list) {
+            break;
+        }
+        // Ranges such as "0-15,32-47"
+        std::vector<int> cpus;
+        std::string range;
+        while (std::getline(list, range, ',')) {
+            int first = 0, last = 0;
+            int fields = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+            if (fields < 1) {
+                continue;
+            }
+            for (int cpu = first; cpu <= (fields == 2 ? last : first) && cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &allowed)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        if (!cpus.empty()) {
+            nodes.push_back(std::move(cpus));
+        }
+    }
+    if (nodes.size() < 2) {
+        nodes.clear();
+    }
+#endif
+    return nodes;
+}
+
+void pinToCpus(const std::vector<int>& cpus) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpus;
+#endif
+}
+
+struct ShardJob {
+    int input;
+    int output;
+    uint64_t bodyLength;
+    uint64_t inputBase;
+    uint64_t outputBase;
+    size_t blockSize;
+    const ChunkTransform& transform;
+    std::vector<std::vector<int>> nodes;
+};
+
+// Fork a worker for chunks [first, last) of the body, resuming after the chunks its
+// slot says are written already. Returns its pid, or -1.
+pid_t startWorker(const ShardJob& job, size_t shard, size_t first, size_t last, ShardSlot& slot) {
+    // Anything still buffered would be written by the worker as well
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    // The worker: its totals start from zero so the parent can add them as they are.
+    // It leaves with _exit, running none of the parent's exit-time cleanup.
+    Stats::reset();
+    if (!job.nodes.empty()) {
+        pinToCpus(job.nodes[shard % job.nodes.size()]);
+    }
+    size_t resume = first + static_cast<size_t>(slot.chunksDone.load());
+    bool ok = transformChunks(job.input, job.output, job.bodyLength, job.inputBase, job.outputBase, job.blockSize,
+                              resume, last, job.transform, &slot.chunksDone);
+    slot.stats = Stats::snapshot();
+    slot.status.store(ok ? Done : Failed);
+    _exit(ok ? 0 : 1);
+}
+
+std::string describeExit(int status) {
+    if (WIFSIGNALED(status)) {
+        return std::string("was killed by signal ") + std::to_string(WTERMSIG(status));
+    }
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+// Run the body on forked workers, one shard each, and wait for all of them
+bool runShards(size_t processes, const ShardJob& job) {
+    size_t chunkCount = static_cast<size_t>((job.bodyLength + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE);
+    size_t shards = std::min(processes, chunkCount);
+    if (shards <= 1) {
+        return transformChunks(job.input, job.output, job.bodyLength, job.inputBase, job.outputBase, job.blockSize,
+                               0, chunkCount, job.transform);
+    }
+    ShardTable table(shards);
+    if (!table.valid()) {
+        std::cerr << "Error: Could not create the shared progress table: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    auto firstChunk = [&](size_t shard) { return shard * chunkCount / shards; };
+
+    std::cout << "Processing " << chunkCount << " chunks in " << shards << " worker processes";
+    if (!job.nodes.empty()) {
+        std::cout << " across " << job.nodes.size() << " NUMA nodes";
+    }
+    std::cout << std::endl;
+
+    std::map<pid_t, size_t> running;  // Worker pid -> its shard
+    std::vector<size_t> attempts(shards, 0);
+    bool ok = true;
+    for (size_t shard = 0; shard < shards; ++shard) {
+        pid_t pid = startWorker(job, shard, firstChunk(shard), firstChunk(shard + 1), table[shard]);
+        if (pid < 0) {
+            std::cerr << "Error: Could not start a worker process: " << std::strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+        running[pid] = shard;
+        attempts[shard] = 1;
+    }
+
+    while (!running.empty()) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: Lost track of the worker processes: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        auto worker = running.find(pid);
+        if (worker == running.end()) {
+            continue;
+        }
+        size_t shard = worker->second;
+        running.erase(worker);
+
+        ShardSlot& slot = table[shard];
+        uint32_t outcome = slot.status.exchange(Pending);
+        if (outcome != Pending) {
+            Stats::merge(slot.stats);
+        }
+        if (outcome == Done && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            continue;
+        }
+
+        size_t first = firstChunk(shard), last = firstChunk(shard + 1);
+        size_t resume = first + static_cast<size_t>(slot.chunksDone.load());
+        if (!ok || attempts[shard] >= SHARD_ATTEMPTS) {
+            std::cerr << "Error: The worker for chunks " << first << "-" << last - 1 << " " << describeExit(status)
+                      << "; giving up after " << attempts[shard] << " attempts." << std::endl;
+            ok = false;
+            continue;
+        }
+        std::cerr << "Warning: The worker for chunks " << first << "-" << last - 1 << " " << describeExit(status)
+                  << "; restarting it at chunk " << resume << "." << std::endl;
+        pid_t restarted = startWorker(job, shard, first, last, slot);
+        if (restarted < 0) {
+            std::cerr << "Error: Could not start a worker process: " << std::strerror(errno) << std::endl;
+            ok = false;
+            continue;
+        }
+        running[restarted] = shard;
+        ++attempts[shard];
+    }
+    return ok;
+}
+
+BodyTransform shardedBody(size_t processes, size_t blockSize, const ChunkTransform& transform) {
+    return [processes, blockSize, &transform](int input, int output, uint64_t bodyLength, uint64_t inputBase,
+                                              uint64_t outputBase) {
+        ShardJob job{input, output, bodyLength, inputBase, outputBase, blockSize, transform, numaNodeCpus()};
+        return runShards(processes, job);
+    };
+}
+
+#endif
+
+} // namespace
+
+bool encryptFileSharded(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                        size_t processes, const ChunkTransform& transform, const std::vector<uint8_t>& header,
+                        bool padded) {
+#ifdef SHARDED_FILE_PROCESSES
+    return encryptFilePositional(inputFile, outputFile, blockSize, shardedBody(processes, blockSize, transform),
+                                 transform, header, padded);
+#else
+    (void)processes;
+    return encryptFileStream(inputFile, outputFile, blockSize, transform, header, padded);
+#endif
+}
+
+bool decryptFileSharded(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                        size_t processes, const ChunkTransform& transform, size_t headerSize, bool padded) {
+#ifdef SHARDED_FILE_PROCESSES
+    return decryptFilePositional(inputFile, outputFile, blockSize, shardedBody(processes, blockSize, transform),
+                                 transform, headerSize, padded);
+#else
+    (void)processes;
+    return decryptFileStream(inputFile, outputFile, blockSize, transform, headerSize, padded);
+#endif
+}
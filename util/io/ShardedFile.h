@@ -0,0 +1,47 @@
+#ifndef SHARDED_FILE_H
+#define SHARDED_FILE_H
+
+/**
+ * @file ShardedFile.h
+ * @brief --processes: one file encrypted by several worker processes, each owning a byte range.
+ *
+ * Threads share one address space and one I/O queue; for the biggest files on machines
+ * with several sockets the job can instead be split across worker processes. The body
+ * of the file is cut into one shard per process, a contiguous run of PARALLEL_CHUNK_SIZE
+ * chunks, and each worker is forked with the prepared key. The output is sized up front,
+ * so every worker reads its range with pread and writes it with pwrite, independently.
+ *
+ * On Linux machines with more than one NUMA node, worker i is pinned to the CPUs of node
+ * i % nodes before it touches any memory, so its chunk buffers are allocated on that node.
+ *
+ * Workers report through a table in shared memory: how many chunks of its shard each
+ * has written, in order, whether it finished, and its --stats totals, which the parent
+ * adds to its own. A worker that fails or dies is started again, up to SHARD_ATTEMPTS
+ * times per shard, from the first chunk it had not written. The last (padded) block is
+ * done by the parent once every shard is complete.
+ *
+ * Where fork is unavailable the file is processed as a stream in this process.
+ */
+
+#include "BlockStream.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Times a shard is started before the job gives up on it
+constexpr size_t SHARD_ATTEMPTS = 3;
+
+// Encrypt with the body split across `processes` worker processes; arguments as for
+// encryptFileParallel
+bool encryptFileSharded(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                        size_t processes, const ChunkTransform& transform, const std::vector<uint8_t>& header = {},
+                        bool padded = true);
+
+// Decrypt with the body split across `processes` worker processes; arguments as for
+// decryptFileParallel
+bool decryptFileSharded(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                        size_t processes, const ChunkTransform& transform, size_t headerSize = 0,
+                        bool padded = true);
+
+#endif // SHARDED_FILE_H
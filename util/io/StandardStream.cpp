@@ -0,0 +1,176 @@
+/**
+ * @file StandardStream.cpp
+ * @brief Chunk loops over stdio files, standard input and standard output.
+ *
+ * The loops are BlockStream's; StdioBuffer only lets them run on a FILE*. Chunk-sized
+ * reads and writes go straight to fread/fwrite, which hand them to the kernel without
+ * passing through the stdio buffer.
+ */
+
+#include "StandardStream.h"
+#include "../stats/Stats.h"
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+// Unbuffered std::streambuf over a FILE*, so the istream/ostream chunk loops can read
+// and write standard input and output
+class StdioBuffer : public std::streambuf {
+public:
+    explicit StdioBuffer(std::FILE* file) : file(file) {}
+
+protected:
+    std::streamsize xsgetn(char* data, std::streamsize count) override {
+        std::streamsize taken = 0;
+        while (taken < count && gptr() < egptr()) {
+            data[taken++] = *gptr();
+            gbump(1);
+        }
+        return taken + static_cast<std::streamsize>(std::fread(data + taken, 1, static_cast<size_t>(count - taken), file));
+    }
+
+    int_type underflow() override {
+        if (std::fread(&single, 1, 1, file) != 1) {
+            return traits_type::eof();
+        }
+        setg(&single, &single, &single + 1);
+        return traits_type::to_int_type(single);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        return static_cast<std::streamsize>(std::fwrite(data, 1, static_cast<size_t>(count), file));
+    }
+
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        return std::fputc(c, file) == EOF ? traits_type::eof() : c;
+    }
+
+    int sync() override {
+        return std::fflush(file) == 0 ? 0 : -1;
+    }
+
+private:
+    std::FILE* file;
+    char single = 0;
+};
+
+// The FILE* behind a file argument; only files opened by name are closed
+struct StdioFile {
+    std::FILE* file = nullptr;
+    bool owned = false;
+
+    StdioFile() = default;
+    StdioFile(const StdioFile&) = delete;
+    StdioFile& operator=(const StdioFile&) = delete;
+
+    ~StdioFile() {
+        if (owned && file) {
+            std::fclose(file);
+        }
+    }
+};
+
+// Give a pipe room for a whole chunk, so each read or write moves one chunk instead of
+// blocking every 64 KB. Best effort: pipe-max-size may be lower, and files are left alone.
+void enlargePipe(std::FILE* file) {
+#if defined(__linux__)
+    int fd = fileno(file);
+    struct stat info {};
+    if (fstat(fd, &info) == 0 && S_ISFIFO(info.st_mode) && fcntl(fd, F_GETPIPE_SZ) < static_cast<int>(STREAM_CHUNK_SIZE)) {
+        fcntl(fd, F_SETPIPE_SZ, static_cast<int>(STREAM_CHUNK_SIZE));
+    }
+#else
+    (void)file;
+#endif
+}
+
+bool openStdioFile(const std::string& name, bool forInput, StdioFile& result) {
+    if (isStandardStream(name)) {
+        result.file = forInput ? stdin : stdout;
+#if defined(_WIN32)
+        _setmode(_fileno(result.file), _O_BINARY);
+#endif
+    } else {
+        result.file = std::fopen(name.c_str(), forInput ? "rb" : "wb");
+        result.owned = true;
+        if (!result.file) {
+            std::cerr << "Error: Could not open " << (forInput ? "input" : "output") << " file " << name << std::endl;
+            return false;
+        }
+    }
+    enlargePipe(result.file);
+    return true;
+}
+
+// Report what the chunk loops cannot see: a read error looks like end of input to them,
+// and buffered output may still fail when it is flushed or closed
+bool finish(StdioFile& input, StdioFile& output, bool ok) {
+    if (ok && std::ferror(input.file)) {
+        std::cerr << "Error: Failed to read input data." << std::endl;
+        ok = false;
+    }
+    bool flushed = std::fflush(output.file) == 0 && !std::ferror(output.file);
+    if (output.owned) {
+        flushed = std::fclose(output.file) == 0 && flushed;
+        output.file = nullptr;
+    }
+    if (ok && !flushed) {
+        std::cerr << "Error: Failed to write output data." << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+} // namespace
+
+bool encryptStandardStream(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           const ChunkTransform& transform, const std::vector<uint8_t>& header, bool padded) {
+    StdioFile input, output;
+    if (!openStdioFile(inputFile, true, input) || !openStdioFile(outputFile, false, output)) {
+        return false;
+    }
+    StdioBuffer inputBuffer(input.file), outputBuffer(output.file);
+    std::istream in(&inputBuffer);
+    std::ostream out(&outputBuffer);
+
+    if (!header.empty()) {
+        StageTimer timer(Stage::Write, header.size());
+        out.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    }
+    bool ok = encryptStream(in, out, blockSize, transform, padded);
+    return finish(input, output, ok);
+}
+
+bool decryptStandardStream(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           const ChunkTransform& transform, uint8_t* header, size_t headerSize, bool padded) {
+    StdioFile input, output;
+    if (!openStdioFile(inputFile, true, input) || !openStdioFile(outputFile, false, output)) {
+        return false;
+    }
+    StdioBuffer inputBuffer(input.file), outputBuffer(output.file);
+    std::istream in(&inputBuffer);
+    std::ostream out(&outputBuffer);
+
+    if (headerSize > 0) {
+        StageTimer timer(Stage::Read, headerSize);
+        if (!in.read(reinterpret_cast<char*>(header), static_cast<std::streamsize>(headerSize))) {
+            std::cerr << "Error: Ciphertext is too short to contain an IV." << std::endl;
+            return finish(input, output, false);
+        }
+    }
+    bool ok = decryptStream(in, out, blockSize, transform, padded);
+    return finish(input, output, ok);
+}
@@ -0,0 +1,43 @@
+#ifndef STANDARD_STREAM_H
+#define STANDARD_STREAM_H
+
+/**
+ * @file StandardStream.h
+ * @brief Single-pass jobs for "-" (standard input or output) and other pipes.
+ *
+ * A pipe can be neither mapped, split between threads nor seeked, and its length is
+ * unknown until it ends, so these jobs read it once, front to back, through the chunk
+ * loops of BlockStream.h: encryption pads whatever the last chunk turns out to be, and
+ * decryption holds back the last block until end of input shows it carries the padding.
+ * Memory use stays at one chunk however much data flows through.
+ *
+ * On Linux the pipes on either side are enlarged (F_SETPIPE_SZ) to one chunk, so a
+ * whole chunk moves per read or write instead of the default 64 KB; where the limit
+ * in /proc/sys/fs/pipe-max-size is lower the pipe keeps its size.
+ */
+
+#include "BlockStream.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Whether a file argument means standard input or output
+inline bool isStandardStream(const std::string& path) {
+    return path == "-";
+}
+
+// encryptStream from `inputFile` into `outputFile`, either of which may be "-",
+// writing `header` (e.g. an IV) in front of the output
+bool encryptStandardStream(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           const ChunkTransform& transform, const std::vector<uint8_t>& header = {},
+                           bool padded = true);
+
+// decryptStream from `inputFile` into `outputFile`, either of which may be "-". The
+// first `headerSize` bytes of the input are read into `header` before the first chunk
+// is transformed, since a pipe cannot be read twice.
+bool decryptStandardStream(const std::string& inputFile, const std::string& outputFile, size_t blockSize,
+                           const ChunkTransform& transform, uint8_t* header = nullptr, size_t headerSize = 0,
+                           bool padded = true);
+
+#endif // STANDARD_STREAM_H
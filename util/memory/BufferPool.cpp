@@ -0,0 +1,285 @@
+/**
+ * @file BufferPool.cpp
+ * @brief Per-thread buffer caches over a shared depot, with huge page backed blocks.
+ */
+
+#include "BufferPool.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+enum Backing : uint8_t {
+    Heap,            // Aligned operator new
+    HugeTlb,         // mmap(MAP_HUGETLB) from the reserved huge pages
+    TransparentHuge  // mmap, 2 MB aligned and madvise(MADV_HUGEPAGE)
+};
+
+constexpr size_t HEAP_GRANULE = 64 << 10;   // Small blocks are rounded to this, so near sizes share blocks
+constexpr size_t THREAD_CACHE_BLOCKS = 8;
+
+struct Counters {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> reused{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> allocatedBytes{0};
+    std::atomic<uint64_t> hugePageBuffers{0};
+    std::atomic<uint64_t> transparentHugeBuffers{0};
+    std::atomic<uint64_t> pageFaultsSaved{0};
+};
+
+Counters totals;
+
+// Set after MAP_HUGETLB failed once, i.e. no huge pages are reserved; not tried again
+std::atomic<bool> hugeTlbUnavailable{false};
+
+size_t roundUp(size_t value, size_t granule) {
+    return (value + granule - 1) / granule * granule;
+}
+
+size_t basePageSize() {
+#if defined(__unix__) || defined(__APPLE__)
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+size_t blockSizeFor(size_t size) {
+    return roundUp(size, size >= HUGE_PAGE_SIZE ? basePageSize() : HEAP_GRANULE);
+}
+
+BufferBlock allocate(size_t size) {
+    BufferBlock block;
+    block.touched = size;
+#if defined(__linux__)
+    if (size >= HUGE_PAGE_SIZE) {
+        if (!hugeTlbUnavailable.load(std::memory_order_relaxed)) {
+            size_t capacity = roundUp(size, HUGE_PAGE_SIZE);
+            void* memory = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (memory != MAP_FAILED) {
+                block.memory = static_cast<uint8_t*>(memory);
+                block.capacity = capacity;
+                block.backing = HugeTlb;
+                totals.hugePageBuffers.fetch_add(1, std::memory_order_relaxed);
+                return block;
+            }
+            hugeTlbUnavailable.store(true, std::memory_order_relaxed);
+        }
+
+        // Map a huge page more than needed, then trim both ends so the block starts on a
+        // 2 MB boundary: transparent huge pages only back aligned 2 MB ranges
+        size_t capacity = blockSizeFor(size);
+        size_t mapped = capacity + HUGE_PAGE_SIZE;
+        void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(memory);
+            uintptr_t aligned = roundUp(start, HUGE_PAGE_SIZE);
+            if (aligned > start) {
+                munmap(memory, aligned - start);
+            }
+            if (aligned + capacity < start + mapped) {
+                munmap(reinterpret_cast<void*>(aligned + capacity), start + mapped - aligned - capacity);
+            }
+            madvise(reinterpret_cast<void*>(aligned), capacity, MADV_HUGEPAGE);
+            block.memory = reinterpret_cast<uint8_t*>(aligned);
+            block.capacity = capacity;
+            block.backing = TransparentHuge;
+            totals.transparentHugeBuffers.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+    }
+#endif
+    block.capacity = blockSizeFor(size);
+    block.memory = static_cast<uint8_t*>(::operator new(block.capacity, std::align_val_t(BUFFER_ALIGNMENT)));
+    block.backing = Heap;
+    return block;
+}
+
+void deallocate(const BufferBlock& block) {
+#if defined(__linux__)
+    if (block.backing != Heap) {
+        munmap(block.memory, block.capacity);
+        return;
+    }
+#endif
+    ::operator delete(block.memory, std::align_val_t(BUFFER_ALIGNMENT));
+}
+
+// Whether a free block suits a request: large enough, and not so large that a small
+// request would pin a big block
+bool fits(const BufferBlock& block, size_t size) {
+    return block.capacity >= size && block.capacity <= 2 * blockSizeFor(size);
+}
+
+// Take the most recently released block that fits out of `blocks`
+bool takeFrom(std::vector<BufferBlock>& blocks, size_t size, size_t& bytes, BufferBlock& block) {
+    for (size_t i = blocks.size(); i-- > 0;) {
+        if (fits(blocks[i], size)) {
+            block = blocks[i];
+            blocks.erase(blocks.begin() + static_cast<std::ptrdiff_t>(i));
+            bytes -= block.capacity;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Free blocks of threads that have ended, for threads yet to come. Never destroyed, so
+// threads still running while the process exits can use it.
+struct Depot {
+    std::mutex mutex;
+    std::vector<BufferBlock> blocks;
+    size_t bytes = 0;
+
+    void put(const BufferBlock& block) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (bytes + block.capacity <= BUFFER_POOL_DEPOT_BYTES) {
+                blocks.push_back(block);
+                bytes += block.capacity;
+                return;
+            }
+        }
+        deallocate(block);
+    }
+
+    bool take(size_t size, BufferBlock& block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return takeFrom(blocks, size, bytes, block);
+    }
+};
+
+Depot& depot() {
+    static Depot* instance = new Depot;
+    return *instance;
+}
+
+// Set once this thread's cache is destroyed at thread exit; later releases go to the depot
+thread_local bool threadCacheGone = false;
+
+struct ThreadCache {
+    std::vector<BufferBlock> blocks;
+    size_t bytes = 0;
+
+    ThreadCache() {
+        blocks.reserve(THREAD_CACHE_BLOCKS);
+    }
+
+    ~ThreadCache() {
+        threadCacheGone = true;
+        for (const BufferBlock& block : blocks) {
+            depot().put(block);
+        }
+    }
+};
+
+ThreadCache& threadCache() {
+    thread_local ThreadCache cache;
+    return cache;
+}
+
+} // namespace
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+    : block(std::exchange(other.block, BufferBlock{})), length(std::exchange(other.length, 0)) {}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept {
+    if (this != &other) {
+        BufferPool::release(block);
+        block = std::exchange(other.block, BufferBlock{});
+        length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+PooledBuffer::~PooledBuffer() {
+    BufferPool::release(block);
+}
+
+namespace BufferPool {
+
+PooledBuffer acquire(size_t size) {
+    size = std::max<size_t>(size, 1);
+    totals.requests.fetch_add(1, std::memory_order_relaxed);
+
+    BufferBlock block;
+    bool recycled = false;
+    if (!threadCacheGone) {
+        ThreadCache& cache = threadCache();
+        recycled = takeFrom(cache.blocks, size, cache.bytes, block);
+    }
+    if (!recycled) {
+        recycled = depot().take(size, block);
+    }
+
+    if (recycled) {
+        // Pages up to the old high-water mark were faulted in by an earlier user
+        size_t page = block.backing == HugeTlb ? HUGE_PAGE_SIZE : basePageSize();
+        totals.reused.fetch_add(1, std::memory_order_relaxed);
+        totals.pageFaultsSaved.fetch_add(roundUp(std::min(size, block.touched), page) / page, std::memory_order_relaxed);
+        block.touched = std::max(block.touched, size);
+    } else {
+        block = allocate(size);
+        totals.allocations.fetch_add(1, std::memory_order_relaxed);
+        totals.allocatedBytes.fetch_add(block.capacity, std::memory_order_relaxed);
+    }
+    return PooledBuffer(block, size);
+}
+
+void release(const BufferBlock& block) {
+    if (block.memory == nullptr) {
+        return;
+    }
+    if (!threadCacheGone) {
+        ThreadCache& cache = threadCache();
+        if (cache.blocks.size() < THREAD_CACHE_BLOCKS && cache.bytes + block.capacity <= BUFFER_POOL_THREAD_BYTES) {
+            cache.blocks.push_back(block);
+            cache.bytes += block.capacity;
+            return;
+        }
+    }
+    depot().put(block);
+}
+
+BufferPoolCounters counters() {
+    BufferPoolCounters result;
+    result.requests = totals.requests.load(std::memory_order_relaxed);
+    result.reused = totals.reused.load(std::memory_order_relaxed);
+    result.allocations = totals.allocations.load(std::memory_order_relaxed);
+    result.allocatedBytes = totals.allocatedBytes.load(std::memory_order_relaxed);
+    result.hugePageBuffers = totals.hugePageBuffers.load(std::memory_order_relaxed);
+    result.transparentHugeBuffers = totals.transparentHugeBuffers.load(std::memory_order_relaxed);
+    result.pageFaultsSaved = totals.pageFaultsSaved.load(std::memory_order_relaxed);
+    return result;
+}
+
+void resetCounters() {
+    for (std::atomic<uint64_t>* counter : {&totals.requests, &totals.reused, &totals.allocations, &totals.allocatedBytes,
+                                           &totals.hugePageBuffers, &totals.transparentHugeBuffers,
+                                           &totals.pageFaultsSaved}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+}
+
+void mergeCounters(const BufferPoolCounters& other) {
+    totals.requests.fetch_add(other.requests, std::memory_order_relaxed);
+    totals.reused.fetch_add(other.reused, std::memory_order_relaxed);
+    totals.allocations.fetch_add(other.allocations, std::memory_order_relaxed);
+    totals.allocatedBytes.fetch_add(other.allocatedBytes, std::memory_order_relaxed);
+    totals.hugePageBuffers.fetch_add(other.hugePageBuffers, std::memory_order_relaxed);
+    totals.transparentHugeBuffers.fetch_add(other.transparentHugeBuffers, std::memory_order_relaxed);
+    totals.pageFaultsSaved.fetch_add(other.pageFaultsSaved, std::memory_order_relaxed);
+}
+
+} // namespace BufferPool
@@ -0,0 +1,101 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+/**
+ * @file BufferPool.h
+ * @brief Recycled, 64-byte aligned chunk buffers for the I/O paths, on huge pages where possible.
+ *
+ * Every file job needs chunk buffers of 64 KB to a few MB: the stream loop, the
+ * pipeline, each worker of a parallel job, the container groups, the in-place chunk.
+ * Allocated fresh, each of them is a trip to the allocator (mmap for sizes like these),
+ * a page fault per 4 KB touched and TLB misses while the chunk is worked on, and all of
+ * it is thrown away when the job ends. Jobs come in runs: the files of a --recursive
+ * tree, the chunks of a parallel job, the jobs of a --serve daemon.
+ *
+ * BufferPool::acquire hands out a buffer that goes back to the pool when its
+ * PooledBuffer is destroyed, ready for the next job with its pages already mapped.
+ * Each thread keeps its own free buffers (its arena), so acquiring and releasing take
+ * no lock. When a thread ends, e.g. the workers of a job's ThreadPool, its buffers move
+ * to a shared depot where the next job's threads find them. Both are capped
+ * (BUFFER_POOL_THREAD_BYTES, BUFFER_POOL_DEPOT_BYTES); what does not fit is freed.
+ *
+ * Buffers are aligned to BUFFER_ALIGNMENT, a cache line, so chunks start on a line
+ * and aligned vector loads are safe from the start of a buffer. Buffers of
+ * HUGE_PAGE_SIZE and up are mapped on their own: on explicitly reserved huge pages
+ * (MAP_HUGETLB) when the system has some, otherwise 2 MB aligned and advised for
+ * transparent huge pages (MADV_HUGEPAGE). Smaller ones come from the heap.
+ *
+ * The contents of an acquired buffer are undefined, and may be data of an earlier job
+ * of this process: callers write before they read, and write out only what they wrote.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+constexpr size_t BUFFER_ALIGNMENT = 64;
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+constexpr size_t BUFFER_POOL_THREAD_BYTES = 64 << 20;
+constexpr size_t BUFFER_POOL_DEPOT_BYTES = 256 << 20;
+
+// `size` rounded up to whole cache lines: the stride for several buffers carved from one,
+// so that each of them starts on a line too
+constexpr size_t alignedBufferSize(size_t size) {
+    return (size + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+}
+
+// Process-wide totals, for the --stats report
+struct BufferPoolCounters {
+    uint64_t requests = 0;        // Buffers handed out
+    uint64_t reused = 0;          // ... of them recycled, i.e. allocations avoided
+    uint64_t allocations = 0;     // ... of them freshly allocated
+    uint64_t allocatedBytes = 0;
+    uint64_t hugePageBuffers = 0;         // Fresh buffers on reserved huge pages (MAP_HUGETLB)
+    uint64_t transparentHugeBuffers = 0;  // Fresh buffers advised for transparent huge pages
+    uint64_t pageFaultsSaved = 0;  // Estimate: pages of recycled buffers that were already mapped in
+};
+
+// A memory block as the pool keeps it
+struct BufferBlock {
+    uint8_t* memory = nullptr;
+    size_t capacity = 0;
+    size_t touched = 0;  // Most bytes any user asked for, i.e. how far the pages may be mapped in
+    uint8_t backing = 0;  // How it was allocated, see BufferPool.cpp
+};
+
+// A buffer from BufferPool::acquire, returned to the pool when destroyed
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    explicit PooledBuffer(const BufferBlock& block, size_t length) : block(block), length(length) {}
+    PooledBuffer(PooledBuffer&& other) noexcept;
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+    ~PooledBuffer();
+
+    uint8_t* data() const { return block.memory; }
+    size_t size() const { return length; }
+    uint8_t& operator[](size_t index) const { return block.memory[index]; }
+
+private:
+    BufferBlock block;
+    size_t length = 0;
+};
+
+namespace BufferPool {
+
+// A buffer of at least `size` bytes, recycled if the pool has one that fits
+PooledBuffer acquire(size_t size);
+
+// Give a block back; called by ~PooledBuffer
+void release(const BufferBlock& block);
+
+BufferPoolCounters counters();
+
+// Zero the counters, or add those of another process; see Stats::reset and Stats::merge
+void resetCounters();
+void mergeCounters(const BufferPoolCounters& other);
+
+} // namespace BufferPool
+
+#endif // BUFFER_POOL_H
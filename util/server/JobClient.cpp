@@ -0,0 +1,133 @@
+/**
+ * @file JobClient.cpp
+ * @brief Sending jobs to an encryption_tool --serve daemon and reading the replies.
+ */
+
+#include "JobClient.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+JobClient::~JobClient() {
+    close();
+}
+
+bool JobClient::fail(const std::string& message) {
+    lastError = message;
+    return false;
+}
+
+bool JobClient::run(const JobSpec& spec, std::span<const uint8_t> input, std::vector<uint8_t>& output) {
+    return exchange(spec, JobSource::Memory, input, {}, output);
+}
+
+bool JobClient::runFiles(const JobSpec& spec, const std::string& inputFile, const std::string& outputFile) {
+    std::string paths = inputFile;
+    paths.push_back('\0');
+    paths += outputFile;
+    return exchange(spec, JobSource::Paths, {reinterpret_cast<const uint8_t*>(paths.data()), paths.size()}, {},
+                    response);
+}
+
+bool JobClient::runDescriptors(const JobSpec& spec, int inputFd, int outputFd) {
+    const int fds[2] = {inputFd, outputFd};
+    return exchange(spec, JobSource::Descriptors, {}, fds, response);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+bool JobClient::connect(const std::string& socketPath) {
+    close();
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        return fail("Error: Socket path " + socketPath + " is too long.");
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket < 0) {
+        return fail(std::string("Error: Could not create a socket: ") + std::strerror(errno));
+    }
+    if (::connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        std::string reason = std::strerror(errno);
+        close();
+        return fail("Error: Could not connect to " + socketPath + ": " + reason);
+    }
+    return true;
+}
+
+void JobClient::close() {
+    if (socket >= 0) {
+        ::close(socket);
+        socket = -1;
+    }
+}
+
+bool JobClient::exchange(const JobSpec& spec, JobSource source, std::span<const uint8_t> payload,
+                         std::span<const int> fds, std::vector<uint8_t>& output) {
+    if (socket < 0) {
+        return fail("Error: Not connected to a server.");
+    }
+    JobRequestHeader request;
+    request.operation = spec.operation;
+    request.cipher = static_cast<uint8_t>(spec.cipher);
+    request.mode = static_cast<uint8_t>(spec.mode);
+    request.source = source;
+    request.threads = spec.threads;
+    request.keyLength = static_cast<uint32_t>(spec.key.size());
+    request.id = nextId++;
+    request.payloadLength = payload.size();
+
+    uint8_t header[JOB_REQUEST_HEADER_SIZE];
+    encodeRequestHeader(request, header);
+    const std::span<const uint8_t> parts[3] = {
+        header, {reinterpret_cast<const uint8_t*>(spec.key.data()), spec.key.size()}, payload};
+    if (!sendParts(socket, parts, fds)) {
+        close();
+        return fail("Error: The server closed the connection.");
+    }
+
+    uint8_t replyBytes[JOB_RESPONSE_HEADER_SIZE];
+    JobResponseHeader reply;
+    size_t fdCount = 0;
+    bool closed = false;
+    if (!receiveExactly(socket, replyBytes, sizeof(replyBytes), {}, fdCount, closed) ||
+        !decodeResponseHeader(replyBytes, reply) || reply.id != request.id) {
+        close();
+        return fail("Error: No valid response from the server.");
+    }
+    std::vector<uint8_t>& body = reply.status == JobStatus::Ok ? output : response;
+    body.resize(reply.payloadLength);
+    if (!receiveExactly(socket, body.data(), body.size(), {}, fdCount, closed)) {
+        close();
+        return fail("Error: The server closed the connection.");
+    }
+    if (reply.status != JobStatus::Ok) {
+        if (reply.status == JobStatus::BadRequest) {
+            close();
+        }
+        return fail(std::string(body.begin(), body.end()));
+    }
+    return true;
+}
+
+#else
+
+bool JobClient::connect(const std::string&) {
+    return fail("Error: The job server client needs Unix domain sockets, which this platform lacks.");
+}
+
+void JobClient::close() {}
+
+bool JobClient::exchange(const JobSpec&, JobSource, std::span<const uint8_t>, std::span<const int>,
+                         std::vector<uint8_t>&) {
+    return fail("Error: Not connected to a server.");
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef JOB_CLIENT_H
+#define JOB_CLIENT_H
+
+/**
+ * @file JobClient.h
+ * @brief Client library for an encryption_tool --serve daemon.
+ *
+ * One JobClient is one connection. Jobs on it run one after another, so a program that
+ * wants several in flight opens several clients. Buffers are reused between jobs: after
+ * the first few, a Memory job costs one sendmsg and two reads.
+ *
+ *   JobClient client;
+ *   JobSpec spec{JobOperation::Encrypt, ContainerCipher::AES, CipherMode::CTR, key};
+ *   std::vector<uint8_t> ciphertext;
+ *   if (!client.connect("/run/encryption.sock") || !client.run(spec, plaintext, ciphertext)) {
+ *       std::cerr << client.error() << std::endl;
+ *   }
+ *
+ * Unlike the rest of the tool, the client prints nothing: a failure returns false and
+ * error() holds the message, the server's own when the job itself failed.
+ */
+
+#include "JobProtocol.h"
+#include "../algorithm/modes/CipherMode.h"
+#include "../io/ContainerFormat.h"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// What to do with a job's data
+struct JobSpec {
+    JobOperation operation = JobOperation::Encrypt;
+    ContainerCipher cipher = ContainerCipher::AES;
+    CipherMode mode = CipherMode::ECB;
+    std::string key;
+    uint16_t threads = 1;  // For file jobs; 0 means one per hardware thread of the server
+};
+
+class JobClient {
+public:
+    JobClient() = default;
+    JobClient(const JobClient&) = delete;
+    JobClient& operator=(const JobClient&) = delete;
+    ~JobClient();
+
+    // Connect to the server listening on `socketPath`
+    bool connect(const std::string& socketPath);
+    void close();
+    bool connected() const { return socket >= 0; }
+
+    // Encrypt or decrypt `input` in memory; the result replaces the contents of `output`
+    bool run(const JobSpec& spec, std::span<const uint8_t> input, std::vector<uint8_t>& output);
+
+    // Encrypt or decrypt a file the server opens by name, as encryption_tool would
+    bool runFiles(const JobSpec& spec, const std::string& inputFile, const std::string& outputFile);
+
+    // Encrypt or decrypt between two open files, handed to the server with SCM_RIGHTS.
+    // The descriptors stay open here; the output must be open for writing.
+    bool runDescriptors(const JobSpec& spec, int inputFd, int outputFd);
+
+    // Why the last call failed
+    const std::string& error() const { return lastError; }
+
+private:
+    bool exchange(const JobSpec& spec, JobSource source, std::span<const uint8_t> payload, std::span<const int> fds,
+                  std::vector<uint8_t>& output);
+    bool fail(const std::string& message);
+
+    int socket = -1;
+    uint64_t nextId = 1;
+    std::string lastError;
+    std::vector<uint8_t> response;  // Reused for error messages and file job replies
+};
+
+#endif // JOB_CLIENT_H
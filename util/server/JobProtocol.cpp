@@ -0,0 +1,198 @@
+/**
+ * @file JobProtocol.cpp
+ * @brief Header encoding and the socket send/receive loops shared by the job server and client.
+ */
+
+#include "JobProtocol.h"
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char REQUEST_MAGIC[4] = {'F', 'E', 'J', 'Q'};
+const char RESPONSE_MAGIC[4] = {'F', 'E', 'J', 'R'};
+
+// Descriptors one message can carry; a request has two
+constexpr size_t MAX_FDS = 4;
+
+void putLE(uint8_t* p, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint64_t getLE(const uint8_t* p, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+} // namespace
+
+void encodeRequestHeader(const JobRequestHeader& header, uint8_t* bytes) {
+    std::memcpy(bytes, REQUEST_MAGIC, 4);
+    putLE(bytes + 4, JOB_PROTOCOL_VERSION, 2);
+    bytes[6] = static_cast<uint8_t>(header.operation);
+    bytes[7] = header.cipher;
+    bytes[8] = header.mode;
+    bytes[9] = static_cast<uint8_t>(header.source);
+    putLE(bytes + 10, header.threads, 2);
+    putLE(bytes + 12, header.keyLength, 4);
+    putLE(bytes + 16, header.id, 8);
+    putLE(bytes + 24, header.payloadLength, 8);
+}
+
+void encodeResponseHeader(const JobResponseHeader& header, uint8_t* bytes) {
+    std::memcpy(bytes, RESPONSE_MAGIC, 4);
+    putLE(bytes + 4, JOB_PROTOCOL_VERSION, 2);
+    bytes[6] = static_cast<uint8_t>(header.status);
+    bytes[7] = 0;
+    putLE(bytes + 8, header.id, 8);
+    putLE(bytes + 16, header.payloadLength, 8);
+}
+
+bool decodeRequestHeader(const uint8_t* bytes, JobRequestHeader& header) {
+    if (std::memcmp(bytes, REQUEST_MAGIC, 4) != 0 || getLE(bytes + 4, 2) != JOB_PROTOCOL_VERSION) {
+        return false;
+    }
+    header.operation = static_cast<JobOperation>(bytes[6]);
+    header.cipher = bytes[7];
+    header.mode = bytes[8];
+    header.source = static_cast<JobSource>(bytes[9]);
+    header.threads = static_cast<uint16_t>(getLE(bytes + 10, 2));
+    header.keyLength = static_cast<uint32_t>(getLE(bytes + 12, 4));
+    header.id = getLE(bytes + 16, 8);
+    header.payloadLength = getLE(bytes + 24, 8);
+    return true;
+}
+
+bool decodeResponseHeader(const uint8_t* bytes, JobResponseHeader& header) {
+    if (std::memcmp(bytes, RESPONSE_MAGIC, 4) != 0 || getLE(bytes + 4, 2) != JOB_PROTOCOL_VERSION) {
+        return false;
+    }
+    header.status = static_cast<JobStatus>(bytes[6]);
+    header.id = getLE(bytes + 8, 8);
+    header.payloadLength = getLE(bytes + 16, 8);
+    return true;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+bool sendParts(int socket, std::span<const std::span<const uint8_t>> parts, std::span<const int> fds) {
+    constexpr size_t MAX_PARTS = 8;
+    iovec iov[MAX_PARTS];
+    size_t count = 0;
+    for (std::span<const uint8_t> part : parts) {
+        if (!part.empty() && count < MAX_PARTS) {
+            iov[count].iov_base = const_cast<uint8_t*>(part.data());
+            iov[count].iov_len = part.size();
+            ++count;
+        }
+    }
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+    size_t first = 0;
+    bool attach = !fds.empty() && fds.size() <= MAX_FDS;
+    while (first < count) {
+        msghdr message{};
+        message.msg_iov = iov + first;
+        message.msg_iovlen = static_cast<decltype(message.msg_iovlen)>(count - first);
+        if (attach) {
+            std::memset(control, 0, sizeof(control));
+            message.msg_control = control;
+            message.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+            cmsghdr* header = CMSG_FIRSTHDR(&message);
+            header->cmsg_level = SOL_SOCKET;
+            header->cmsg_type = SCM_RIGHTS;
+            header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+            std::memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+        }
+#if defined(MSG_NOSIGNAL)
+        ssize_t sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+#else
+        ssize_t sent = sendmsg(socket, &message, 0);
+#endif
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        attach = false;
+        // Skip what went out; a part may have been sent only in part
+        size_t remaining = static_cast<size_t>(sent);
+        while (first < count && remaining >= iov[first].iov_len) {
+            remaining -= iov[first].iov_len;
+            ++first;
+        }
+        if (first < count) {
+            iov[first].iov_base = static_cast<uint8_t*>(iov[first].iov_base) + remaining;
+            iov[first].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+bool receiveExactly(int socket, uint8_t* data, size_t length, std::span<int> fds, size_t& fdCount, bool& closed) {
+    closed = false;
+    size_t received = 0;
+    while (received < length) {
+        iovec iov{data + received, length - received};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+#if defined(MSG_CMSG_CLOEXEC)
+        ssize_t count = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+#else
+        ssize_t count = recvmsg(socket, &message, 0);
+#endif
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            closed = count == 0 && received == 0;
+            return false;
+        }
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            size_t arrived = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < arrived; ++i) {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+                if (fdCount < fds.size()) {
+                    fds[fdCount++] = fd;
+                } else {
+                    close(fd);
+                }
+            }
+        }
+        received += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+#else
+
+bool sendParts(int, std::span<const std::span<const uint8_t>>, std::span<const int>) {
+    return false;
+}
+
+bool receiveExactly(int, uint8_t*, size_t, std::span<int>, size_t& fdCount, bool& closed) {
+    fdCount = 0;
+    closed = true;
+    return false;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef JOB_PROTOCOL_H
+#define JOB_PROTOCOL_H
+
+/**
+ * @file JobProtocol.h
+ * @brief Framing of the jobs sent to an encryption_tool --serve daemon over a Unix socket.
+ *
+ * A connection carries any number of requests, each answered in order by one response.
+ * All integers are little-endian.
+ *
+ *   request   JOB_REQUEST_HEADER_SIZE bytes
+ *             magic "FEJQ", version (u16), operation (u8), cipher (u8, ContainerCipher),
+ *             mode (u8, CipherMode), source (u8), threads (u16), key length (u32),
+ *             request id (u64), payload length (u64)
+ *             followed by the key and the payload:
+ *             - JobSource::Memory       the data itself
+ *             - JobSource::Paths        "<input file>\0<output file>"
+ *             - JobSource::Descriptors  nothing; the input and output file descriptors
+ *                                       travel with the header as SCM_RIGHTS
+ *   response  JOB_RESPONSE_HEADER_SIZE bytes
+ *             magic "FEJR", version (u16), status (u8), reserved (u8), request id (u64),
+ *             payload length (u64)
+ *             followed by the result of a Memory job, or the error message when the
+ *             status is not JobStatus::Ok
+ *
+ * Passing descriptors lets a client hand over files the server could not open by name
+ * and skips the path lookup; the data itself never crosses the socket.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+constexpr uint16_t JOB_PROTOCOL_VERSION = 1;
+constexpr size_t JOB_REQUEST_HEADER_SIZE = 32;
+constexpr size_t JOB_RESPONSE_HEADER_SIZE = 24;
+constexpr size_t JOB_MAX_KEY_SIZE = 1024;
+constexpr uint64_t JOB_MAX_PATHS_SIZE = 8192;
+// Larger data should be passed as a file, which is not copied through the socket
+constexpr uint64_t JOB_MAX_MEMORY_PAYLOAD = 64 << 20;
+
+enum class JobOperation : uint8_t {
+    Encrypt = 1,
+    Decrypt = 2
+};
+
+enum class JobSource : uint8_t {
+    Memory = 0,
+    Paths = 1,
+    Descriptors = 2
+};
+
+enum class JobStatus : uint8_t {
+    Ok = 0,
+    Failed = 1,     // The job ran and failed, e.g. wrong key or malformed ciphertext
+    BadRequest = 2  // The request was not understood; the connection is closed after it
+};
+
+struct JobRequestHeader {
+    JobOperation operation = JobOperation::Encrypt;
+    uint8_t cipher = 0;  // ContainerCipher value
+    uint8_t mode = 0;    // CipherMode value
+    JobSource source = JobSource::Memory;
+    uint16_t threads = 1;  // Threads for a file job, 0 for one per hardware thread
+    uint32_t keyLength = 0;
+    uint64_t id = 0;  // Echoed in the response
+    uint64_t payloadLength = 0;
+};
+
+struct JobResponseHeader {
+    JobStatus status = JobStatus::Ok;
+    uint64_t id = 0;
+    uint64_t payloadLength = 0;
+};
+
+void encodeRequestHeader(const JobRequestHeader& header, uint8_t* bytes);
+void encodeResponseHeader(const JobResponseHeader& header, uint8_t* bytes);
+
+// Parse a header; false if the magic or version is wrong
+bool decodeRequestHeader(const uint8_t* bytes, JobRequestHeader& header);
+bool decodeResponseHeader(const uint8_t* bytes, JobResponseHeader& header);
+
+// Send all of `parts` in as few sendmsg calls as possible, with `fds` attached to the
+// first byte as SCM_RIGHTS. False if the peer is gone.
+bool sendParts(int socket, std::span<const std::span<const uint8_t>> parts, std::span<const int> fds = {});
+
+// Receive exactly `length` bytes. Descriptors that arrive with them are added to `fds`
+// (up to its size) and counted in `fdCount`; extra ones are closed. False on error or
+// end of stream; `closed` tells apart a peer that hung up before the first byte.
+bool receiveExactly(int socket, uint8_t* data, size_t length, std::span<int> fds, size_t& fdCount, bool& closed);
+
+#endif // JOB_PROTOCOL_H
@@ -0,0 +1,522 @@
+/**
+ * @file JobServer.cpp
+ * @brief The --serve daemon: accepting connections, warm sessions and running the jobs.
+ */
+
+#include "JobServer.h"
+#include "JobProtocol.h"
+#include "../algorithm/CryptoAlgorithm.h"
+#include "../algorithm/symmetric/AES/AES.h"
+#include "../algorithm/symmetric/DES/DES.h"
+#include "../algorithm/symmetric/TripleDES/TripleDES.h"
+#include "../io/BlockStream.h"
+#include "../io/ContainerFormat.h"
+#include "../io/StandardStream.h"
+#include "../thread/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <streambuf>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// What a handler thread keeps between jobs
+struct Session {
+    std::unique_ptr<CryptoAlgorithm> algorithms[4];  // By ContainerCipher value, created on first use
+    std::string key;
+    std::vector<uint8_t> input;   // Both buffers grow to the largest job seen and stay
+    std::vector<uint8_t> output;
+    std::string errors;  // What the current job printed to std::cerr
+};
+
+// The captured std::cerr output of the job running on this thread, or nullptr
+thread_local std::string* jobErrors = nullptr;
+
+// Installed on std::cerr and std::cout while the server runs. Writes from a thread that
+// is running a job are captured (std::cerr) or dropped (std::cout); all others go on
+// to the stream's own buffer.
+class JobStreamBuffer : public std::streambuf {
+public:
+    JobStreamBuffer(std::ostream& stream, bool capture) : stream(stream), capture(capture) {
+        target = stream.rdbuf(this);
+    }
+
+    ~JobStreamBuffer() override {
+        stream.rdbuf(target);
+    }
+
+protected:
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        if (jobErrors) {
+            if (capture) {
+                jobErrors->append(data, static_cast<size_t>(count));
+            }
+            return count;
+        }
+        return target->sputn(data, count);
+    }
+
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        char byte = traits_type::to_char_type(c);
+        return xsputn(&byte, 1) == 1 ? c : traits_type::eof();
+    }
+
+    int sync() override {
+        return jobErrors ? 0 : target->pubsync();
+    }
+
+private:
+    std::ostream& stream;
+    std::streambuf* target = nullptr;
+    bool capture;
+};
+
+// Routes this thread's std::cerr output into `errors` while the job runs
+struct CapturedOutput {
+    explicit CapturedOutput(std::string& errors) {
+        errors.clear();
+        jobErrors = &errors;
+    }
+
+    ~CapturedOutput() {
+        jobErrors = nullptr;
+    }
+};
+
+// Descriptors received with a request; closed once the job is done
+struct ReceivedDescriptors {
+    int fds[2] = {-1, -1};
+    size_t count = 0;
+
+    ReceivedDescriptors() = default;
+    ReceivedDescriptors(const ReceivedDescriptors&) = delete;
+    ReceivedDescriptors& operator=(const ReceivedDescriptors&) = delete;
+
+    ~ReceivedDescriptors() {
+        for (size_t i = 0; i < count; ++i) {
+            close(fds[i]);
+        }
+    }
+};
+
+std::unique_ptr<CryptoAlgorithm> makeAlgorithm(ContainerCipher cipher) {
+    switch (cipher) {
+        case ContainerCipher::DES: return std::make_unique<DES>();
+        case ContainerCipher::TripleDES: return std::make_unique<TripleDES>();
+        case ContainerCipher::AES: return std::make_unique<AES>();
+    }
+    return nullptr;
+}
+
+void ignoreSigPipe(int socket) {
+#if defined(SO_NOSIGPIPE)
+    int on = 1;
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)socket;
+#endif
+}
+
+JobStatus failJob(Session& session, const std::string& message) {
+    session.errors = message;
+    return JobStatus::Failed;
+}
+
+// Run one request whose key and payload are in the session. A Memory job leaves its
+// result in `result`; a failed job leaves its message in session.errors.
+JobStatus runJob(const JobRequestHeader& request, const ReceivedDescriptors& descriptors, Session& session,
+                 std::span<const uint8_t>& result) {
+    if (request.cipher < static_cast<uint8_t>(ContainerCipher::DES) ||
+        request.cipher > static_cast<uint8_t>(ContainerCipher::AES)) {
+        return failJob(session, "Error: Unknown cipher " + std::to_string(request.cipher) + " in the request.");
+    }
+    if (request.mode > static_cast<uint8_t>(CipherMode::CTR)) {
+        return failJob(session, "Error: Unknown mode " + std::to_string(request.mode) + " in the request.");
+    }
+    if (request.operation != JobOperation::Encrypt && request.operation != JobOperation::Decrypt) {
+        return failJob(session, "Error: Unknown operation in the request.");
+    }
+
+    std::string inputFile, outputFile;
+    if (request.source == JobSource::Paths) {
+        const char* paths = reinterpret_cast<const char*>(session.input.data());
+        size_t length = static_cast<size_t>(request.payloadLength);
+        size_t split = std::string_view(paths, length).find('\0');
+        if (split == std::string_view::npos) {
+            return failJob(session, "Error: A file job needs \"<input>\\0<output>\" as its payload.");
+        }
+        inputFile.assign(paths, split);
+        outputFile.assign(paths + split + 1, length - split - 1);
+        if (inputFile.empty() || outputFile.empty() || isStandardStream(inputFile) || isStandardStream(outputFile)) {
+            return failJob(session, "Error: A file job needs an input and an output file ('-' is the server's own).");
+        }
+    } else if (request.source == JobSource::Descriptors) {
+        if (descriptors.count != 2) {
+            return failJob(session, "Error: A descriptor job needs two descriptors (input and output), got " +
+                                        std::to_string(descriptors.count) + ".");
+        }
+        inputFile = "/dev/fd/" + std::to_string(descriptors.fds[0]);
+        outputFile = "/dev/fd/" + std::to_string(descriptors.fds[1]);
+    }
+
+    std::unique_ptr<CryptoAlgorithm>& algorithm = session.algorithms[request.cipher];
+    if (!algorithm) {
+        algorithm = makeAlgorithm(static_cast<ContainerCipher>(request.cipher));
+    }
+    algorithm->setKey(session.key);  // The key's round keys come from the algorithm's cache
+    algorithm->setMode(static_cast<CipherMode>(request.mode));
+    bool encrypt = request.operation == JobOperation::Encrypt;
+
+    CapturedOutput capture(session.errors);
+    bool ok;
+    if (request.source == JobSource::Memory) {
+        std::span<const uint8_t> input(session.input.data(), static_cast<size_t>(request.payloadLength));
+        size_t needed = encrypt ? algorithm->encryptedSize(input.size()) : input.size();
+        if (session.output.size() < needed) {
+            session.output.resize(needed);
+        }
+        size_t written = 0;
+        std::span<uint8_t> output(session.output.data(), needed);
+        ok = encrypt ? algorithm->encryptBuffer(input, output, written) : algorithm->decryptBuffer(input, output, written);
+        result = {session.output.data(), written};
+    } else {
+        algorithm->setThreads(request.threads == 0 ? ThreadPool::hardwareThreads() : request.threads);
+        algorithm->setIOBackend(IOBackend::Auto);
+        algorithm->setContainer(false);
+        algorithm->setCompress(false);
+        algorithm->setInPlace(false);
+        ok = checkDistinctFiles(inputFile, outputFile) &&
+             (encrypt ? algorithm->encrypt(inputFile, outputFile) : algorithm->decrypt(inputFile, outputFile));
+        result = {};
+    }
+    if (ok) {
+        return JobStatus::Ok;
+    }
+    while (!session.errors.empty() && (session.errors.back() == '\n' || session.errors.back() == ' ')) {
+        session.errors.pop_back();
+    }
+    if (session.errors.empty()) {
+        session.errors = "Error: The job failed.";
+    }
+    return JobStatus::Failed;
+}
+
+bool respond(int client, JobStatus status, uint64_t id, std::span<const uint8_t> payload) {
+    JobResponseHeader response;
+    response.status = status;
+    response.id = id;
+    response.payloadLength = payload.size();
+    uint8_t header[JOB_RESPONSE_HEADER_SIZE];
+    encodeResponseHeader(response, header);
+    const std::span<const uint8_t> parts[2] = {header, payload};
+    return sendParts(client, parts);
+}
+
+bool respond(int client, JobStatus status, uint64_t id, const std::string& message) {
+    return respond(client, status, id, {reinterpret_cast<const uint8_t*>(message.data()), message.size()});
+}
+
+// Run the jobs of one connection until the client hangs up or sends garbage
+void serveConnection(int client, Session& session) {
+    for (;;) {
+        uint8_t headerBytes[JOB_REQUEST_HEADER_SIZE];
+        ReceivedDescriptors descriptors;
+        bool closed = false;
+        if (!receiveExactly(client, headerBytes, sizeof(headerBytes), descriptors.fds, descriptors.count, closed)) {
+            return;
+        }
+        JobRequestHeader request;
+        if (!decodeRequestHeader(headerBytes, request)) {
+            respond(client, JobStatus::BadRequest, 0, "Error: Not a job request (wrong magic or protocol version).");
+            return;
+        }
+        uint64_t limit = request.source == JobSource::Memory ? JOB_MAX_MEMORY_PAYLOAD
+                         : request.source == JobSource::Paths ? JOB_MAX_PATHS_SIZE
+                                                              : 0;
+        if (request.keyLength > JOB_MAX_KEY_SIZE || request.payloadLength > limit) {
+            respond(client, JobStatus::BadRequest, request.id,
+                    "Error: Key or payload too large for the request (at most " + std::to_string(limit) +
+                        " payload bytes); pass large data as a file.");
+            return;
+        }
+
+        session.key.resize(request.keyLength);
+        if (session.input.size() < request.payloadLength) {
+            session.input.resize(static_cast<size_t>(request.payloadLength));
+        }
+        if (!receiveExactly(client, reinterpret_cast<uint8_t*>(session.key.data()), session.key.size(), descriptors.fds,
+                            descriptors.count, closed) ||
+            !receiveExactly(client, session.input.data(), static_cast<size_t>(request.payloadLength), descriptors.fds,
+                            descriptors.count, closed)) {
+            return;
+        }
+
+        std::span<const uint8_t> result;
+        JobStatus status = runJob(request, descriptors, session, result);
+        bool sent = status == JobStatus::Ok ? respond(client, status, request.id, result)
+                                            : respond(client, status, request.id, session.errors);
+        if (!sent) {
+            return;
+        }
+    }
+}
+
+// The server stop() wakes from a signal handler
+std::atomic<JobServer*> signalledServer{nullptr};
+
+void stopOnSignal(int) {
+    if (JobServer* server = signalledServer.load()) {
+        server->stop();
+    }
+}
+
+} // namespace
+
+JobServer::JobServer(size_t warmThreads) : warmThreads(warmThreads == 0 ? 1 : warmThreads) {}
+
+JobServer::~JobServer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& handler : handlers) {
+        handler.join();
+    }
+    for (int fd : {listener, wakeRead, wakeWrite}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool JobServer::listen(const std::string& path) {
+    sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: Socket path '" << path << "' is empty or too long." << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // A socket file left behind is reused only if nobody answers on it
+    struct stat info {};
+    if (lstat(path.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            std::cerr << "Error: " << path << " exists and is not a socket." << std::endl;
+            return false;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool answered = probe >= 0 && connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+        if (answered) {
+            std::cerr << "Error: Another server is already listening on " << path << "." << std::endl;
+            return false;
+        }
+        unlink(path.c_str());
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    int wakePipe[2];
+    if (listener < 0 || pipe(wakePipe) != 0) {
+        std::cerr << "Error: Could not create the server socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    wakeRead = wakePipe[0];
+    wakeWrite = wakePipe[1];
+    for (int fd : {listener, wakeRead, wakeWrite}) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    fcntl(wakeWrite, F_SETFL, O_NONBLOCK);
+
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Error: Could not bind " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    socketPath = path;
+    if (chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0 || ::listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "Error: Could not listen on " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < warmThreads; ++i) {
+        handlers.emplace_back(&JobServer::handlerLoop, this);
+    }
+    return true;
+}
+
+void JobServer::stop() {
+    if (wakeWrite >= 0) {
+        char byte = 0;
+        ssize_t ignored = write(wakeWrite, &byte, 1);
+        (void)ignored;
+    }
+}
+
+void JobServer::handlerLoop() {
+    Session session;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        // Enough handlers are waiting already; this one's session is not needed
+        if (pending.empty() && idle >= warmThreads) {
+            finished.push_back(std::this_thread::get_id());
+            return;
+        }
+        ++idle;
+        wake.wait(lock, [this] { return stopping || !pending.empty(); });
+        --idle;
+        if (stopping) {
+            return;
+        }
+        int client = pending.front();
+        pending.pop_front();
+        active.insert(client);
+        lock.unlock();
+
+        serveConnection(client, session);
+
+        lock.lock();
+        active.erase(client);
+        close(client);
+    }
+}
+
+void JobServer::joinFinishedHandlers() {
+    for (std::thread::id id : finished) {
+        auto handler = std::find_if(handlers.begin(), handlers.end(),
+                                    [id](const std::thread& thread) { return thread.get_id() == id; });
+        handler->join();
+        handlers.erase(handler);
+    }
+    finished.clear();
+}
+
+void JobServer::run() {
+    if (listener < 0) {
+        return;
+    }
+    JobStreamBuffer errors(std::cerr, true);
+    JobStreamBuffer messages(std::cout, false);
+
+    for (;;) {
+        pollfd events[2] = {{listener, POLLIN, 0}, {wakeRead, POLLIN, 0}};
+        if (poll(events, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: Waiting for connections failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (events[1].revents != 0) {
+            break;
+        }
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            continue;  // The client gave up, or a signal; EMFILE is retried once a connection closes
+        }
+        fcntl(client, F_SETFD, FD_CLOEXEC);
+        ignoreSigPipe(client);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        joinFinishedHandlers();
+        pending.push_back(client);
+        if (pending.size() > idle) {
+            handlers.emplace_back(&JobServer::handlerLoop, this);
+        } else {
+            wake.notify_one();
+        }
+    }
+
+    // No more connections. Waiting clients get no handler; connected ones see end of
+    // stream once they have read the answer to the job that is running.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (int client : pending) {
+            close(client);
+        }
+        pending.clear();
+        for (int client : active) {
+            shutdown(client, SHUT_RD);
+        }
+    }
+    wake.notify_all();
+    for (std::thread& handler : handlers) {
+        handler.join();
+    }
+    handlers.clear();
+    finished.clear();
+    unlink(socketPath.c_str());
+}
+
+int serveJobs(const std::string& socketPath, size_t warmThreads) {
+    JobServer server(warmThreads);
+    if (!server.listen(socketPath)) {
+        return 1;
+    }
+    std::cout << "Serving jobs on " << socketPath << " with " << (warmThreads == 0 ? 1 : warmThreads)
+              << " warm threads. Press Ctrl+C to stop." << std::endl;
+
+    signalledServer = &server;
+    struct sigaction action {};
+    action.sa_handler = stopOnSignal;
+    sigemptyset(&action.sa_mask);
+    struct sigaction previousInt {}, previousTerm {};
+    sigaction(SIGINT, &action, &previousInt);
+    sigaction(SIGTERM, &action, &previousTerm);
+    signal(SIGPIPE, SIG_IGN);  // A client that hangs up mid-reply is not fatal
+
+    server.run();
+
+    sigaction(SIGINT, &previousInt, nullptr);
+    sigaction(SIGTERM, &previousTerm, nullptr);
+    signalledServer = nullptr;
+    std::cout << "Server stopped." << std::endl;
+    return 0;
+}
+
+#else
+
+JobServer::JobServer(size_t warmThreads) : warmThreads(warmThreads) {}
+
+JobServer::~JobServer() = default;
+
+bool JobServer::listen(const std::string&) {
+    std::cerr << "Error: --serve needs Unix domain sockets, which this platform lacks." << std::endl;
+    return false;
+}
+
+void JobServer::run() {}
+
+void JobServer::stop() {}
+
+void JobServer::handlerLoop() {}
+
+void JobServer::joinFinishedHandlers() {}
+
+int serveJobs(const std::string& socketPath, size_t warmThreads) {
+    JobServer server(warmThreads);
+    return server.listen(socketPath) ? 0 : 1;
+}
+
+#endif
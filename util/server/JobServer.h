@@ -0,0 +1,84 @@
+#ifndef JOB_SERVER_H
+#define JOB_SERVER_H
+
+/**
+ * @file JobServer.h
+ * @brief encryption_tool --serve: a daemon that runs jobs sent over a Unix socket.
+ *
+ * Starting encryption_tool for every small job costs far more than the job: process
+ * start-up, the algorithm factory, parsing the key and building the round keys, all on
+ * cold caches. The server pays for that once. Its handler threads are started up front
+ * and each keeps a session: one instance of every algorithm, whose key cache holds the
+ * contexts of recently used keys, and input and output buffers that only ever grow. A
+ * connection is handed to an idle handler, which runs the connection's jobs itself, so
+ * a job is never passed between threads. When every handler is busy another one is
+ * started for the connection. A handler that finds `warmThreads` others already idle
+ * exits, freeing its session, so after a burst of connections the server shrinks back
+ * to its warm threads.
+ *
+ * Jobs are framed as in JobProtocol.h. A Memory job is encrypted or decrypted with
+ * encryptBuffer / decryptBuffer and the result sent back. File jobs (Paths, or
+ * Descriptors passed with SCM_RIGHTS and reopened through /dev/fd) run exactly like the
+ * command line, with the backend chosen for the file. What a job prints to std::cerr is
+ * captured and becomes the error message of its response; what it prints to std::cout
+ * is dropped. Output of other threads passes through.
+ *
+ * The socket is created with mode 0600, so only the server's user can connect.
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class JobServer {
+public:
+    // `warmThreads` handler threads are started by listen(), at least one
+    explicit JobServer(size_t warmThreads);
+    ~JobServer();
+
+    JobServer(const JobServer&) = delete;
+    JobServer& operator=(const JobServer&) = delete;
+
+    // Create the socket at `socketPath`, replacing a stale one left by a server that
+    // is gone. Returns false (after printing the error) if it cannot be created.
+    bool listen(const std::string& socketPath);
+
+    // Accept and serve connections until stop(). Jobs already running are finished and
+    // answered; the socket file is removed on the way out.
+    void run();
+
+    // Make run() return. Safe to call from a signal handler.
+    void stop();
+
+private:
+    void handlerLoop();
+
+    // Join the handlers that have exited; called with `mutex` held
+    void joinFinishedHandlers();
+
+    size_t warmThreads;
+    std::string socketPath;
+    int listener = -1;
+    int wakeRead = -1;   // stop() writes to wakeWrite to interrupt run()
+    int wakeWrite = -1;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<int> pending;   // Accepted connections waiting for a handler
+    std::set<int> active;      // Connections being served
+    size_t idle = 0;           // Handlers waiting for a connection
+    bool stopping = false;
+    std::vector<std::thread> handlers;
+    std::vector<std::thread::id> finished;  // Handlers that exited and await joining
+};
+
+// encryption_tool --serve: serve jobs on `socketPath` until SIGINT or SIGTERM. Returns
+// the exit status.
+int serveJobs(const std::string& socketPath, size_t warmThreads);
+
+#endif // JOB_SERVER_H
@@ -0,0 +1,100 @@
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+const uint64_t EVENTS[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+                           PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+int openCounter(uint64_t event) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = event;
+    attr.disabled = 1;
+    attr.inherit = 1;  // Follow the thread pools
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+// The counter's value, scaled up if it only ran for part of the time
+uint64_t readCounter(int fd) {
+    uint64_t values[3] = {};  // value, time enabled, time running
+    if (read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0) {
+        return 0;
+    }
+    if (values[2] < values[1]) {
+        return static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+    }
+    return values[0];
+}
+
+} // namespace
+
+PerfCounters::~PerfCounters() {
+    for (int& fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+bool PerfCounters::start() {
+    for (int i = 0; i < COUNTERS; ++i) {
+        fds[i] = openCounter(EVENTS[i]);
+        if (fds[i] < 0) {
+            error = std::string("perf_event_open failed: ") + std::strerror(errno);
+            return false;
+        }
+    }
+    for (int fd : fds) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    return true;
+}
+
+PerfReading PerfCounters::stop() {
+    PerfReading reading;
+    if (fds[COUNTERS - 1] < 0) {
+        reading.error = error;
+        return reading;
+    }
+    for (int fd : fds) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    reading.available = true;
+    reading.cycles = readCounter(fds[0]);
+    reading.instructions = readCounter(fds[1]);
+    reading.cacheReferences = readCounter(fds[2]);
+    reading.cacheMisses = readCounter(fds[3]);
+    reading.branchMisses = readCounter(fds[4]);
+    return reading;
+}
+
+#else
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::start() {
+    error = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+PerfReading PerfCounters::stop() {
+    PerfReading reading;
+    reading.error = error;
+    return reading;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+// Hardware counters over a job; `available` is false where they could not be opened,
+// with the reason in `error`
+struct PerfReading {
+    bool available = false;
+    std::string error;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cacheReferences = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t branchMisses = 0;
+};
+
+// Counts cycles, instructions, cache references and misses and branch misses of this
+// process between start() and stop() through perf_event_open (Linux only). Only user
+// space is counted, which unprivileged processes may do at the default
+// perf_event_paranoid level. Threads started after start() are counted too; their
+// counts reach the totals when they exit, so stop() belongs after the job's thread
+// pools are gone. If the kernel multiplexes the counters, the totals are scaled up to
+// the whole interval.
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Open and start the counters; false (with the reason kept for stop()) if the
+    // platform or the kernel does not allow it
+    bool start();
+
+    PerfReading stop();
+
+private:
+    static constexpr int COUNTERS = 5;
+    int fds[COUNTERS] = {-1, -1, -1, -1, -1};
+    std::string error;
+};
+
+#endif // PERF_COUNTERS_H
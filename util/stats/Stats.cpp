@@ -0,0 +1,193 @@
+#include "Stats.h"
+#include "../memory/BufferPool.h"
+#include <atomic>
+#include <cstdio>
+#include <ostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// One cache line per stage so threads timing different stages do not contend
+struct alignas(64) StageTotals {
+    std::atomic<uint64_t> nanoseconds{0};
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+StageTotals totals[static_cast<size_t>(Stage::Count)];
+std::atomic<uint64_t> blockCount{0};
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::KeySetup: return "key_setup";
+        case Stage::Read: return "read";
+        case Stage::Map: return "map";
+        case Stage::Compress: return "compress";
+        case Stage::Cipher: return "cipher";
+        case Stage::Checksum: return "checksum";
+        case Stage::Write: return "write";
+        case Stage::IOWait: return "io_wait";
+        case Stage::Count: break;
+    }
+    return "unknown";
+}
+
+double megabytesPerSecond(uint64_t bytes, uint64_t nanoseconds) {
+    return nanoseconds == 0 ? 0.0 : bytes * 1e3 / nanoseconds;
+}
+
+// Report strings are algorithm and mode names, but escape them anyway
+std::string quoted(const std::string& text) {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+} // namespace
+
+void Stats::enable() {
+    active = true;
+}
+
+void Stats::record(Stage stage, uint64_t nanoseconds, uint64_t bytes) {
+    StageTotals& entry = totals[static_cast<size_t>(stage)];
+    entry.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    entry.calls.fetch_add(1, std::memory_order_relaxed);
+    entry.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Stats::addBlocks(uint64_t blocks) {
+    if (active) {
+        blockCount.fetch_add(blocks, std::memory_order_relaxed);
+    }
+}
+
+StatsSnapshot Stats::snapshot() {
+    StatsSnapshot result;
+    for (size_t i = 0; i < static_cast<size_t>(Stage::Count); ++i) {
+        result.nanoseconds[i] = totals[i].nanoseconds.load(std::memory_order_relaxed);
+        result.calls[i] = totals[i].calls.load(std::memory_order_relaxed);
+        result.bytes[i] = totals[i].bytes.load(std::memory_order_relaxed);
+    }
+    result.blocks = blockCount.load(std::memory_order_relaxed);
+    result.buffers = BufferPool::counters();
+    return result;
+}
+
+void Stats::reset() {
+    for (StageTotals& entry : totals) {
+        entry.nanoseconds.store(0, std::memory_order_relaxed);
+        entry.calls.store(0, std::memory_order_relaxed);
+        entry.bytes.store(0, std::memory_order_relaxed);
+    }
+    blockCount.store(0, std::memory_order_relaxed);
+    BufferPool::resetCounters();
+}
+
+void Stats::merge(const StatsSnapshot& other) {
+    for (size_t i = 0; i < static_cast<size_t>(Stage::Count); ++i) {
+        totals[i].nanoseconds.fetch_add(other.nanoseconds[i], std::memory_order_relaxed);
+        totals[i].calls.fetch_add(other.calls[i], std::memory_order_relaxed);
+        totals[i].bytes.fetch_add(other.bytes[i], std::memory_order_relaxed);
+    }
+    blockCount.fetch_add(other.blocks, std::memory_order_relaxed);
+    BufferPool::mergeCounters(other.buffers);
+}
+
+uint64_t Stats::stageBytes(Stage stage) {
+    return totals[static_cast<size_t>(stage)].bytes.load(std::memory_order_relaxed);
+}
+
+uint64_t peakResidentBytes() {
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss);  // Bytes on macOS
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;  // Kilobytes elsewhere
+#endif
+#else
+    return 0;
+#endif
+}
+
+void writeStatsJson(std::ostream& output, const JobSummary& job) {
+    char line[512];
+    output << "{\n";
+    output << "  \"operation\": " << quoted(job.operation) << ",\n";
+    output << "  \"algorithm\": " << quoted(job.algorithm) << ",\n";
+    output << "  \"mode\": " << quoted(job.mode) << ",\n";
+    output << "  \"io\": " << quoted(job.io) << ",\n";
+    output << "  \"threads\": " << job.threads << ",\n";
+    output << "  \"processes\": " << job.processes << ",\n";
+    output << "  \"bytes_in\": " << job.bytesIn << ",\n";
+    output << "  \"bytes_out\": " << job.bytesOut << ",\n";
+    output << "  \"blocks\": " << blockCount.load() << ",\n";
+    output << "  \"wall_ns\": " << job.wallNanoseconds << ",\n";
+    std::snprintf(line, sizeof(line), "  \"mb_per_s\": %.1f,\n", megabytesPerSecond(job.bytesIn, job.wallNanoseconds));
+    output << line;
+    output << "  \"peak_rss_bytes\": " << peakResidentBytes() << ",\n";
+
+    output << "  \"stages\": {";
+    bool first = true;
+    for (size_t i = 0; i < static_cast<size_t>(Stage::Count); ++i) {
+        const StageTotals& entry = totals[i];
+        uint64_t calls = entry.calls.load();
+        if (calls == 0) {
+            continue;
+        }
+        uint64_t nanoseconds = entry.nanoseconds.load();
+        uint64_t bytes = entry.bytes.load();
+        std::snprintf(line, sizeof(line),
+                      "%s\n    \"%s\": {\"ns\": %llu, \"calls\": %llu, \"bytes\": %llu, \"mb_per_s\": %.1f}",
+                      first ? "" : ",", stageName(static_cast<Stage>(i)), static_cast<unsigned long long>(nanoseconds),
+                      static_cast<unsigned long long>(calls), static_cast<unsigned long long>(bytes),
+                      megabytesPerSecond(bytes, nanoseconds));
+        output << line;
+        first = false;
+    }
+    output << (first ? "}" : "\n  }");
+
+    BufferPoolCounters buffers = BufferPool::counters();
+    std::snprintf(line, sizeof(line),
+                  ",\n  \"buffers\": {\"requests\": %llu, \"reused\": %llu, \"allocations\": %llu, "
+                  "\"allocated_bytes\": %llu, \"huge_pages\": %llu, \"transparent_huge_pages\": %llu, "
+                  "\"page_faults_saved\": %llu}",
+                  static_cast<unsigned long long>(buffers.requests), static_cast<unsigned long long>(buffers.reused),
+                  static_cast<unsigned long long>(buffers.allocations),
+                  static_cast<unsigned long long>(buffers.allocatedBytes),
+                  static_cast<unsigned long long>(buffers.hugePageBuffers),
+                  static_cast<unsigned long long>(buffers.transparentHugeBuffers),
+                  static_cast<unsigned long long>(buffers.pageFaultsSaved));
+    output << line;
+
+    if (job.perfRequested) {
+        const PerfReading& perf = job.perf;
+        output << ",\n  \"perf\": ";
+        if (!perf.available) {
+            output << "{\"available\": false, \"error\": " << quoted(perf.error) << "}";
+        } else {
+            std::snprintf(line, sizeof(line),
+                          "{\"available\": true, \"cycles\": %llu, \"instructions\": %llu, \"ipc\": %.2f, "
+                          "\"cache_references\": %llu, \"cache_misses\": %llu, \"branch_misses\": %llu}",
+                          static_cast<unsigned long long>(perf.cycles), static_cast<unsigned long long>(perf.instructions),
+                          perf.cycles ? double(perf.instructions) / perf.cycles : 0.0,
+                          static_cast<unsigned long long>(perf.cacheReferences),
+                          static_cast<unsigned long long>(perf.cacheMisses),
+                          static_cast<unsigned long long>(perf.branchMisses));
+            output << line;
+        }
+    }
+    output << "\n}" << std::endl;
+}
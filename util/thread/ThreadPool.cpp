@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+namespace {
+
+// Pool and queue index of the worker running on this thread, if any
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t workerCount) {
+    for (size_t i = 0; i < workerCount; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::hardwareThreads() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    if (workers.empty()) {
+        task();
+        return;
+    }
+
+    size_t index = currentPool == this ? currentWorker : nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        ++queued;
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+// Run one task: the newest from our own deque, otherwise the oldest from another's
+bool ThreadPool::runPendingTask(size_t home) {
+    std::function<void()> task;
+    for (size_t k = 0; k < queues.size() && !task; ++k) {
+        WorkQueue& queue = *queues[(home + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (k == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    --queued;
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        if (runPendingTask(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (workers.empty() || count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    // Shared with the tasks so it outlives the last one to signal completion
+    struct Completion {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining;
+    };
+    auto completion = std::make_shared<Completion>();
+    completion->remaining = count;
+
+    for (size_t i = 0; i < count; ++i) {
+        submit([completion, &body, i] {
+            body(i);
+            std::lock_guard<std::mutex> lock(completion->mutex);
+            if (--completion->remaining == 0) {
+                completion->done.notify_all();
+            }
+        });
+    }
+
+    // Help out instead of just blocking
+    size_t home = currentPool == this ? currentWorker : 0;
+    while (runPendingTask(home)) {
+    }
+
+    std::unique_lock<std::mutex> lock(completion->mutex);
+    completion->done.wait(lock, [&completion] { return completion->remaining == 0; });
+}
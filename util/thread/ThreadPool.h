@@ -0,0 +1,60 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool.
+ *
+ * Every worker owns a task deque. Workers pop their own newest task first and, when
+ * they run dry, steal the oldest task from another worker's deque, so uneven tasks
+ * (e.g. a slow final chunk) do not leave the other cores idle. A thread that calls
+ * parallelFor helps run tasks until its loop is finished, so a pool with N workers
+ * keeps N + 1 threads busy.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t workerCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t workerCount() const { return workers.size(); }
+
+    // Queue a task; tasks submitted from a worker go to that worker's own deque
+    void submit(std::function<void()> task);
+
+    // Run body(0) ... body(count - 1) across the pool and wait for all of them
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // Number of hardware threads, at least 1
+    static size_t hardwareThreads();
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool runPendingTask(size_t home);
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> nextQueue{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_H